@@ -65,3 +65,15 @@ Filter::FilterDecision AndFilter::decide(
     return Filter::NEUTRAL;
 }
 
+bool AndFilter::requiresMDC() const
+{
+    FilterPtr f(headFilter);
+    while (f != NULL) {
+      if (f->requiresMDC()) {
+        return true;
+      }
+      f = f->getNext();
+    }
+    return false;
+}
+
@@ -20,6 +20,9 @@
 #include <log4cxx/spi/loggingevent.h>
 #include <algorithm>
 #include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/synchronized.h>
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
@@ -27,10 +30,34 @@ using namespace log4cxx::spi;
 
 IMPLEMENT_LOG4CXX_OBJECT(AppenderAttachableImpl)
 
+/**
+ *  Reference counted, immutable list of appenders.
+ */
+class AppenderAttachableImpl::AppenderListSnapshot {
+public:
+    AppenderListSnapshot(const AppenderList& list)
+        : appenders(list), ref(1) {
+    }
+
+    const AppenderList appenders;
+    volatile apr_uint32_t ref;
+
+private:
+    AppenderListSnapshot(const AppenderListSnapshot&);
+    AppenderListSnapshot& operator=(const AppenderListSnapshot&);
+};
+
 
 AppenderAttachableImpl::AppenderAttachableImpl(Pool& pool)
-   : appenderList(),
-     mutex(pool) {
+   : mutex(pool),
+     snapshot(new AppenderListSnapshot(AppenderList())),
+     epoch(0) {
+     readers[0] = 0;
+     readers[1] = 0;
+}
+
+AppenderAttachableImpl::~AppenderAttachableImpl() {
+    release(snapshot);
 }
 
 void AppenderAttachableImpl::addRef() const {
@@ -41,6 +68,44 @@ void AppenderAttachableImpl::releaseRef() const {
     ObjectImpl::releaseRef();
 }
 
+AppenderAttachableImpl::AppenderListSnapshot* AppenderAttachableImpl::acquire() const {
+    for(;;) {
+        apr_uint32_t current = apr_atomic_read32(&epoch);
+        apr_atomic_inc32(&readers[current]);
+        //
+        //   a reader registered in the current epoch is waited for
+        //   by the next publication before the list it sees is released.
+        if (apr_atomic_read32(&epoch) == current) {
+            AppenderListSnapshot* list = (AppenderListSnapshot*)
+                apr_atomic_casptr((volatile void**) &snapshot, 0, 0);
+            apr_atomic_inc32(&list->ref);
+            apr_atomic_dec32(&readers[current]);
+            return list;
+        }
+        apr_atomic_dec32(&readers[current]);
+    }
+}
+
+void AppenderAttachableImpl::release(AppenderListSnapshot* list) {
+    if (apr_atomic_dec32(&list->ref) == 0) {
+        delete list;
+    }
+}
+
+void AppenderAttachableImpl::publish(const AppenderList& appenders) {
+    AppenderListSnapshot* old = (AppenderListSnapshot*)
+        apr_atomic_xchgptr((volatile void**) &snapshot,
+            new AppenderListSnapshot(appenders));
+    //
+    //   readers arriving from now on see the new list,
+    //   wait for those which may still be taking a reference to the old one.
+    apr_uint32_t previous = apr_atomic_xchg32(&epoch, apr_atomic_read32(&epoch) ^ 1);
+    while (apr_atomic_read32(&readers[previous]) != 0) {
+        apr_thread_yield();
+    }
+    release(old);
+}
+
 
 void AppenderAttachableImpl::addAppender(const AppenderPtr& newAppender)
 {
@@ -50,12 +115,16 @@ void AppenderAttachableImpl::addAppender(const AppenderPtr& newAppender)
         return;
     }
 
-    AppenderList::iterator it = std::find(
+    synchronized sync(mutex);
+    const AppenderList& appenderList = snapshot->appenders;
+    AppenderList::const_iterator it = std::find(
         appenderList.begin(), appenderList.end(), newAppender);
 
     if (it == appenderList.end())
     {
-        appenderList.push_back(newAppender);
+        AppenderList appenders(appenderList);
+        appenders.push_back(newAppender);
+        publish(appenders);
     }
 }
 
@@ -63,17 +132,55 @@ int AppenderAttachableImpl::appendLoopOnAppenders(
     const spi::LoggingEventPtr& event,
     Pool& p)
 {
-    for (AppenderList::iterator it = appenderList.begin();
-         it != appenderList.end();
-         it++) {
-        (*it)->doAppend(event, p);
+    AppenderListSnapshot* list = acquire();
+    const AppenderList& appenderList = list->appenders;
+    try {
+        for (AppenderList::const_iterator it = appenderList.begin();
+             it != appenderList.end();
+             it++) {
+            (*it)->doAppend(event, p);
+        }
+    } catch(...) {
+        release(list);
+        throw;
+    }
+    int count = appenderList.size();
+    release(list);
+    return count;
+}
+
+int AppenderAttachableImpl::appendLoopOnAppenders(
+    const spi::LoggingEventList& events,
+    Pool& p)
+{
+    AppenderListSnapshot* list = acquire();
+    const AppenderList& appenderList = list->appenders;
+    try {
+        for (AppenderList::const_iterator it = appenderList.begin();
+             it != appenderList.end();
+             it++) {
+            (*it)->doAppendBatch(events, p);
+        }
+    } catch(...) {
+        release(list);
+        throw;
     }
-        return appenderList.size();
+    int count = appenderList.size();
+    release(list);
+    return count;
 }
 
 AppenderList AppenderAttachableImpl::getAllAppenders() const
 {
-    return appenderList;
+    AppenderListSnapshot* list = acquire();
+    AppenderList appenders(list->appenders);
+    release(list);
+    return appenders;
+}
+
+const AppenderList& AppenderAttachableImpl::getAppenderList() const
+{
+    return snapshot->appenders;
 }
 
 AppenderPtr AppenderAttachableImpl::getAppender(const LogString& name) const
@@ -83,6 +190,7 @@ AppenderPtr AppenderAttachableImpl::getAppender(const LogString& name) const
                 return 0;
         }
 
+        AppenderList appenderList(getAllAppenders());
         AppenderList::const_iterator it, itEnd = appenderList.end();
         AppenderPtr appender;
         for(it = appenderList.begin(); it != itEnd; it++)
@@ -104,6 +212,7 @@ bool AppenderAttachableImpl::isAttached(const AppenderPtr& appender) const
         return false;
     }
 
+    AppenderList appenderList(getAllAppenders());
     AppenderList::const_iterator it = std::find(
         appenderList.begin(), appenderList.end(), appender);
 
@@ -112,6 +221,10 @@ bool AppenderAttachableImpl::isAttached(const AppenderPtr& appender) const
 
 void AppenderAttachableImpl::removeAllAppenders()
 {
+    synchronized sync(mutex);
+    AppenderList appenderList(snapshot->appenders);
+    publish(AppenderList());
+
     AppenderList::iterator it, itEnd = appenderList.end();
     AppenderPtr a;
     for(it = appenderList.begin(); it != itEnd; it++)
@@ -119,8 +232,6 @@ void AppenderAttachableImpl::removeAllAppenders()
         a = *it;
         a->close();
     }
-
-    appenderList.clear();
 }
 
 void AppenderAttachableImpl::removeAppender(const AppenderPtr& appender)
@@ -128,12 +239,15 @@ void AppenderAttachableImpl::removeAppender(const AppenderPtr& appender)
     if (appender == 0)
         return;
 
+    synchronized sync(mutex);
+    AppenderList appenderList(snapshot->appenders);
     AppenderList::iterator it = std::find(
         appenderList.begin(), appenderList.end(), appender);
 
     if (it != appenderList.end())
     {
         appenderList.erase(it);
+        publish(appenderList);
     }
 }
 
@@ -144,6 +258,8 @@ void AppenderAttachableImpl::removeAppender(const LogString& name)
                 return;
         }
 
+        synchronized sync(mutex);
+        AppenderList appenderList(snapshot->appenders);
         AppenderList::iterator it, itEnd = appenderList.end();
         AppenderPtr appender;
         for(it = appenderList.begin(); it != itEnd; it++)
@@ -152,6 +268,7 @@ void AppenderAttachableImpl::removeAppender(const LogString& name)
                 if(name == appender->getName())
                 {
                         appenderList.erase(it);
+                        publish(appenderList);
                         return;
                 }
         }
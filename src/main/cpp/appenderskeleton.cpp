@@ -31,6 +31,19 @@ using namespace log4cxx::helpers;
 
 IMPLEMENT_LOG4CXX_OBJECT(AppenderSkeleton)
 
+namespace {
+    volatile apr_uint32_t configurationGeneration = 0;
+}
+
+void Appender::doAppendBatch(const spi::LoggingEventList& events, Pool& p)
+{
+        for(spi::LoggingEventList::const_iterator iter = events.begin();
+            iter != events.end();
+            iter++)
+        {
+                doAppend(*iter, p);
+        }
+}
 
 AppenderSkeleton::AppenderSkeleton()
 :   layout(),
@@ -92,12 +105,24 @@ void AppenderSkeleton::addFilter(const spi::FilterPtr& newFilter)
                 tailFilter->setNext(newFilter);
                 tailFilter = newFilter;
         }
+        configurationChanged();
 }
 
 void AppenderSkeleton::clearFilters()
 {
         synchronized sync(mutex);
         headFilter = tailFilter = 0;
+        configurationChanged();
+}
+
+unsigned int AppenderSkeleton::getConfigurationGeneration()
+{
+        return apr_atomic_read32(&configurationGeneration);
+}
+
+void AppenderSkeleton::configurationChanged()
+{
+        apr_atomic_inc32(&configurationGeneration);
 }
 
 bool AppenderSkeleton::isAsSevereAsThreshold(const LevelPtr& level) const
@@ -105,10 +130,52 @@ bool AppenderSkeleton::isAsSevereAsThreshold(const LevelPtr& level) const
         return ((level == 0) || level->isGreaterOrEqual(threshold));
 }
 
+bool AppenderSkeleton::requiresMDC() const
+{
+        if (!requiresLayout())
+        {
+                return true;
+        }
+        LayoutPtr l(layout);
+        if (l != 0 && l->requiresMDC())
+        {
+                return true;
+        }
+        for(FilterPtr f(headFilter); f != 0; f = f->getNext())
+        {
+                if (f->requiresMDC())
+                {
+                        return true;
+                }
+        }
+        return false;
+}
+
 void AppenderSkeleton::doAppend(const spi::LoggingEventPtr& event, Pool& pool1)
 {
         synchronized sync(mutex);
 
+        if(isAppendable(event))
+        {
+                append(event, pool1);
+        }
+}
+
+bool AppenderSkeleton::isAppendable(const spi::LoggingEventPtr& event) const
+{
+        if(closed)
+        {
+                LogLog::error(((LogString) LOG4CXX_STR("Attempted to append to closed appender named ["))
+                      + name + LOG4CXX_STR("]."));
+                return false;
+        }
+
+        return isAccepted(event);
+}
+
+void AppenderSkeleton::doAppendBatch(const spi::LoggingEventList& events, Pool& pool1)
+{
+        synchronized sync(mutex);
 
         if(closed)
         {
@@ -117,9 +184,39 @@ void AppenderSkeleton::doAppend(const spi::LoggingEventPtr& event, Pool& pool1)
                 return;
         }
 
+        spi::LoggingEventList accepted;
+        accepted.reserve(events.size());
+        for(spi::LoggingEventList::const_iterator iter = events.begin();
+            iter != events.end();
+            iter++)
+        {
+                if(isAccepted(*iter))
+                {
+                        accepted.push_back(*iter);
+                }
+        }
+
+        if(!accepted.empty())
+        {
+                appendBatch(accepted, pool1);
+        }
+}
+
+void AppenderSkeleton::appendBatch(const spi::LoggingEventList& events, Pool& p)
+{
+        for(spi::LoggingEventList::const_iterator iter = events.begin();
+            iter != events.end();
+            iter++)
+        {
+                append(*iter, p);
+        }
+}
+
+bool AppenderSkeleton::isAccepted(const spi::LoggingEventPtr& event) const
+{
         if(!isAsSevereAsThreshold(event->getLevel()))
         {
-                return;
+                return false;
         }
 
         FilterPtr f = headFilter;
@@ -130,16 +227,15 @@ void AppenderSkeleton::doAppend(const spi::LoggingEventPtr& event, Pool& pool1)
                  switch(f->decide(event))
                  {
                          case Filter::DENY:
-                                 return;
+                                 return false;
                          case Filter::ACCEPT:
-                                 f = 0;
-                                 break;
+                                 return true;
                          case Filter::NEUTRAL:
                                  f = f->getNext();
                  }
         }
 
-        append(event, pool1);
+        return true;
 }
 
 void AppenderSkeleton::setErrorHandler(const spi::ErrorHandlerPtr& errorHandler1)
@@ -31,7 +31,11 @@
 #include <log4cxx/helpers/synchronized.h>
 #include <log4cxx/helpers/stringhelper.h>
 #include <apr_atomic.h>
+#include <apr_time.h>
 #include <log4cxx/helpers/optionconverter.h>
+#include <log4cxx/level.h>
+#include <log4cxx/logger.h>
+#include <algorithm>
 
 
 using namespace log4cxx;
@@ -44,25 +48,165 @@ IMPLEMENT_LOG4CXX_OBJECT(AsyncAppender)
 
 AsyncAppender::AsyncAppender()
 : AppenderSkeleton(),
-  buffer(),
+  shardCount(0),
+  startedShards(0),
+  shardByThread(false),
+  waitStrategy(BLOCKING),
   bufferMutex(pool),
   bufferNotFull(pool),
-  bufferNotEmpty(pool),
+  blockedProducers(0),
+  discarding(0),
   discardMap(new DiscardMap()),
   bufferSize(DEFAULT_BUFFER_SIZE),
   appenders(new AppenderAttachableImpl(pool)),
-  dispatcher(),
   locationInfo(false),
-  blocking(true) {
-#if APR_HAS_THREADS
-  dispatcher.run(dispatch, this);
-#endif
+  overflowPolicy(BLOCK),
+  discardThreshold(Level::getWarn()),
+  spoolFile(),
+  stagingSize(0),
+  stagingLevel(Level::getError()),
+  stagingDelay(DEFAULT_STAGING_DELAY),
+  stagingLevelInt(Level::ERROR_INT),
+  stagingKey(0),
+  maxQueueDepth(0),
+  blockedTime(0),
+  discardCounts(),
+  metricsInterval(0),
+  metricsLogger(LOG4CXX_STR("log4cxx.AsyncAppender")),
+  threadSettings(LOG4CXX_STR("AsyncAppender")),
+  threadSettingsGeneration(0),
+  flushed(pool),
+  abandoning(0),
+  abandonedEvents(0),
+  captureMDC(0),
+  captureMDCGeneration(AppenderSkeleton::getConfigurationGeneration()) {
+  for(int i = 0; i < LATENCY_BUCKETS; i++) {
+      latencyHistogram[i] = 0;
+  }
+  synchronized sync(bufferMutex);
+  startShard();
+  apr_atomic_xchg32(&shardCount, 1);
 }
 
 AsyncAppender::~AsyncAppender()
 {
         finalize();
         delete discardMap;
+#if APR_HAS_THREADS
+        //  blocks of threads still running are deleted with their shard
+        if (stagingKey != 0) {
+            apr_threadkey_private_delete(stagingKey);
+        }
+#endif
+        for(int i = 0; i < startedShards; i++) {
+            delete shards[i];
+        }
+}
+
+AsyncAppender::Shard::Shard(AsyncAppender* appender1, int index1, int capacity, Pool& p)
+: appender(appender1),
+  index(index1),
+  buffer(new EventRingBuffer(capacity)),
+  retiredBuffers(),
+  retiredCount(0),
+  bufferNotEmpty(p),
+  dispatcherWaiting(0),
+  spooling(0),
+  spool(0),
+  stagingBlocks(),
+  stagingGeneration(0),
+  stagedBlocks(0),
+  flushRequested(0),
+  flushCompleted(0),
+  dispatcher() {
+}
+
+AsyncAppender::Shard::~Shard() {
+    delete spool;
+    delete buffer;
+    for(std::vector<EventRingBuffer*>::iterator iter = retiredBuffers.begin();
+        iter != retiredBuffers.end();
+        iter++) {
+        delete *iter;
+    }
+    for(std::vector<StagingBlock*>::iterator iter = stagingBlocks.begin();
+        iter != stagingBlocks.end();
+        iter++) {
+        delete *iter;
+    }
+}
+
+AsyncAppender::StagingBlock::StagingBlock()
+: events(), since(0), locked(0), abandoned(0) {
+}
+
+void AsyncAppender::StagingBlock::lock() {
+    while(apr_atomic_cas32(&locked, 1, 0) != 0) {
+#if APR_HAS_THREADS
+        apr_thread_yield();
+#endif
+    }
+}
+
+bool AsyncAppender::StagingBlock::tryLock() {
+    return apr_atomic_cas32(&locked, 1, 0) == 0;
+}
+
+void AsyncAppender::StagingBlock::unlock() {
+    apr_atomic_xchg32(&locked, 0);
+}
+
+struct AsyncAppender::StagingThread {
+    explicit StagingThread(bool dispatcher1) : dispatcher(dispatcher1) {
+        for(int i = 0; i < MAX_DISPATCHERS; i++) {
+            blocks[i] = 0;
+        }
+    }
+
+    /**
+     *  Dispatchers do not stage the events they log.
+     */
+    const bool dispatcher;
+    StagingBlock* blocks[MAX_DISPATCHERS];
+};
+
+void AsyncAppender::releaseStagingThread(void* data) {
+    StagingThread* thread = (StagingThread*) data;
+    //  the dispatcher deletes abandoned blocks once their events are collected
+    for(int i = 0; i < MAX_DISPATCHERS; i++) {
+        if (thread->blocks[i] != 0) {
+            apr_atomic_set32(&thread->blocks[i]->abandoned, 1);
+        }
+    }
+    delete thread;
+}
+
+void AsyncAppender::startShard() {
+    Shard* shard = new Shard(this, startedShards, bufferSize, pool);
+    shards[startedShards++] = shard;
+#if APR_HAS_THREADS
+    shard->dispatcher.run(dispatch, shard);
+#endif
+}
+
+AsyncAppender::Shard* AsyncAppender::getShard(const LoggingEventPtr& event) {
+    unsigned int count = apr_atomic_read32(&shardCount);
+    if (count == 1) {
+        return shards[0];
+    }
+    unsigned int hash = shardByThread ?
+        StringHelper::hashCode(event->getThreadName()) :
+        event->getLoggerNamePtr()->getHashCode();
+    return shards[hash % count];
+}
+
+bool AsyncAppender::isDispatcherThread() const {
+    for(int i = 0; i < startedShards; i++) {
+        if (shards[i]->dispatcher.isCurrentThread()) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void AsyncAppender::addRef() const {
@@ -77,6 +221,7 @@ void AsyncAppender::addAppender(const AppenderPtr& newAppender)
 {
         synchronized sync(appenders->getMutex());
         appenders->addAppender(newAppender);
+        updateCaptureMDC();
 }
 
 
@@ -90,19 +235,104 @@ void AsyncAppender::setOption(const LogString& option,
         }
         if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("BLOCKING"), LOG4CXX_STR("blocking"))) {
              setBlocking(OptionConverter::toBoolean(value, true));
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("OVERFLOWPOLICY"), LOG4CXX_STR("overflowpolicy"))) {
+             if (StringHelper::equalsIgnoreCase(value, LOG4CXX_STR("BLOCK"), LOG4CXX_STR("block"))) {
+                 setOverflowPolicy(BLOCK);
+             } else if (StringHelper::equalsIgnoreCase(value, LOG4CXX_STR("DISCARD"), LOG4CXX_STR("discard"))) {
+                 setOverflowPolicy(DISCARD);
+             } else if (StringHelper::equalsIgnoreCase(value, LOG4CXX_STR("DROPOLDEST"), LOG4CXX_STR("dropoldest"))) {
+                 setOverflowPolicy(DROP_OLDEST);
+             } else if (StringHelper::equalsIgnoreCase(value,
+                    LOG4CXX_STR("DISCARDBELOWTHRESHOLD"), LOG4CXX_STR("discardbelowthreshold"))) {
+                 setOverflowPolicy(DISCARD_BELOW_THRESHOLD);
+             } else if (StringHelper::equalsIgnoreCase(value, LOG4CXX_STR("SPOOL"), LOG4CXX_STR("spool"))) {
+                 setOverflowPolicy(SPOOL);
+             } else {
+                 LogLog::warn(LOG4CXX_STR("Unknown overflow policy: ") + value);
+             }
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("DISCARDTHRESHOLD"), LOG4CXX_STR("discardthreshold"))) {
+             setDiscardThreshold(OptionConverter::toLevel(value, Level::getWarn()));
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("SPOOLFILE"), LOG4CXX_STR("spoolfile"))) {
+             setSpoolFile(value);
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("DISPATCHERCOUNT"), LOG4CXX_STR("dispatchercount"))) {
+             setDispatcherCount(OptionConverter::toInt(value, 1));
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("SHARDBY"), LOG4CXX_STR("shardby"))) {
+             setShardByThread(StringHelper::equalsIgnoreCase(value, LOG4CXX_STR("THREAD"), LOG4CXX_STR("thread")));
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("WAITSTRATEGY"), LOG4CXX_STR("waitstrategy"))) {
+             if (StringHelper::equalsIgnoreCase(value, LOG4CXX_STR("BLOCKING"), LOG4CXX_STR("blocking"))) {
+                 setWaitStrategy(BLOCKING);
+             } else if (StringHelper::equalsIgnoreCase(value, LOG4CXX_STR("SPINTHENPARK"), LOG4CXX_STR("spinthenpark"))) {
+                 setWaitStrategy(SPIN_THEN_PARK);
+             } else if (StringHelper::equalsIgnoreCase(value, LOG4CXX_STR("BUSYSPIN"), LOG4CXX_STR("busyspin"))) {
+                 setWaitStrategy(BUSY_SPIN);
+             } else {
+                 LogLog::warn(LOG4CXX_STR("Unknown wait strategy: ") + value);
+             }
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("STAGINGSIZE"), LOG4CXX_STR("stagingsize"))) {
+             setStagingSize(OptionConverter::toInt(value, 0));
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("STAGINGLEVEL"), LOG4CXX_STR("staginglevel"))) {
+             setStagingLevel(OptionConverter::toLevel(value, Level::getError()));
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("STAGINGDELAY"), LOG4CXX_STR("stagingdelay"))) {
+             setStagingDelay(OptionConverter::toInt(value, DEFAULT_STAGING_DELAY));
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("METRICSINTERVAL"), LOG4CXX_STR("metricsinterval"))) {
+             setMetricsInterval(OptionConverter::toInt(value, 0));
+        } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("METRICSLOGGER"), LOG4CXX_STR("metricslogger"))) {
+             setMetricsLogger(value);
         } else {
-             AppenderSkeleton::setOption(option, value);
+             helpers::ThreadSettings settings(getThreadSettings());
+             if (settings.setOption(option, value)) {
+                 setThreadSettings(settings);
+             } else {
+                 AppenderSkeleton::setOption(option, value);
+             }
         }
 }
 
 
+void AsyncAppender::doAppend(const spi::LoggingEventPtr& event, Pool& pool1)
+{
+        if(closed)
+        {
+                LogLog::error(((LogString) LOG4CXX_STR("Attempted to append to closed appender named ["))
+                      + name + LOG4CXX_STR("]."));
+                return;
+        }
+
+        if(!isAsSevereAsThreshold(event->getLevel()))
+        {
+                return;
+        }
+
+        if (headFilter != 0)
+        {
+                synchronized sync(mutex);
+                FilterPtr f = headFilter;
+                while(f != 0)
+                {
+                         switch(f->decide(event))
+                         {
+                                 case Filter::DENY:
+                                         return;
+                                 case Filter::ACCEPT:
+                                         f = 0;
+                                         break;
+                                 case Filter::NEUTRAL:
+                                         f = f->getNext();
+                         }
+                }
+        }
+
+        append(event, pool1);
+}
+
 void AsyncAppender::append(const spi::LoggingEventPtr& event, Pool& p) {
 #if APR_HAS_THREADS
        //
         //   if dispatcher has died then
         //      append subsequent events synchronously
         //
-        if (!dispatcher.isAlive() || bufferSize <= 0) {
+        Shard* shard = getShard(event);
+        if (!shard->dispatcher.isAlive() || bufferSize <= 0) {
             synchronized sync(appenders->getMutex());
             appenders->appendLoopOnAppenders(event, p);
             return;
@@ -113,61 +343,29 @@ void AsyncAppender::append(const spi::LoggingEventPtr& event, Pool& p) {
         LogString ndcVal;
         event->getNDC(ndcVal);
         event->getThreadName();
-        // Get a copy of this thread's MDC.
-        event->getMDCCopy();
+        // Get a copy of this thread's MDC, unless no appender reads it.
+        if (isCapturingMDC()) {
+            event->getMDCCopy();
+        }
 
+        if (stagingSize > 0) {
+            StagingBlock* block = getStagingBlock(shard);
+            if (block != 0) {
+                stage(shard, block, event);
+                return;
+            }
+        }
 
-        {
-             synchronized sync(bufferMutex);
-             while(true) {
-                 int previousSize = buffer.size();
-                 if (previousSize < bufferSize) {
-                     buffer.push_back(event);
-                     if (previousSize == 0) {
-                        bufferNotEmpty.signalAll();
-                     }
-                     break;
-                 }
-             
-                //
-                //   Following code is only reachable if buffer is full
-                //
-                //
-                //   if blocking and thread is not already interrupted
-                //      and not the dispatcher then
-                //      wait for a buffer notification
-                bool discard = true;
-                if (blocking
-                    && !Thread::interrupted()
-                    && !dispatcher.isCurrentThread()) {
-                    try {
-                        bufferNotFull.await(bufferMutex);
-                        discard = false;
-                    } catch (InterruptedException& e) {
-                        //
-                        //  reset interrupt status so
-                        //    calling code can see interrupt on
-                        //    their next wait or sleep.
-                        Thread::currentThreadInterrupt();
-                    }
-                }
+        enqueue(shard, event);
 
-                //
-                //   if blocking is false or thread has been interrupted
-                //   add event to discard map.
-                //
-                if (discard) {
-                    LogString loggerName = event->getLoggerName();
-                    DiscardMap::iterator iter = discardMap->find(loggerName);
-                    if (iter == discardMap->end()) {
-                        DiscardSummary summary(event);
-                        discardMap->insert(DiscardMap::value_type(loggerName, summary));
-                    } else {
-                        (*iter).second.add(event);
-                    }
-                    break;
-                }
-            }
+        //
+        //   the enqueue position was advanced by compare-and-swap before
+        //   this read, the dispatcher sets dispatcherWaiting before checking
+        //   the buffer, so either it sees the event or it is woken here.
+        //
+        if (apr_atomic_read32(&shard->dispatcherWaiting) != 0) {
+            synchronized sync(bufferMutex);
+            shard->bufferNotEmpty.signalAll();
         }
 #else
         synchronized sync(appenders->getMutex());
@@ -180,16 +378,21 @@ void AsyncAppender::close() {
     {
         synchronized sync(bufferMutex);
         closed = true;
-        bufferNotEmpty.signalAll();
+        for(int i = 0; i < startedShards; i++) {
+            shards[i]->bufferNotEmpty.signalAll();
+        }
         bufferNotFull.signalAll();
     }
     
 #if APR_HAS_THREADS
-    try {
-        dispatcher.join();
-   } catch(InterruptedException& e) {
-        Thread::currentThreadInterrupt();
-        LogLog::error(LOG4CXX_STR("Got an InterruptedException while waiting for the dispatcher to finish,"), e);
+    //  shards are only started while open
+    for(int i = 0; i < startedShards; i++) {
+        try {
+            shards[i]->dispatcher.join();
+        } catch(InterruptedException& e) {
+            Thread::currentThreadInterrupt();
+            LogLog::error(LOG4CXX_STR("Got an InterruptedException while waiting for the dispatcher to finish,"), e);
+        }
     }
 #endif
     
@@ -204,6 +407,59 @@ void AsyncAppender::close() {
     }
 }
 
+bool AsyncAppender::flush(int timeout) {
+#if APR_HAS_THREADS
+    //  a dispatcher would wait for itself
+    if (isDispatcherThread()) {
+        return false;
+    }
+    log4cxx_time_t deadline = apr_time_now() + (log4cxx_time_t) timeout * 1000;
+    synchronized sync(bufferMutex);
+    int count = startedShards;
+    unsigned int requested[MAX_DISPATCHERS];
+    for(int i = 0; i < count; i++) {
+        requested[i] = apr_atomic_inc32(&shards[i]->flushRequested) + 1;
+        shards[i]->bufferNotEmpty.signalAll();
+    }
+    try {
+        for(int i = 0; i < count; i++) {
+            Shard* shard = shards[i];
+            while((int) (apr_atomic_read32(&shard->flushCompleted) - requested[i]) < 0
+                && shard->dispatcher.isAlive()) {
+                log4cxx_time_t remaining = deadline - apr_time_now();
+                if (remaining <= 0) {
+                    return false;
+                }
+                flushed.await(bufferMutex, remaining);
+            }
+        }
+    } catch(InterruptedException& e) {
+        Thread::currentThreadInterrupt();
+        return false;
+    }
+#endif
+    return true;
+}
+
+bool AsyncAppender::close(int timeout) {
+    bool complete = flush(timeout);
+    if (!complete) {
+        apr_atomic_set32(&abandoning, 1);
+    }
+    close();
+    unsigned int count = apr_atomic_read32(&abandonedEvents);
+    if (count > 0) {
+        Pool p;
+        LogString msg(LOG4CXX_STR("Discarded "));
+        StringHelper::toString((int) count, p, msg);
+        msg.append(LOG4CXX_STR(" buffered events of AsyncAppender named ["));
+        msg.append(name);
+        msg.append(LOG4CXX_STR("] at the close deadline."));
+        LogLog::warn(msg);
+    }
+    return count == 0;
+}
+
 AppenderList AsyncAppender::getAllAppenders() const
 {
         synchronized sync(appenders->getMutex());
@@ -226,22 +482,53 @@ bool AsyncAppender::requiresLayout() const {
     return false;
 }
 
+bool AsyncAppender::requiresMDC() const {
+    return isCapturingMDC();
+}
+
+bool AsyncAppender::isCapturingMDC() const {
+    if (apr_atomic_read32(&captureMDCGeneration) != AppenderSkeleton::getConfigurationGeneration()) {
+        synchronized sync(appenders->getMutex());
+        updateCaptureMDC();
+    }
+    return apr_atomic_read32(&captureMDC) != 0;
+}
+
+void AsyncAppender::updateCaptureMDC() const {
+    //  read first, a change while examining leaves the result stale
+    apr_uint32_t generation = AppenderSkeleton::getConfigurationGeneration();
+    bool required = false;
+    AppenderList list(appenders->getAllAppenders());
+    for(AppenderList::const_iterator iter = list.begin();
+        iter != list.end() && !required;
+        iter++) {
+        //  appenders that do not tell are assumed to read the MDC
+        AppenderSkeletonPtr skeleton(*iter);
+        required = skeleton == 0 || skeleton->requiresMDC();
+    }
+    apr_atomic_set32(&captureMDC, required ? 1 : 0);
+    apr_atomic_set32(&captureMDCGeneration, generation);
+}
+
 void AsyncAppender::removeAllAppenders()
 {
     synchronized sync(appenders->getMutex());
     appenders->removeAllAppenders();
+    updateCaptureMDC();
 }
 
 void AsyncAppender::removeAppender(const AppenderPtr& appender)
 {
     synchronized sync(appenders->getMutex());
     appenders->removeAppender(appender);
+    updateCaptureMDC();
 }
 
 void AsyncAppender::removeAppender(const LogString& n)
 {
     synchronized sync(appenders->getMutex());
     appenders->removeAppender(n);
+    updateCaptureMDC();
 }
 
 bool AsyncAppender::getLocationInfo() const {
@@ -260,6 +547,15 @@ void AsyncAppender::setBufferSize(int size)
     }
     synchronized sync(bufferMutex);
     bufferSize = (size < 1) ? 1 : size;
+    for(int i = 0; i < startedShards; i++) {
+        Shard* shard = shards[i];
+        EventRingBuffer* current = shard->buffer;
+        if (current->getCapacity() < bufferSize || current->getCapacity() / 2 >= bufferSize) {
+            shard->retiredBuffers.push_back(current);
+            apr_atomic_xchgptr((volatile void**) &shard->buffer, new EventRingBuffer(bufferSize));
+            apr_atomic_inc32(&shard->retiredCount);
+        }
+    }
     bufferNotFull.signalAll();
 }
 
@@ -269,13 +565,583 @@ int AsyncAppender::getBufferSize() const
 }
 
 void AsyncAppender::setBlocking(bool value) {
+    setOverflowPolicy(value ? BLOCK : DISCARD);
+}
+
+bool AsyncAppender::getBlocking() const {
+    return overflowPolicy == BLOCK;
+}
+
+void AsyncAppender::setOverflowPolicy(OverflowPolicy policy) {
     synchronized sync(bufferMutex);
-    blocking = value;
+    overflowPolicy = policy;
     bufferNotFull.signalAll();
 }
 
-bool AsyncAppender::getBlocking() const {
-    return blocking;
+AsyncAppender::OverflowPolicy AsyncAppender::getOverflowPolicy() const {
+    return overflowPolicy;
+}
+
+void AsyncAppender::setDiscardThreshold(const LevelPtr& level) {
+    synchronized sync(bufferMutex);
+    discardThreshold = level;
+    bufferNotFull.signalAll();
+}
+
+LevelPtr AsyncAppender::getDiscardThreshold() const {
+    synchronized sync(bufferMutex);
+    return discardThreshold;
+}
+
+void AsyncAppender::setSpoolFile(const LogString& file) {
+    synchronized sync(bufferMutex);
+    spoolFile = file;
+    //  a spool still holding events keeps its file until it is read
+    for(int i = 0; i < startedShards; i++) {
+        Shard* shard = shards[i];
+        if (shard->spool != 0 && shard->spool->isEmpty()) {
+            delete shard->spool;
+            shard->spool = 0;
+        }
+    }
+}
+
+LogString AsyncAppender::getSpoolFile() const {
+    synchronized sync(bufferMutex);
+    return spoolFile;
+}
+
+void AsyncAppender::setDispatcherCount(int count) {
+    if (count < 1 || count > MAX_DISPATCHERS) {
+          throw IllegalArgumentException(LOG4CXX_STR("count argument must be between 1 and 64"));
+    }
+    synchronized sync(bufferMutex);
+    if (closed) {
+        return;
+    }
+    while (startedShards < count) {
+        startShard();
+    }
+    //
+    //   shards are published before the count, shards beyond
+    //   the count still dispatch the events they hold.
+    apr_atomic_xchg32(&shardCount, count);
+}
+
+int AsyncAppender::getDispatcherCount() const {
+    return (int) shardCount;
+}
+
+void AsyncAppender::setShardByThread(bool value) {
+    shardByThread = value;
+}
+
+bool AsyncAppender::getShardByThread() const {
+    return shardByThread;
+}
+
+void AsyncAppender::setWaitStrategy(WaitStrategy strategy) {
+    synchronized sync(bufferMutex);
+    waitStrategy = strategy;
+    //  parked dispatchers start spinning
+    for(int i = 0; i < startedShards; i++) {
+        shards[i]->bufferNotEmpty.signalAll();
+    }
+}
+
+AsyncAppender::WaitStrategy AsyncAppender::getWaitStrategy() const {
+    return waitStrategy;
+}
+
+void AsyncAppender::setStagingSize(int size) {
+    if (size < 0) {
+          throw IllegalArgumentException(LOG4CXX_STR("size argument must be non-negative"));
+    }
+    synchronized sync(bufferMutex);
+#if APR_HAS_THREADS
+    if (size > 0 && stagingKey == 0) {
+        apr_status_t stat = apr_threadkey_private_create(&stagingKey,
+            releaseStagingThread, pool.getAPRPool());
+        if (stat != APR_SUCCESS) {
+            throw RuntimeException(stat);
+        }
+    }
+#endif
+    stagingSize = size;
+}
+
+int AsyncAppender::getStagingSize() const {
+    return stagingSize;
+}
+
+void AsyncAppender::setStagingLevel(const LevelPtr& level) {
+    synchronized sync(bufferMutex);
+    stagingLevel = level;
+    stagingLevelInt = level->toInt();
+}
+
+LevelPtr AsyncAppender::getStagingLevel() const {
+    synchronized sync(bufferMutex);
+    return stagingLevel;
+}
+
+void AsyncAppender::setStagingDelay(int delay) {
+    if (delay < 1) {
+          throw IllegalArgumentException(LOG4CXX_STR("delay argument must be positive"));
+    }
+    stagingDelay = delay;
+}
+
+int AsyncAppender::getStagingDelay() const {
+    return stagingDelay;
+}
+
+int AsyncAppender::getQueueDepth() const {
+    synchronized sync(bufferMutex);
+    int depth = 0;
+    for(int i = 0; i < startedShards; i++) {
+        const Shard* shard = shards[i];
+        depth += shard->buffer->size();
+        for(std::vector<EventRingBuffer*>::const_iterator iter = shard->retiredBuffers.begin();
+            iter != shard->retiredBuffers.end();
+            iter++) {
+            depth += (*iter)->size();
+        }
+    }
+    return depth;
+}
+
+int AsyncAppender::getMaxQueueDepth() const {
+    return (int) apr_atomic_read32(&maxQueueDepth);
+}
+
+std::vector<unsigned int> AsyncAppender::getLatencyHistogram() const {
+    std::vector<unsigned int> histogram(LATENCY_BUCKETS);
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        histogram[i] = apr_atomic_read32(&latencyHistogram[i]);
+    }
+    return histogram;
+}
+
+log4cxx_time_t AsyncAppender::getBlockedTime() const {
+    synchronized sync(bufferMutex);
+    return blockedTime;
+}
+
+AsyncAppender::DiscardCountMap AsyncAppender::getDiscardCounts() const {
+    synchronized sync(bufferMutex);
+    return discardCounts;
+}
+
+void AsyncAppender::resetMetrics() {
+    synchronized sync(bufferMutex);
+    apr_atomic_set32(&maxQueueDepth, 0);
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        apr_atomic_set32(&latencyHistogram[i], 0);
+    }
+    blockedTime = 0;
+    discardCounts.clear();
+}
+
+void AsyncAppender::setMetricsInterval(int interval) {
+    if (interval < 0) {
+          throw IllegalArgumentException(LOG4CXX_STR("interval argument must be non-negative"));
+    }
+    synchronized sync(bufferMutex);
+    metricsInterval = interval;
+    //  the first dispatcher adjusts its wait
+    shards[0]->bufferNotEmpty.signalAll();
+}
+
+int AsyncAppender::getMetricsInterval() const {
+    return metricsInterval;
+}
+
+void AsyncAppender::setMetricsLogger(const LogString& name) {
+    synchronized sync(bufferMutex);
+    metricsLogger = name;
+}
+
+LogString AsyncAppender::getMetricsLogger() const {
+    synchronized sync(bufferMutex);
+    return metricsLogger;
+}
+
+void AsyncAppender::setThreadSettings(const helpers::ThreadSettings& settings) {
+    synchronized sync(bufferMutex);
+    threadSettings = settings;
+    apr_atomic_inc32(&threadSettingsGeneration);
+    //  parked dispatchers wake up to apply the settings
+    for(int i = 0; i < startedShards; i++) {
+        shards[i]->bufferNotEmpty.signalAll();
+    }
+}
+
+helpers::ThreadSettings AsyncAppender::getThreadSettings() const {
+    synchronized sync(bufferMutex);
+    return threadSettings;
+}
+
+void AsyncAppender::applyThreadSettings(Shard* shard, unsigned int& generation) {
+    helpers::ThreadSettings settings;
+    {
+        synchronized sync(bufferMutex);
+        settings = threadSettings;
+        generation = apr_atomic_read32(&threadSettingsGeneration);
+    }
+    LogString suffix;
+    if (shard->index > 0) {
+        Pool p;
+        suffix.append(1, LOG4CXX_STR('-'));
+        StringHelper::toString(shard->index, p, suffix);
+    }
+    settings.apply(suffix);
+}
+
+void AsyncAppender::updateMetrics(int depth, const LoggingEventList& events) {
+    unsigned int max = apr_atomic_read32(&maxQueueDepth);
+    while((unsigned int) depth > max) {
+        unsigned int previous = apr_atomic_cas32(&maxQueueDepth, depth, max);
+        if (previous == max) {
+            break;
+        }
+        max = previous;
+    }
+
+    //
+    //   count locally so that dispatchers update each bucket once per batch
+    //
+    unsigned int counts[LATENCY_BUCKETS];
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        counts[i] = 0;
+    }
+    log4cxx_time_t now = apr_time_now();
+    for(LoggingEventList::const_iterator iter = events.begin();
+        iter != events.end();
+        iter++) {
+        log4cxx_time_t latency = now - (*iter)->getTimeStamp();
+        int bucket = 0;
+        while(bucket < LATENCY_BUCKETS - 1 && latency >= ((log4cxx_time_t) 1 << bucket)) {
+            bucket++;
+        }
+        counts[bucket]++;
+    }
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        if (counts[i] != 0) {
+            apr_atomic_add32(&latencyHistogram[i], counts[i]);
+        }
+    }
+}
+
+void AsyncAppender::logMetrics(Pool& p) {
+    LogString msg(LOG4CXX_STR("Queue depth "));
+    StringHelper::toString(getQueueDepth(), p, msg);
+    msg.append(LOG4CXX_STR(", max "));
+    StringHelper::toString(getMaxQueueDepth(), p, msg);
+    msg.append(LOG4CXX_STR(", blocked "));
+    StringHelper::toString(getBlockedTime(), p, msg);
+    msg.append(LOG4CXX_STR(" us, discarded"));
+    DiscardCountMap counts(getDiscardCounts());
+    if (counts.empty()) {
+        msg.append(LOG4CXX_STR(" 0"));
+    }
+    for(DiscardCountMap::const_iterator iter = counts.begin();
+        iter != counts.end();
+        iter++) {
+        msg.append(1, (logchar) 0x20 /* ' ' */);
+        msg.append(iter->first);
+        msg.append(1, (logchar) 0x3D /* '=' */);
+        StringHelper::toString((int) iter->second, p, msg);
+    }
+    msg.append(LOG4CXX_STR(", latency"));
+    std::vector<unsigned int> histogram(getLatencyHistogram());
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        if (histogram[i] != 0) {
+            msg.append(LOG4CXX_STR(" <"));
+            if (i < LATENCY_BUCKETS - 1) {
+                StringHelper::toString((log4cxx_time_t) 1 << i, p, msg);
+            } else {
+                msg.append(LOG4CXX_STR("inf"));
+            }
+            msg.append(LOG4CXX_STR("us:"));
+            StringHelper::toString((int) histogram[i], p, msg);
+        }
+    }
+    LoggerPtr logger(Logger::getLoggerLS(getMetricsLogger()));
+    LOG4CXX_INFO(logger, msg);
+}
+
+AsyncAppender::StagingBlock* AsyncAppender::getStagingBlock(Shard* shard) {
+#if APR_HAS_THREADS
+    void* data = 0;
+    apr_threadkey_private_get(&data, stagingKey);
+    StagingThread* thread = (StagingThread*) data;
+    if (thread == 0) {
+        thread = new StagingThread(isDispatcherThread());
+        if (apr_threadkey_private_set(thread, stagingKey) != APR_SUCCESS) {
+            delete thread;
+            return 0;
+        }
+    }
+    if (thread->dispatcher) {
+        return 0;
+    }
+    StagingBlock* block = thread->blocks[shard->index];
+    if (block == 0) {
+        synchronized sync(bufferMutex);
+        if (closed) {
+            return 0;
+        }
+        block = new StagingBlock();
+        shard->stagingBlocks.push_back(block);
+        apr_atomic_inc32(&shard->stagingGeneration);
+        thread->blocks[shard->index] = block;
+    }
+    return block;
+#else
+    return 0;
+#endif
+}
+
+void AsyncAppender::stage(Shard* shard, StagingBlock* block, const LoggingEventPtr& event) {
+    block->lock();
+    bool wasEmpty = block->events.empty();
+    if (wasEmpty) {
+        block->since = apr_time_now();
+        apr_atomic_inc32(&shard->stagedBlocks);
+    }
+    block->events.push_back(event);
+    bool handedOff = false;
+    if ((int) block->events.size() >= stagingSize
+        || event->getLevel()->toInt() >= stagingLevelInt) {
+        handOff(shard, block);
+        handedOff = true;
+    }
+    block->unlock();
+
+    //
+    //   stagedBlocks was incremented before this read, a parked
+    //   dispatcher only waits with a timeout while blocks hold events.
+    //
+    if ((wasEmpty || handedOff) && apr_atomic_read32(&shard->dispatcherWaiting) != 0) {
+        synchronized sync(bufferMutex);
+        shard->bufferNotEmpty.signalAll();
+    }
+}
+
+void AsyncAppender::handOff(Shard* shard, StagingBlock* block) {
+    //
+    //   the block stays locked while waiting for space so that
+    //   the dispatcher cannot collect later events first.
+    //
+    for(LoggingEventList::iterator iter = block->events.begin();
+        iter != block->events.end();
+        iter++) {
+        enqueue(shard, *iter);
+    }
+    block->events.clear();
+    apr_atomic_dec32(&shard->stagedBlocks);
+}
+
+bool AsyncAppender::collectStaged(Shard* shard,
+    std::vector<StagingBlock*>& blocks,
+    unsigned int& generation,
+    bool force,
+    LoggingEventList& events) {
+    if (apr_atomic_read32(&shard->stagingGeneration) != generation) {
+        synchronized sync(bufferMutex);
+        blocks = shard->stagingBlocks;
+        generation = apr_atomic_read32(&shard->stagingGeneration);
+    }
+    log4cxx_time_t expired = apr_time_now() - (log4cxx_time_t) stagingDelay * 1000;
+    std::vector<StagingBlock*> abandoned;
+    bool collected = true;
+    for(std::vector<StagingBlock*>::iterator iter = blocks.begin();
+        iter != blocks.end();
+        iter++) {
+        StagingBlock* block = *iter;
+        //  a locked block is being handed off by its producer
+        if (!block->tryLock()) {
+            collected = false;
+            continue;
+        }
+        if (!block->events.empty() && (force || block->since <= expired)) {
+            for(LoggingEventList::iterator eventIter = block->events.begin();
+                eventIter != block->events.end();
+                eventIter++) {
+                while(true) {
+                    if (apr_atomic_read32(&shard->spooling) != 0) {
+                        synchronized sync(bufferMutex);
+                        if (!shard->spool->write(*eventIter)) {
+                            discard(*eventIter);
+                        }
+                        break;
+                    }
+                    if (shard->buffer->offer(*eventIter)) {
+                        break;
+                    }
+                    //  the dispatcher makes room itself
+                    shard->buffer->drain(events);
+                }
+            }
+            block->events.clear();
+            apr_atomic_dec32(&shard->stagedBlocks);
+        }
+        if (block->events.empty() && apr_atomic_read32(&block->abandoned) != 0) {
+            abandoned.push_back(block);
+        }
+        block->unlock();
+    }
+
+    if (!abandoned.empty()) {
+        synchronized sync(bufferMutex);
+        for(std::vector<StagingBlock*>::iterator iter = abandoned.begin();
+            iter != abandoned.end();
+            iter++) {
+            shard->stagingBlocks.erase(std::find(shard->stagingBlocks.begin(),
+                shard->stagingBlocks.end(), *iter));
+            delete *iter;
+        }
+        apr_atomic_inc32(&shard->stagingGeneration);
+        blocks = shard->stagingBlocks;
+        generation = apr_atomic_read32(&shard->stagingGeneration);
+    }
+    return collected;
+}
+
+void AsyncAppender::enqueue(Shard* shard, const LoggingEventPtr& event) {
+    if (apr_atomic_read32(&shard->spooling) == 0
+        && (shard->buffer->offer(event) || spinOffer(shard, event))) {
+        return;
+    }
+    synchronized sync(bufferMutex);
+    //  announce the wait before retrying, the dispatcher checks
+    //  blockedProducers after freeing slots
+    apr_atomic_inc32(&blockedProducers);
+    overflow(shard, event);
+    apr_atomic_dec32(&blockedProducers);
+}
+
+bool AsyncAppender::spinOffer(Shard* shard, const LoggingEventPtr& event) {
+    //  only replaces the waits of the Block policy, dispatchers never wait
+    if (waitStrategy == BLOCKING || overflowPolicy != BLOCK || isDispatcherThread()) {
+        return false;
+    }
+    int tries = 0;
+    while(!closed && apr_atomic_read32(&shard->spooling) == 0) {
+        if (shard->buffer->offer(event)) {
+            return true;
+        }
+        if (waitStrategy == SPIN_THEN_PARK) {
+            if (++tries > SPIN_TRIES + YIELD_TRIES) {
+                break;
+            }
+            if (tries > SPIN_TRIES) {
+                apr_thread_yield();
+            }
+        }
+    }
+    return false;
+}
+
+bool AsyncAppender::spinWait(Shard* shard) {
+    for(int tries = 0; tries < SPIN_TRIES + YIELD_TRIES; tries++) {
+        if (closed) {
+            return false;
+        }
+        if (!shard->buffer->isEmpty()
+            || apr_atomic_read32(&shard->spooling) != 0
+            || apr_atomic_read32(&discarding) != 0
+            || apr_atomic_read32(&shard->flushRequested) != apr_atomic_read32(&shard->flushCompleted)) {
+            return true;
+        }
+        if (tries >= SPIN_TRIES && waitStrategy == SPIN_THEN_PARK) {
+            apr_thread_yield();
+        }
+    }
+    //
+    //   a busy spinning dispatcher returns to the dispatch loop, which
+    //   also drains retired buffers and collects staged events.
+    //
+    return waitStrategy == BUSY_SPIN;
+}
+
+void AsyncAppender::overflow(Shard* shard, const LoggingEventPtr& event) {
+    if (overflowPolicy == SPOOL) {
+        if (shard->spool == 0) {
+            LogString fileName(spoolFile);
+            if (shard->index > 0) {
+                Pool p;
+                fileName.append(1, (logchar) 0x2E /* '.' */);
+                StringHelper::toString(shard->index, p, fileName);
+            }
+            shard->spool = new EventSpool(fileName);
+        }
+        if (shard->spool->write(event)) {
+            apr_atomic_set32(&shard->spooling, 1);
+        } else {
+            discard(event);
+        }
+        return;
+    }
+
+    while(!shard->buffer->offer(event)) {
+        //
+        //   Following code is only reachable if buffer is full
+        //
+        if (overflowPolicy == DROP_OLDEST) {
+            LoggingEventPtr oldest;
+            if (shard->buffer->poll(oldest)) {
+                discard(oldest);
+                continue;
+            }
+        } else {
+            bool wait = overflowPolicy == BLOCK
+                || (overflowPolicy == DISCARD_BELOW_THRESHOLD
+                    && event->getLevel()->isGreaterOrEqual(discardThreshold));
+            //
+            //   if waiting and thread is not already interrupted
+            //      and not the dispatcher then
+            //      wait for a buffer notification
+            if (wait
+                && !closed
+                && !Thread::interrupted()
+                && !isDispatcherThread()) {
+                log4cxx_time_t start = apr_time_now();
+                try {
+                    bufferNotFull.await(bufferMutex);
+                    blockedTime += apr_time_now() - start;
+                    continue;
+                } catch (InterruptedException& e) {
+                    blockedTime += apr_time_now() - start;
+                    //
+                    //  reset interrupt status so
+                    //    calling code can see interrupt on
+                    //    their next wait or sleep.
+                    Thread::currentThreadInterrupt();
+                }
+            }
+        }
+
+        //
+        //   add event to discard map.
+        //
+        discard(event);
+        break;
+    }
+}
+
+void AsyncAppender::discard(const LoggingEventPtr& event) {
+    const LogString& loggerName = event->getLoggerName();
+    DiscardMap::iterator iter = discardMap->find(loggerName);
+    if (iter == discardMap->end()) {
+        DiscardSummary summary(event);
+        discardMap->insert(DiscardMap::value_type(loggerName, summary));
+    } else {
+        (*iter).second.add(event);
+    }
+    discardCounts[loggerName]++;
+    apr_atomic_set32(&discarding, 1);
 }
 
 AsyncAppender::DiscardSummary::DiscardSummary(const LoggingEventPtr& event) : 
@@ -305,60 +1171,240 @@ LoggingEventPtr AsyncAppender::DiscardSummary::createEvent(Pool& p) {
     msg.append(LOG4CXX_STR(" messages due to a full event buffer including: "));
     msg.append(maxEvent->getMessage()); 
     return new LoggingEvent(   
-              maxEvent->getLoggerName(),
+              maxEvent->getLoggerNamePtr(),
               maxEvent->getLevel(),
               msg,
               LocationInfo::getLocationUnavailable());
 }
 
 
+bool AsyncAppender::isBufferEmpty(const Shard* shard) const {
+    if (!shard->buffer->isEmpty() || shard->spooling != 0) {
+        return false;
+    }
+    for(std::vector<EventRingBuffer*>::const_iterator iter = shard->retiredBuffers.begin();
+        iter != shard->retiredBuffers.end();
+        iter++) {
+        if (!(*iter)->isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int AsyncAppender::drainBuffers(Shard* shard,
+    std::vector<EventRingBuffer*>& rings,
+    unsigned int& ringCount,
+    LoggingEventList& events,
+    Pool& p) {
+    if (apr_atomic_read32(&shard->retiredCount) != ringCount) {
+        synchronized sync(bufferMutex);
+        rings = shard->retiredBuffers;
+        ringCount = apr_atomic_read32(&shard->retiredCount);
+    }
+    size_t depth = 0;
+    for(std::vector<EventRingBuffer*>::iterator iter = rings.begin();
+        iter != rings.end();
+        iter++) {
+        depth += (*iter)->drain(events);
+    }
+    depth += shard->buffer->drain(events);
+
+    //
+    //   buffered events are older than spooled ones, producers
+    //   only return to the buffer once the spool is empty.
+    //
+    if (apr_atomic_read32(&shard->spooling) != 0) {
+        synchronized sync(bufferMutex);
+        shard->spool->read(events, shard->buffer->getCapacity());
+        if (shard->spool->isEmpty()) {
+            apr_atomic_set32(&shard->spooling, 0);
+        }
+    }
+
+    if (apr_atomic_read32(&discarding) != 0) {
+        synchronized sync(bufferMutex);
+        for(DiscardMap::iterator discardIter = discardMap->begin();
+            discardIter != discardMap->end();
+            discardIter++) {
+            events.push_back(discardIter->second.createEvent(p));
+        }
+        discardMap->clear();
+        apr_atomic_set32(&discarding, 0);
+    }
+
+    //
+    //   drain published the freed slots with an exchange,
+    //   producers increment blockedProducers before retrying.
+    //
+    if (apr_atomic_read32(&blockedProducers) != 0) {
+        synchronized sync(bufferMutex);
+        bufferNotFull.signalAll();
+    }
+    return (int) depth;
+}
+
+bool AsyncAppender::park(Shard* shard) {
+    //  spinning leaves dispatcherWaiting clear, producers do not signal
+    if (waitStrategy != BLOCKING && spinWait(shard)) {
+        return true;
+    }
+    synchronized sync(bufferMutex);
+    apr_atomic_xchg32(&shard->dispatcherWaiting, 1);
+    while(isBufferEmpty(shard) && apr_atomic_read32(&discarding) == 0 && !closed
+        && apr_atomic_read32(&shard->flushRequested) == apr_atomic_read32(&shard->flushCompleted)) {
+        log4cxx_time_t timeout = 0;
+        if (apr_atomic_read32(&shard->stagedBlocks) != 0) {
+            //  return in time to collect the blocks of idle threads
+            timeout = (log4cxx_time_t) stagingDelay * 500;
+        }
+        if (shard->index == 0 && metricsInterval > 0
+            && (timeout == 0 || timeout > (log4cxx_time_t) metricsInterval * 1000)) {
+            timeout = (log4cxx_time_t) metricsInterval * 1000;
+        }
+        if (timeout > 0) {
+            shard->bufferNotEmpty.await(bufferMutex, timeout);
+            break;
+        }
+        shard->bufferNotEmpty.await(bufferMutex);
+    }
+    apr_atomic_set32(&shard->dispatcherWaiting, 0);
+    return !closed;
+}
+
 #if APR_HAS_THREADS
 void* LOG4CXX_THREAD_FUNC AsyncAppender::dispatch(apr_thread_t* /*thread*/, void* data) {
-    AsyncAppender* pThis = (AsyncAppender*) data;
+    Shard* shard = (Shard*) data;
+    AsyncAppender* pThis = shard->appender;
+    std::vector<EventRingBuffer*> rings;
+    unsigned int ringCount = 0;
+    std::vector<StagingBlock*> blocks;
+    unsigned int generation = 0;
+    log4cxx_time_t nextCollect = 0;
+    log4cxx_time_t nextMetrics = 0;
+    bool flushing = false;
+    unsigned int flushRequest = 0;
+    EventRingBuffer* flushRing = 0;
+    unsigned int flushPosition = 0;
+    unsigned int settingsGeneration = 0;
+    pThis->applyThreadSettings(shard, settingsGeneration);
     bool isActive = true;
     try {
-        while (isActive) {
-             //
-             //   process events after lock on buffer is released.
-             //
+        while (true) {
             Pool p;
             LoggingEventList events;
-            {
-                   synchronized sync(pThis->bufferMutex);
-                   size_t bufferSize = pThis->buffer.size();
-                   isActive = !pThis->closed;
-               
-                   while((bufferSize == 0) && isActive) {
-                       pThis->bufferNotEmpty.await(pThis->bufferMutex);
-                       bufferSize = pThis->buffer.size();
-                       isActive = !pThis->closed;
-                   }
-                   for(LoggingEventList::iterator eventIter = pThis->buffer.begin();
-                       eventIter != pThis->buffer.end();
-                       eventIter++) {
-                       events.push_back(*eventIter);
-                   }
-                   for(DiscardMap::iterator discardIter = pThis->discardMap->begin();
-                       discardIter != pThis->discardMap->end();
-                       discardIter++) {
-                       events.push_back(discardIter->second.createEvent(p));
-                   }
-                   pThis->buffer.clear();
-                   pThis->discardMap->clear();
-                   pThis->bufferNotFull.signalAll();
+            if (apr_atomic_read32(&pThis->threadSettingsGeneration) != settingsGeneration) {
+                pThis->applyThreadSettings(shard, settingsGeneration);
+            }
+            //
+            //   staged events are collected every half staging delay,
+            //   and all of them once the appender is closed.
+            //
+            if (apr_atomic_read32(&shard->stagedBlocks) != 0
+                || apr_atomic_read32(&shard->stagingGeneration) != generation) {
+                log4cxx_time_t now = apr_time_now();
+                if (!isActive || now >= nextCollect) {
+                    pThis->collectStaged(shard, blocks, generation, !isActive, events);
+                    nextCollect = now + (log4cxx_time_t) pThis->stagingDelay * 500;
+                }
             }
-            
-            for (LoggingEventList::iterator iter = events.begin();
-                 iter != events.end();
-                 iter++) {
-                 synchronized sync(pThis->appenders->getMutex());
-                 pThis->appenders->appendLoopOnAppenders(*iter, p);
+
+            //
+            //   a flush request is served once the events appended before
+            //   it are all in the buffer, which holds them until the
+            //   dequeue position passes the enqueue position read here.
+            //
+            if (!flushing) {
+                unsigned int requested = apr_atomic_read32(&shard->flushRequested);
+                if (requested != apr_atomic_read32(&shard->flushCompleted)
+                    && pThis->collectStaged(shard, blocks, generation, true, events)
+                    && apr_atomic_read32(&shard->spooling) == 0) {
+                    flushing = true;
+                    flushRequest = requested;
+                    flushRing = shard->buffer;
+                    flushPosition = flushRing->getEnqueuePosition();
+                }
+            }
+
+            int depth = pThis->drainBuffers(shard, rings, ringCount, events, p);
+            if (shard->index == 0 && pThis->metricsInterval > 0 && isActive) {
+                log4cxx_time_t now = apr_time_now();
+                if (nextMetrics == 0) {
+                    nextMetrics = now + (log4cxx_time_t) pThis->metricsInterval * 1000;
+                } else if (now >= nextMetrics) {
+                    nextMetrics = now + (log4cxx_time_t) pThis->metricsInterval * 1000;
+                    pThis->logMetrics(p);
+                }
+            }
+
+            if (!events.empty()) {
+                pThis->updateMetrics(depth, events);
+
+                if (apr_atomic_read32(&pThis->abandoning) != 0) {
+                    apr_atomic_add32(&pThis->abandonedEvents, events.size());
+                } else {
+                    //
+                    //   the list of appenders is a snapshot, dispatchers of
+                    //   other shards may append to the same appenders.
+                    pThis->appenders->appendLoopOnAppenders(events, p);
+                }
+            }
+
+            //
+            //   events claimed by poll count as served, they were discarded.
+            //
+            if (flushing
+                && (int) (flushRing->getDequeuePosition() - flushPosition) >= 0) {
+                bool retiredEmpty = true;
+                for(std::vector<EventRingBuffer*>::iterator iter = rings.begin();
+                    iter != rings.end();
+                    iter++) {
+                    retiredEmpty = retiredEmpty && (*iter)->isEmpty();
+                }
+                if (retiredEmpty) {
+                    synchronized sync(pThis->bufferMutex);
+                    apr_atomic_set32(&shard->flushCompleted, flushRequest);
+                    pThis->flushed.signalAll();
+                    flushing = false;
+                }
+            }
+
+            if (events.empty()) {
+                if (!isActive) {
+                    bool empty;
+                    {
+                        synchronized sync(pThis->bufferMutex);
+                        empty = pThis->isBufferEmpty(shard)
+                            && apr_atomic_read32(&shard->stagedBlocks) == 0;
+                    }
+                    if (empty) {
+                        break;
+                    }
+                    //  an event is still being published
+                    apr_thread_yield();
+                } else if (flushing
+                    || apr_atomic_read32(&shard->flushRequested) != apr_atomic_read32(&shard->flushCompleted)) {
+                    //  a flush waits for an event being published or a staging block
+                    apr_thread_yield();
+                } else {
+                    //  the dispatcher only waits when all buffers are empty
+                    isActive = pThis->park(shard);
+                }
             }
         }
     } catch(InterruptedException& ex) {
             Thread::currentThreadInterrupt();
     } catch(...) {
     }
+
+    //
+    //   all events were appended or abandoned, serve pending flushes.
+    //
+    {
+        synchronized sync(pThis->bufferMutex);
+        apr_atomic_set32(&shard->flushCompleted, apr_atomic_read32(&shard->flushRequested));
+        pThis->flushed.signalAll();
+    }
     return 0;
 }
-#endif                
+#endif
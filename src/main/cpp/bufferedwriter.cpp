@@ -40,6 +40,10 @@ void BufferedWriter::close(Pool& p) {
 }
 
 void BufferedWriter::flush(Pool& p) {
+  if (utf8.length() > 0) {
+     out->writeUTF8(utf8, p);
+     utf8.erase(utf8.begin(), utf8.end());
+  }
   if (buf.length() > 0) {
      out->write(buf, p);
      buf.erase(buf.begin(), buf.end());
@@ -47,6 +51,10 @@ void BufferedWriter::flush(Pool& p) {
 }
 
 void BufferedWriter::write(const LogString& str, Pool& p) {
+  if (utf8.length() > 0) {
+    out->writeUTF8(utf8, p);
+    utf8.erase(utf8.begin(), utf8.end());
+  }
   if (buf.length() + str.length() > sz) {
     out->write(buf, p);
     buf.erase(buf.begin(), buf.end());
@@ -58,3 +66,22 @@ void BufferedWriter::write(const LogString& str, Pool& p) {
   }
 }
 
+bool BufferedWriter::isUTF8() const {
+  return out->isUTF8();
+}
+
+void BufferedWriter::writeUTF8(const std::string& str, Pool& p) {
+  if (buf.length() > 0) {
+    out->write(buf, p);
+    buf.erase(buf.begin(), buf.end());
+  }
+  if (utf8.length() + str.length() > sz) {
+    out->writeUTF8(utf8, p);
+    utf8.erase(utf8.begin(), utf8.end());
+  }
+  if (str.length() > sz) {
+    out->writeUTF8(str, p);
+  } else {
+    utf8.append(str);
+  }
+}
@@ -21,6 +21,7 @@
 
 #include <apr_time.h>
 #include <log4cxx/helpers/pool.h>
+#include <apr_atomic.h>
 #include <limits>
 #include <log4cxx/helpers/exception.h>
 
@@ -56,6 +57,16 @@ const logchar CachedDateFormat::magicString2[] = { 0x39, 0x38, 0x37, 0};
  */
 const logchar CachedDateFormat::zeroString[] = { 0x30, 0x30, 0x30, 0 };
 
+/**
+ *  Expected representation of the microsecond magic number.
+ */
+const logchar CachedDateFormat::microMagicString[] = { 0x36, 0x35, 0x34, 0x33, 0x32, 0x31, 0 };
+
+/**
+ *  Expected representation of 0 microseconds.
+ */
+const logchar CachedDateFormat::microZeroString[] = { 0x30, 0x30, 0x30, 0x30, 0x30, 0x30, 0 };
+
 #undef min
 
 /**
@@ -70,10 +81,15 @@ CachedDateFormat::CachedDateFormat(const DateFormatPtr& dateFormat,
         int expiration1) :
        formatter(dateFormat),
        millisecondStart(0),
-       slotBegin(std::numeric_limits<log4cxx_time_t>::min()),
-       cache(50, 0x20),
        expiration(expiration1),
-       previousTime(std::numeric_limits<log4cxx_time_t>::min()) {
+       timeZoneGeneration(0) {
+  slot.sequence = 0;
+  slot.generation = 0;
+  slot.time = std::numeric_limits<log4cxx_time_t>::min();
+  slot.begin = std::numeric_limits<log4cxx_time_t>::min();
+  slot.fieldStart = UNRECOGNIZED_MILLISECONDS;
+  slot.fieldDigits = 3;
+  slot.length = 0;
   if (dateFormat == NULL) {
     throw IllegalArgumentException(LOG4CXX_STR("dateFormat cannot be null"));
   }
@@ -160,6 +176,63 @@ int CachedDateFormat::findMillisecondStart(
 }
 
 
+/**
+ * Finds start of a six digit microsecond field in formatted time.
+ * @param time long time
+ * @param formatted String corresponding formatted string
+ * @param formatter DateFormat date format
+ * @return int position in string of first digit of microseconds,
+ *    -2 indicates no recognized microsecond field
+ */
+int CachedDateFormat::findMicrosecondStart(
+  log4cxx_time_t time, const LogString& formatted,
+  const DateFormatPtr& formatter,
+  Pool& pool) {
+
+  log4cxx_time_t slotBegin = (time / 1000000) * 1000000;
+  if (slotBegin > time) {
+     slotBegin -= 1000000;
+  }
+  int micros = (int) (time - slotBegin);
+
+  LogString plusMagic;
+  formatter->format(plusMagic, slotBegin + microMagic, pool);
+  LogString plusZero;
+  formatter->format(plusZero, slotBegin, pool);
+  if (plusMagic.length() != formatted.length()
+      || plusZero.length() != formatted.length()) {
+      return UNRECOGNIZED_MILLISECONDS;
+  }
+
+  //  the first difference is the first digit, as the magic
+  //     number and zero differ in every digit
+  size_t start = 0;
+  while (start < formatted.length() && plusZero[start] == plusMagic[start]) {
+      start++;
+  }
+  const size_t len = 6;
+  if (start + len > formatted.length()) {
+      return UNRECOGNIZED_MILLISECONDS;
+  }
+  LogString formattedMicros(len, 0x20);
+  for (size_t i = len; i > 0; i--) {
+      formattedMicros[i - 1] = digits[micros % 10];
+      micros /= 10;
+  }
+  if (regionMatches(microMagicString, 0, plusMagic, start, len)
+      && regionMatches(microZeroString, 0, plusZero, start, len)
+      && regionMatches(formattedMicros, 0, formatted, start, len)
+      && regionMatches(plusZero, 0, formatted, 0, start)
+      && plusZero.compare(start + len, LogString::npos,
+             plusMagic, start + len, LogString::npos) == 0
+      && plusZero.compare(start + len, LogString::npos,
+             formatted, start + len, LogString::npos) == 0) {
+      return (int) start;
+  }
+  return UNRECOGNIZED_MILLISECONDS;
+}
+
+
 /**
  * Formats a millisecond count into a date/time string.
  *
@@ -167,62 +240,118 @@ int CachedDateFormat::findMillisecondStart(
  *  @param sbuf the string buffer to write to
  */
  void CachedDateFormat::format(LogString& buf, log4cxx_time_t now, Pool& p) const {
+  if (formatCached(buf, now)) {
+      return;
+  }
 
   //
-  // If the current requested time is identical to the previously
-  //     requested time, then append the cache contents.
-  //
-  if (now == previousTime) {
-       buf.append(cache);
-       return;
+  //  could not use the published value.
+  //    Call underlying formatter to format date.
+  unsigned int generation = apr_atomic_read32(&timeZoneGeneration);
+  LogString formatted;
+  formatter->format(formatted, now, p);
+  buf.append(formatted);
+  publish(now, formatted, generation, p);
+}
+
+bool CachedDateFormat::formatCached(LogString& buf, log4cxx_time_t now) const {
+  unsigned int sequence = apr_atomic_read32(&slot.sequence);
+  if (sequence & 1) {
+      return false;
   }
 
+  if (slot.generation != apr_atomic_read32(&timeZoneGeneration)) {
+      return false;
+  }
+  int fieldStart = slot.fieldStart;
+  log4cxx_time_t begin = slot.begin;
   //
-  //   If millisecond pattern was not unrecognized
-  //     (that is if it was found or milliseconds did not appear)
+  //   the requested time must be identical to the formatted time
+  //     or, if the subsecond field was recognized (or is absent),
+  //     be within the same integral second and the expiration.
   //
-  if (millisecondStart != UNRECOGNIZED_MILLISECONDS) {
-      //    Check if the cache is still valid.
-      //    If the requested time is within the same integral second
-      //       as the last request and a shorter expiration was not requested.
-      if (now < slotBegin + expiration
-          && now >= slotBegin
-          && now < slotBegin + 1000000L) {
-          //
-          //    if there was a millisecond field then update it
-          //
-          if (millisecondStart >= 0) {
-              millisecondFormat((int) ((now - slotBegin)/1000), cache, millisecondStart);
-          }
-          //
-          //   update the previously requested time
-          //      (the slot begin should be unchanged)
-          previousTime = now;
-          buf.append(cache);
+  if (now != slot.time
+      && (fieldStart == UNRECOGNIZED_MILLISECONDS
+         || now < begin
+         || now >= begin + expiration
+         || now >= begin + 1000000L)) {
+      return false;
+  }
+
+  logchar text[CAPACITY];
+  size_t length = slot.length;
+  int fieldDigits = slot.fieldDigits;
+  if (length > CAPACITY) {
+      return false;
+  }
+  for (size_t i = 0; i < length; i++) {
+      text[i] = slot.text[i];
+  }
+  if (apr_atomic_read32(&slot.sequence) != sequence) {
+      //  rewritten while copied
+      return false;
+  }
 
-          return;
+  if (fieldStart >= 0 && fieldStart + fieldDigits <= (int) length) {
+      int value = (int) (now - begin);
+      if (fieldDigits == 3) {
+          value /= 1000;
       }
+      for (int i = fieldStart + fieldDigits - 1; i >= fieldStart; i--) {
+          text[i] = digits[value % 10];
+          value /= 10;
+      }
+  }
+  buf.append(text, length);
+  return true;
+}
+
+void CachedDateFormat::publish(log4cxx_time_t now,
+    const LogString& formatted, unsigned int generation, Pool& p) const {
+  if (formatted.length() > CAPACITY
+      || generation != apr_atomic_read32(&timeZoneGeneration)) {
+      return;
   }
 
   //
-  //  could not use previous value.
-  //    Call underlying formatter to format date.
-  cache.erase(cache.begin(), cache.end());
-  formatter->format(cache, now, p);
-  buf.append(cache);
-  previousTime = now;
-  slotBegin = (previousTime / 1000000) * 1000000;
-  if (slotBegin > previousTime) {
-      slotBegin -= 1000000;
+  //   only one thread rewrites the slot, the others
+  //     keep their own result and skip the search below.
+  unsigned int sequence = apr_atomic_read32(&slot.sequence);
+  if ((sequence & 1)
+      || apr_atomic_cas32(&slot.sequence, sequence + 1, sequence) != sequence) {
+      return;
   }
 
   //
-  //    if the milliseconds field was previous found
+  //    if the subsecond field was found before
   //       then reevaluate in case it moved.
   //
-  if (millisecondStart >= 0) {
-      millisecondStart = findMillisecondStart(now, cache, formatter, p);
+  int fieldStart = millisecondStart;
+  int fieldDigits = 3;
+  if (fieldStart >= 0) {
+      fieldStart = findMicrosecondStart(now, formatted, formatter, p);
+      if (fieldStart >= 0) {
+          fieldDigits = 6;
+      } else {
+          fieldStart = findMillisecondStart(now, formatted, formatter, p);
+      }
+      millisecondStart = fieldStart;
+  }
+
+  log4cxx_time_t begin = (now / 1000000) * 1000000;
+  if (begin > now) {
+      begin -= 1000000;
+  }
+  slot.generation = generation;
+  slot.time = now;
+  slot.begin = begin;
+  slot.fieldStart = fieldStart;
+  slot.fieldDigits = fieldDigits;
+  slot.length = formatted.length();
+  for (size_t i = 0; i < formatted.length(); i++) {
+      slot.text[i] = formatted[i];
   }
+  apr_atomic_inc32(&slot.sequence);
 }
 
 /**
@@ -249,8 +378,19 @@ void CachedDateFormat::millisecondFormat(int millis,
  */
 void CachedDateFormat::setTimeZone(const TimeZonePtr& timeZone) {
   formatter->setTimeZone(timeZone);
-  previousTime = std::numeric_limits<log4cxx_time_t>::min();
-  slotBegin = std::numeric_limits<log4cxx_time_t>::min();
+  //
+  //   dates of the previous time zone, published or still
+  //      being published, carry an older generation and are ignored.
+  apr_atomic_inc32(&timeZoneGeneration);
+  //
+  //   clear the slot unless another thread is publishing.
+  unsigned int sequence = apr_atomic_read32(&slot.sequence);
+  if ((sequence & 1) == 0
+      && apr_atomic_cas32(&slot.sequence, sequence + 1, sequence) == sequence) {
+      slot.time = std::numeric_limits<log4cxx_time_t>::min();
+      slot.fieldStart = UNRECOGNIZED_MILLISECONDS;
+      apr_atomic_inc32(&slot.sequence);
+  }
 }
 
 
@@ -269,22 +409,27 @@ void CachedDateFormat::numberFormat(LogString& s, int n, Pool& p) const {
  */
 int CachedDateFormat::getMaximumCacheValidity(const LogString& pattern) {
    //
-   //   If there are more "S" in the pattern than just one "SSS" then
-   //      (for example, "HH:mm:ss,SSS SSS"), then set the expiration to
-   //      one millisecond which should only perform duplicate request caching.
+   //   If there are more "S" in the pattern than just one "SSS"
+   //      or one "SSSSSS" then (for example, "HH:mm:ss,SSS SSS"),
+   //      then set the expiration to one millisecond which should
+   //      only perform duplicate request caching.
    //
    const logchar S = 0x53;
-   const logchar SSS[] = { 0x53, 0x53, 0x53, 0 };
    size_t firstS = pattern.find(S);
+   if (firstS == LogString::npos) {
+       return 1000000;
+   }
    size_t len = pattern.length();
+   size_t count = pattern.find_first_not_of(S, firstS);
+   if (count == LogString::npos) {
+       count = len;
+   }
+   count -= firstS;
    //
-   //   if there are no S's or
-   //      three that start with the first S and no fourth S in the string
+   //   three or six that start with the first S and no further S in the string
    //
-   if (firstS == LogString::npos ||
-       (len >= firstS + 3 && pattern.compare(firstS, 3, SSS) == 0
-           && (len == firstS + 3 ||
-                pattern.find(S, firstS + 3) == LogString::npos))) {
+   if ((count == 3 || count == 6)
+       && pattern.find(S, firstS + count) == LogString::npos) {
            return 1000000;
    }
    return 1000;
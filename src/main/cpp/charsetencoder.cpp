@@ -280,6 +280,14 @@ namespace log4cxx
                   return APR_SUCCESS;
               }
 
+              virtual bool isUTF8() const {
+#if LOG4CXX_LOGCHAR_IS_UTF8
+                  return true;
+#else
+                  return false;
+#endif
+              }
+
           private:
                   TrivialCharsetEncoder(const TrivialCharsetEncoder&);
                   TrivialCharsetEncoder& operator=(const TrivialCharsetEncoder&);
@@ -309,6 +317,10 @@ public:
          return APR_SUCCESS;
      }
 
+    virtual bool isUTF8() const {
+         return true;
+    }
+
 private:
      UTF8CharsetEncoder(const UTF8CharsetEncoder&);
      UTF8CharsetEncoder& operator=(const UTF8CharsetEncoder&);
@@ -504,6 +516,10 @@ void CharsetEncoder::reset() {
 void CharsetEncoder::flush(ByteBuffer& /* out */ ) {
 }
 
+bool CharsetEncoder::isUTF8() const {
+    return false;
+}
+
 
 void CharsetEncoder::encode(CharsetEncoderPtr& enc,
     const LogString& src,
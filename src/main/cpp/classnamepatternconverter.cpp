@@ -54,3 +54,7 @@ void ClassNamePatternConverter::format(
     append(toAppendTo, event->getLocationInformation().getClassName());
     abbreviate(initialLength, toAppendTo);
   }
+
+bool ClassNamePatternConverter::requiresMDC() const {
+    return false;
+}
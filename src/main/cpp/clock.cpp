@@ -0,0 +1,204 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logstring.h>
+#include <log4cxx/helpers/clock.h>
+#include <log4cxx/helpers/loglog.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <apr_time.h>
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
+#include <time.h>
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+#include <intrin.h>
+#define LOG4CXX_HAS_TSC 1
+#elif defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define LOG4CXX_HAS_TSC 1
+#else
+#define LOG4CXX_HAS_TSC 0
+#endif
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+
+namespace {
+    volatile apr_uint32_t clockType = Clock::SYSTEM_CLOCK;
+
+    /**
+     *  Time stamp counter calibration.  Readers retry while
+     *  sequence is odd or has changed, writers are serialized
+     *  by calibrating.
+     */
+    volatile apr_uint32_t sequence = 0;
+    volatile apr_uint32_t calibrating = 0;
+    volatile log4cxx_time_t firstCycles = 0;
+    volatile log4cxx_time_t firstTime = 0;
+    volatile log4cxx_time_t anchorCycles = 0;
+    volatile log4cxx_time_t anchorTime = 0;
+    volatile double cyclesPerMicro = 0;
+
+    /**
+     *  Interval in microseconds after which the anchor
+     *  of the calibration is refreshed.
+     */
+    const log4cxx_time_t RECALIBRATION_INTERVAL = APR_USEC_PER_SEC;
+
+    inline log4cxx_time_t readCoarse() {
+#if defined(CLOCK_REALTIME_COARSE)
+        struct timespec ts;
+        if (clock_gettime(CLOCK_REALTIME_COARSE, &ts) == 0) {
+            return (log4cxx_time_t) ts.tv_sec * APR_USEC_PER_SEC + ts.tv_nsec / 1000;
+        }
+#endif
+        return apr_time_now();
+    }
+
+    inline log4cxx_time_t readTSC() {
+#if LOG4CXX_HAS_TSC
+#if defined(_MSC_VER)
+        return (log4cxx_time_t) __rdtsc();
+#else
+        unsigned int lo, hi;
+        __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+        return (log4cxx_time_t) (((unsigned long long) hi << 32) | lo);
+#endif
+#else
+        return 0;
+#endif
+    }
+
+    void setCalibration(log4cxx_time_t cycles, log4cxx_time_t time, double rate) {
+        apr_atomic_inc32(&sequence);
+        anchorCycles = cycles;
+        anchorTime = time;
+        cyclesPerMicro = rate;
+        apr_atomic_inc32(&sequence);
+    }
+
+    /**
+     *  Takes the first sample and estimates the counter frequency
+     *  over a short sleep.  Refined by later recalibrations.
+     */
+    bool calibrate() {
+        if (apr_atomic_cas32(&calibrating, 1, 0) != 0) {
+            return cyclesPerMicro > 0;
+        }
+        if (cyclesPerMicro <= 0) {
+            log4cxx_time_t c0 = readTSC();
+            log4cxx_time_t t0 = apr_time_now();
+            apr_sleep(10000);
+            log4cxx_time_t c1 = readTSC();
+            log4cxx_time_t t1 = apr_time_now();
+            if (c1 > c0 && t1 > t0) {
+                firstCycles = c0;
+                firstTime = t0;
+                setCalibration(c1, t1, (double) (c1 - c0) / (double) (t1 - t0));
+            }
+        }
+        apr_atomic_set32(&calibrating, 0);
+        return cyclesPerMicro > 0;
+    }
+}
+
+Clock::Clock() {
+}
+
+void Clock::recalibrate() {
+    if (cyclesPerMicro > 0 && apr_atomic_cas32(&calibrating, 1, 0) == 0) {
+        log4cxx_time_t cycles = readTSC();
+        log4cxx_time_t time = apr_time_now();
+        if (cycles > firstCycles && time > firstTime) {
+            setCalibration(cycles, time,
+                (double) (cycles - firstCycles) / (double) (time - firstTime));
+        }
+        apr_atomic_set32(&calibrating, 0);
+    }
+}
+
+Clock::Type Clock::setType(Type type) {
+    if (type == COARSE_CLOCK) {
+#if !defined(CLOCK_REALTIME_COARSE)
+        LogLog::warn(LOG4CXX_STR("Coarse clock not available, using system clock."));
+        type = SYSTEM_CLOCK;
+#endif
+    } else if (type == TSC_CLOCK) {
+        if (!LOG4CXX_HAS_TSC || !calibrate()) {
+            LogLog::warn(LOG4CXX_STR("Time stamp counter not available, using system clock."));
+            type = SYSTEM_CLOCK;
+        }
+    }
+    apr_atomic_set32(&clockType, type);
+    return type;
+}
+
+bool Clock::setType(const LogString& name) {
+    if (StringHelper::equalsIgnoreCase(name, LOG4CXX_STR("SYSTEM"), LOG4CXX_STR("system"))) {
+        setType(SYSTEM_CLOCK);
+    } else if (StringHelper::equalsIgnoreCase(name, LOG4CXX_STR("COARSE"), LOG4CXX_STR("coarse"))) {
+        setType(COARSE_CLOCK);
+    } else if (StringHelper::equalsIgnoreCase(name, LOG4CXX_STR("TSC"), LOG4CXX_STR("tsc"))) {
+        setType(TSC_CLOCK);
+    } else {
+        LogLog::warn(LOG4CXX_STR("Unknown clock [") + name + LOG4CXX_STR("], ignored."));
+        return false;
+    }
+    return true;
+}
+
+Clock::Type Clock::getType() {
+    return (Type) apr_atomic_read32(&clockType);
+}
+
+log4cxx_time_t Clock::read(bool& cycles) {
+    switch(apr_atomic_read32(&clockType)) {
+        case COARSE_CLOCK:
+        cycles = false;
+        return readCoarse();
+
+        case TSC_CLOCK:
+        cycles = true;
+        return readTSC();
+
+        default:
+        cycles = false;
+        return apr_time_now();
+    }
+}
+
+log4cxx_time_t Clock::toTime(log4cxx_time_t cycles) {
+    log4cxx_time_t time;
+    bool stale;
+    apr_uint32_t seq;
+    do {
+        seq = apr_atomic_read32(&sequence);
+        while (seq & 1) {
+            apr_thread_yield();
+            seq = apr_atomic_read32(&sequence);
+        }
+        double rate = cyclesPerMicro;
+        if (rate <= 0) {
+            return apr_time_now();
+        }
+        log4cxx_time_t elapsed = (log4cxx_time_t) ((double) (cycles - anchorCycles) / rate);
+        time = anchorTime + elapsed;
+        stale = elapsed > RECALIBRATION_INTERVAL;
+    } while (seq != apr_atomic_read32(&sequence));
+    if (stale) {
+        recalibrate();
+    }
+    return time;
+}
@@ -31,6 +31,18 @@
 #include <log4cxx/helpers/exception.h>
 #include <log4cxx/helpers/loglog.h>
 #include <log4cxx/helpers/date.h>
+#include <log4cxx/helpers/mutex.h>
+#include <log4cxx/helpers/synchronized.h>
+#if !defined(LOG4CXX)
+#define LOG4CXX 1
+#endif
+#include <log4cxx/helpers/aprinitializer.h>
+#include <log4cxx/helpers/transcoder.h>
+#include <log4cxx/private/log4cxx_private.h>
+#include <map>
+#if LOG4CXX_HAS_STD_LOCALE
+#include <locale>
+#endif
 
 using namespace log4cxx;
 using namespace log4cxx::pattern;
@@ -39,13 +51,112 @@ using namespace log4cxx::helpers;
 
 IMPLEMENT_LOG4CXX_OBJECT(DatePatternConverter)
 
+namespace {
+    bool sharedDateFormatsDestroyed = false;
+
+    /**
+     *  Date format and the number of converters using it.
+     */
+    struct SharedDateFormat {
+        SharedDateFormat() : df(), users(0) {
+        }
+
+        DateFormatPtr df;
+        int users;
+    };
+
+    /**
+     *  Date formats by converter options and locale.
+     */
+    class SharedDateFormats {
+    public:
+        SharedDateFormats() : mutex(APRInitializer::getRootPool()), formats() {
+        }
+
+        ~SharedDateFormats() {
+            sharedDateFormatsDestroyed = true;
+        }
+
+        Mutex mutex;
+        std::map<LogString, SharedDateFormat> formats;
+
+    private:
+        SharedDateFormats(const SharedDateFormats&);
+        SharedDateFormats& operator=(const SharedDateFormats&);
+    };
+
+    SharedDateFormats* getSharedDateFormats() {
+        static SharedDateFormats shared;
+        if (sharedDateFormatsDestroyed) {
+            return 0;
+        }
+        return &shared;
+    }
+}
+
 DatePatternConverter::DatePatternConverter(
    const std::vector<LogString>& options) :
    LoggingEventPatternConverter(LOG4CXX_STR("Class Name"),
-      LOG4CXX_STR("class name")), df(getDateFormat(options)) {
+      LOG4CXX_STR("class name")), sharedKey(), df(getDateFormat(options, sharedKey)) {
 }
 
-DateFormatPtr DatePatternConverter::getDateFormat(const OptionsList& options) {
+DatePatternConverter::~DatePatternConverter() {
+  df = 0;
+  releaseDateFormat(sharedKey);
+}
+
+DateFormatPtr DatePatternConverter::getDateFormat(const OptionsList& options,
+    LogString& key) {
+  SharedDateFormats* shared = getSharedDateFormats();
+#if LOG4CXX_HAS_STD_LOCALE
+  //
+  //   names of months and days come from the current locale,
+  //   unnamed locales cannot be told apart
+  //
+  std::string localeName(std::locale().name());
+  if (shared == 0 || localeName == "*") {
+      return createDateFormat(options);
+  }
+#else
+  if (shared == 0) {
+      return createDateFormat(options);
+  }
+#endif
+  //
+  //   only the pattern and the time zone are used
+  //
+  for (OptionsList::size_type i = 0; i < options.size() && i < 2; i++) {
+      key.append(options[i]);
+      key.append(1, (logchar) 0);
+  }
+  for (OptionsList::size_type i = options.size(); i < 2; i++) {
+      key.append(1, (logchar) 0);
+  }
+#if LOG4CXX_HAS_STD_LOCALE
+  Transcoder::decode(localeName, key);
+#endif
+  synchronized sync(shared->mutex);
+  SharedDateFormat& entry = shared->formats[key];
+  if (entry.df == 0) {
+      entry.df = createDateFormat(options);
+  }
+  entry.users++;
+  return entry.df;
+}
+
+void DatePatternConverter::releaseDateFormat(const LogString& key) {
+  SharedDateFormats* shared = getSharedDateFormats();
+  if (key.empty() || shared == 0) {
+      return;
+  }
+  synchronized sync(shared->mutex);
+  std::map<LogString, SharedDateFormat>::iterator iter = shared->formats.find(key);
+  if (iter != shared->formats.end() && --iter->second.users == 0) {
+      shared->formats.erase(iter);
+  }
+}
+
+DateFormatPtr DatePatternConverter::createDateFormat(const OptionsList& options) {
   DateFormatPtr df;
   int maximumCacheValidity = 1000000;
   if (options.size() == 0) {
@@ -97,6 +208,10 @@ PatternConverterPtr DatePatternConverter::newInstance(
    return new DatePatternConverter(options);
 }
 
+const DateFormatPtr& DatePatternConverter::getDateFormat() const {
+   return df;
+}
+
 void DatePatternConverter::format(
   const LoggingEventPtr& event,
   LogString& toAppendTo,
@@ -133,3 +248,7 @@ void DatePatternConverter::format(
     Pool& p) const {
     df->format(toAppendTo, date->getTime(), p);
 }
+
+bool DatePatternConverter::requiresMDC() const {
+    return false;
+}
@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/helpers/deferredmessage.h>
+#include <log4cxx/helpers/transcoder.h>
+#include <apr.h>
+#include <apr_strings.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+
+void DeferredMessage::add(const char* val) {
+    if (val == 0) {
+        val = "null";
+    }
+    add(std::string(val));
+}
+
+void DeferredMessage::add(const std::string& val) {
+    Argument* arg = next(STRING_ARG);
+    if (arg) {
+        arg->value.offset = strings.size();
+        arg->length = val.size();
+        strings.append(val);
+    }
+}
+
+void DeferredMessage::format(LogString& dest) const {
+    std::string text;
+    char buf[64];
+    int current = 0;
+    const char* start = pattern;
+    const char* p = pattern;
+    for(; *p != 0; p++) {
+        if (p[0] != '{' || p[1] != '}' || current >= count) {
+            continue;
+        }
+        text.append(start, p - start);
+        const Argument& arg = arguments[current++];
+        switch(arg.type) {
+            case BOOL_ARG:
+            text.append(arg.value.l ? "true" : "false");
+            break;
+
+            case CHAR_ARG:
+            text.append(1, (char) arg.value.l);
+            break;
+
+            case LONG_ARG:
+            apr_snprintf(buf, sizeof(buf), "%ld", arg.value.l);
+            text.append(buf);
+            break;
+
+            case ULONG_ARG:
+            apr_snprintf(buf, sizeof(buf), "%lu", arg.value.ul);
+            text.append(buf);
+            break;
+
+            case INT64_ARG:
+            apr_snprintf(buf, sizeof(buf), "%" APR_INT64_T_FMT, (apr_int64_t) arg.value.ll);
+            text.append(buf);
+            break;
+
+            case UINT64_ARG:
+            apr_snprintf(buf, sizeof(buf), "%" APR_UINT64_T_FMT, (apr_uint64_t) arg.value.ull);
+            text.append(buf);
+            break;
+
+            case DOUBLE_ARG:
+            apr_snprintf(buf, sizeof(buf), "%g", arg.value.d);
+            text.append(buf);
+            break;
+
+            case POINTER_ARG:
+            apr_snprintf(buf, sizeof(buf), "%pp", arg.value.p);
+            text.append(buf);
+            break;
+
+            case STRING_ARG:
+            text.append(strings, arg.value.offset, arg.length);
+            break;
+        }
+        p++;
+        start = p + 1;
+    }
+    text.append(start, p - start);
+    Transcoder::decode(text, dest);
+}
@@ -33,6 +33,7 @@
 #include <log4cxx/defaultloggerfactory.h>
 #include <log4cxx/helpers/filewatchdog.h>
 #include <log4cxx/helpers/synchronized.h>
+#include <log4cxx/helpers/clock.h>
 #include <log4cxx/spi/loggerrepository.h>
 #include <log4cxx/spi/loggingevent.h>
 #include <log4cxx/helpers/pool.h>
@@ -110,6 +111,8 @@ IMPLEMENT_LOG4CXX_OBJECT(DOMConfigurator)
 #define REF_ATTR "ref"
 #define ADDITIVITY_ATTR "additivity"
 #define THRESHOLD_ATTR "threshold"
+#define CLOCK_ATTR "clock"
+#define SHUTDOWN_TIMEOUT_ATTR "shutdownTimeout"
 #define CONFIG_DEBUG_ATTR "configDebug"
 #define INTERNAL_DEBUG_ATTR "debug"
 
@@ -819,66 +822,63 @@ void DOMConfigurator::configureAndWatch(const CFStringRef& filename)
 
 void DOMConfigurator::configureAndWatch(const std::string& filename, long delay)
 {
-        File file(filename);
-#if APR_HAS_THREADS
-		if( xdog )
-		{
-			APRInitializer::unregisterCleanup(xdog);
-			delete xdog;
-		}
-        xdog = new XMLWatchdog(file);
-        APRInitializer::registerCleanup(xdog);
-        xdog->setDelay(delay);
-        xdog->start();
-#else
-    DOMConfigurator().doConfigure(file, LogManager::getLoggerRepository());
-#endif        
+        startWatchdog(File(filename), delay, 0);
 }
 
 #if LOG4CXX_WCHAR_T_API
 void DOMConfigurator::configureAndWatch(const std::wstring& filename, long delay)
 {
-        File file(filename);
-#if APR_HAS_THREADS
-		if( xdog )
-		{
-			APRInitializer::unregisterCleanup(xdog);
-			delete xdog;
-		}
-        xdog = new XMLWatchdog(file);
-        APRInitializer::registerCleanup(xdog);
-        xdog->setDelay(delay);
-        xdog->start();
-#else
-    DOMConfigurator().doConfigure(file, LogManager::getLoggerRepository());
-#endif        
+        startWatchdog(File(filename), delay, 0);
 }
 #endif
 
 #if LOG4CXX_UNICHAR_API
 void DOMConfigurator::configureAndWatch(const std::basic_string<UniChar>& filename, long delay)
 {
-        File file(filename);
-#if APR_HAS_THREADS
-		if( xdog )
-		{
-			APRInitializer::unregisterCleanup(xdog);
-			delete xdog;
-		}
-        xdog = new XMLWatchdog(file);
-        APRInitializer::registerCleanup(xdog);
-        xdog->setDelay(delay);
-        xdog->start();
-#else
-    DOMConfigurator().doConfigure(file, LogManager::getLoggerRepository());
-#endif        
+        startWatchdog(File(filename), delay, 0);
 }
 #endif
 
 #if LOG4CXX_CFSTRING_API
 void DOMConfigurator::configureAndWatch(const CFStringRef& filename, long delay)
 {
-        File file(filename);
+        startWatchdog(File(filename), delay, 0);
+}
+#endif
+
+void DOMConfigurator::configureAndWatch(const std::string& filename, long delay,
+        const ThreadSettings& settings)
+{
+        startWatchdog(File(filename), delay, &settings);
+}
+
+#if LOG4CXX_WCHAR_T_API
+void DOMConfigurator::configureAndWatch(const std::wstring& filename, long delay,
+        const ThreadSettings& settings)
+{
+        startWatchdog(File(filename), delay, &settings);
+}
+#endif
+
+#if LOG4CXX_UNICHAR_API
+void DOMConfigurator::configureAndWatch(const std::basic_string<UniChar>& filename, long delay,
+        const ThreadSettings& settings)
+{
+        startWatchdog(File(filename), delay, &settings);
+}
+#endif
+
+#if LOG4CXX_CFSTRING_API
+void DOMConfigurator::configureAndWatch(const CFStringRef& filename, long delay,
+        const ThreadSettings& settings)
+{
+        startWatchdog(File(filename), delay, &settings);
+}
+#endif
+
+void DOMConfigurator::startWatchdog(const File& file, long delay,
+        const ThreadSettings* settings)
+{
 #if APR_HAS_THREADS
 		if( xdog )
 		{
@@ -888,12 +888,15 @@ void DOMConfigurator::configureAndWatch(const CFStringRef& filename, long delay)
         xdog = new XMLWatchdog(file);
         APRInitializer::registerCleanup(xdog);
         xdog->setDelay(delay);
+        if (settings != 0)
+        {
+            xdog->getThreadSettings() = *settings;
+        }
         xdog->start();
 #else
     DOMConfigurator().doConfigure(file, LogManager::getLoggerRepository());
 #endif        
 }
-#endif
 
 void DOMConfigurator::parse(
                             Pool& p,
@@ -951,6 +954,18 @@ void DOMConfigurator::parse(
                 repository->setThreshold(thresholdStr);
     }
 
+    LogString clockStr = subst(getAttribute(utf8Decoder, element, CLOCK_ATTR));
+    if(!clockStr.empty() && clockStr != NuLL)
+        {
+                Clock::setType(clockStr);
+    }
+
+    LogString shutdownTimeoutStr = subst(getAttribute(utf8Decoder, element, SHUTDOWN_TIMEOUT_ATTR));
+    if(!shutdownTimeoutStr.empty() && shutdownTimeoutStr != NuLL)
+        {
+                LogManager::setShutdownTimeout(OptionConverter::toInt(shutdownTimeoutStr, -1));
+    }
+
     apr_xml_elem* currentElement;
     for(currentElement = element->first_child;
         currentElement;
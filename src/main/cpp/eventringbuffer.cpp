@@ -0,0 +1,165 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logstring.h>
+#include <log4cxx/helpers/eventringbuffer.h>
+#include <apr_atomic.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+EventRingBuffer::EventRingBuffer(int capacity)
+   : enqueuePosition(0), dequeuePosition(0),
+     mask(roundCapacity(capacity) - 1),
+     storage(new char[(mask + 2) * CACHE_LINE_SIZE]),
+     slots(alignSlots(storage)) {
+   //  fails to compile unless a slot fills exactly one cache line
+   typedef char SlotSizeCheck[sizeof(Slot) == CACHE_LINE_SIZE ? 1 : -1];
+   (void) sizeof(SlotSizeCheck);
+   for(unsigned int i = 0; i <= mask; i++) {
+       slots[i].sequence = i;
+       slots[i].event = 0;
+   }
+}
+
+EventRingBuffer::~EventRingBuffer() {
+   for(unsigned int i = 0; i <= mask; i++) {
+       if (slots[i].event != 0) {
+           slots[i].event->releaseRef();
+       }
+   }
+   delete [] storage;
+}
+
+unsigned int EventRingBuffer::roundCapacity(int capacity) {
+   unsigned int rounded = 1;
+   while(rounded < (unsigned int) capacity && rounded < 0x40000000) {
+       rounded <<= 1;
+   }
+   return rounded;
+}
+
+EventRingBuffer::Slot* EventRingBuffer::alignSlots(char* storage) {
+   size_t offset = ((size_t) storage) % CACHE_LINE_SIZE;
+   if (offset != 0) {
+       storage += CACHE_LINE_SIZE - offset;
+   }
+   return (Slot*) storage;
+}
+
+bool EventRingBuffer::offer(const LoggingEventPtr& event) {
+   unsigned int position = apr_atomic_read32(&enqueuePosition);
+   Slot* slot;
+   while(true) {
+       slot = slots + (position & mask);
+       int diff = (int) (apr_atomic_read32(&slot->sequence) - position);
+       if (diff == 0) {
+           unsigned int previous = apr_atomic_cas32(&enqueuePosition, position + 1, position);
+           if (previous == position) {
+               break;
+           }
+           position = previous;
+       } else if (diff < 0) {
+           //  slot still holds the event of the previous lap
+           return false;
+       } else {
+           position = apr_atomic_read32(&enqueuePosition);
+       }
+   }
+   event->addRef();
+   slot->event = event;
+   apr_atomic_set32(&slot->sequence, position + 1);
+   return true;
+}
+
+size_t EventRingBuffer::drain(LoggingEventList& events) {
+   unsigned int position = apr_atomic_read32(&dequeuePosition);
+   unsigned int end;
+   while(true) {
+       //  claim all published events at once, poll may take
+       //  the oldest one concurrently
+       end = position;
+       while(end - position <= mask
+             && apr_atomic_read32(&slots[end & mask].sequence) == end + 1) {
+           end++;
+       }
+       if (end == position) {
+           return 0;
+       }
+       unsigned int previous = apr_atomic_cas32(&dequeuePosition, end, position);
+       if (previous == position) {
+           break;
+       }
+       position = previous;
+   }
+   size_t count = end - position;
+   for(; position != end; position++) {
+       Slot* slot = slots + (position & mask);
+       LoggingEvent* event = slot->event;
+       slot->event = 0;
+       apr_atomic_set32(&slot->sequence, position + mask + 1);
+       events.push_back(event);
+       event->releaseRef();
+   }
+   //  the atomic add orders the freed slots before later reads by the consumer
+   apr_atomic_add32(&dequeuePosition, 0);
+   return count;
+}
+
+bool EventRingBuffer::poll(LoggingEventPtr& event) {
+   unsigned int position = apr_atomic_read32(&dequeuePosition);
+   Slot* slot;
+   while(true) {
+       slot = slots + (position & mask);
+       if (apr_atomic_read32(&slot->sequence) != position + 1) {
+           //  empty or the oldest event is still being published
+           return false;
+       }
+       unsigned int previous = apr_atomic_cas32(&dequeuePosition, position + 1, position);
+       if (previous == position) {
+           break;
+       }
+       position = previous;
+   }
+   LoggingEvent* oldest = slot->event;
+   slot->event = 0;
+   apr_atomic_set32(&slot->sequence, position + mask + 1);
+   event = oldest;
+   oldest->releaseRef();
+   return true;
+}
+
+bool EventRingBuffer::isEmpty() const {
+   return apr_atomic_read32(&enqueuePosition) == apr_atomic_read32(&dequeuePosition);
+}
+
+int EventRingBuffer::size() const {
+   return (int) (apr_atomic_read32(&enqueuePosition) - apr_atomic_read32(&dequeuePosition));
+}
+
+int EventRingBuffer::getCapacity() const {
+   return (int) mask + 1;
+}
+
+unsigned int EventRingBuffer::getEnqueuePosition() const {
+   return apr_atomic_read32(&enqueuePosition);
+}
+
+unsigned int EventRingBuffer::getDequeuePosition() const {
+   return apr_atomic_read32(&dequeuePosition);
+}
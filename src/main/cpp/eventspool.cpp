@@ -0,0 +1,330 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <log4cxx/logstring.h>
+#include <log4cxx/helpers/eventspool.h>
+#include <log4cxx/helpers/loglog.h>
+#include <log4cxx/helpers/exception.h>
+#include <apr_file_io.h>
+#if !defined(LOG4CXX)
+#define LOG4CXX 1
+#endif
+#include <log4cxx/helpers/aprinitializer.h>
+#include <string.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+namespace {
+    void putInt(std::string& dest, log4cxx_uint32_t value) {
+        dest.append((const char*) &value, sizeof(value));
+    }
+
+    void putString(std::string& dest, const LogString& value) {
+        putInt(dest, (log4cxx_uint32_t) value.length());
+        dest.append((const char*) value.data(), value.length() * sizeof(logchar));
+    }
+
+    /**
+     *  Reads the fields of a record, becomes invalid
+     *  instead of reading past the end.
+     */
+    class RecordReader {
+    public:
+        RecordReader(const std::string& body) : data(body), pos(0), valid(true) {
+        }
+
+        log4cxx_uint32_t getInt() {
+            log4cxx_uint32_t value = 0;
+            get(&value, sizeof(value));
+            return value;
+        }
+
+        log4cxx_time_t getTime() {
+            log4cxx_time_t value = 0;
+            get(&value, sizeof(value));
+            return value;
+        }
+
+        LogString getString() {
+            log4cxx_uint32_t length = getInt();
+            if (!valid || length > (data.size() - pos) / sizeof(logchar)) {
+                valid = false;
+                return LogString();
+            }
+            LogString value((const logchar*) (data.data() + pos), length);
+            pos += length * sizeof(logchar);
+            return value;
+        }
+
+        bool isValid() const {
+            return valid;
+        }
+
+        bool atEnd() const {
+            return pos == data.size();
+        }
+
+    private:
+        const std::string& data;
+        size_t pos;
+        bool valid;
+
+        void get(void* dest, size_t length) {
+            if (!valid || length > data.size() - pos) {
+                valid = false;
+                return;
+            }
+            memcpy(dest, data.data() + pos, length);
+            pos += length;
+        }
+    };
+}
+
+EventSpool::EventSpool(const LogString& fileName1)
+   : fileName(fileName1), pool(), file(0),
+     readOffset(0), writeOffset(0), failed(false) {
+}
+
+EventSpool::~EventSpool() {
+   if (file != 0 && !APRInitializer::isDestructed) {
+       apr_file_close(file);
+       File().setPath(fileName).deleteFile(pool);
+   }
+}
+
+bool EventSpool::open() {
+   if (failed) {
+       return false;
+   }
+   apr_status_t stat = File().setPath(fileName).open(&file,
+       APR_FOPEN_READ | APR_FOPEN_WRITE | APR_FOPEN_CREATE | APR_FOPEN_TRUNCATE | APR_FOPEN_BINARY,
+       APR_OS_DEFAULT, pool);
+   if (stat != APR_SUCCESS) {
+       file = 0;
+       fail(LOG4CXX_STR("Unable to open spool file "), stat);
+       return false;
+   }
+   return true;
+}
+
+void EventSpool::reset() {
+   if (file != 0) {
+       apr_file_trunc(file, 0);
+   }
+   readOffset = 0;
+   writeOffset = 0;
+   levels.clear();
+   loggers.clear();
+   loggerIndex.clear();
+   locations.clear();
+   locationIndex.clear();
+}
+
+void EventSpool::fail(const LogString& msg, log4cxx_status_t stat) {
+   if (!failed) {
+       failed = true;
+       LogLog::error(msg + fileName, IOException(stat));
+   }
+}
+
+unsigned int EventSpool::indexOf(const LevelPtr& level) {
+   for(unsigned int i = 0; i < levels.size(); i++) {
+       if (levels[i] == level) {
+           return i;
+       }
+   }
+   levels.push_back(level);
+   return levels.size() - 1;
+}
+
+unsigned int EventSpool::indexOf(const LoggerNamePtr& logger) {
+   std::map<const LoggerName*, unsigned int>::const_iterator iter =
+       loggerIndex.find(logger);
+   if (iter != loggerIndex.end()) {
+       return iter->second;
+   }
+   unsigned int index = loggers.size();
+   loggers.push_back(logger);
+   loggerIndex.insert(std::map<const LoggerName*, unsigned int>::value_type(logger, index));
+   return index;
+}
+
+unsigned int EventSpool::indexOf(const LocationInfo& location) {
+   //  the file name is a literal, the method name is only
+   //  available through getClassName and getMethodName
+   std::string key;
+   const char* locationFile = location.getFileName();
+   key.append((const char*) &locationFile, sizeof(locationFile));
+   int line = location.getLineNumber();
+   key.append((const char*) &line, sizeof(line));
+   key.append(location.getClassName());
+   key.append(1, ':');
+   key.append(location.getMethodName());
+   std::map<std::string, unsigned int>::const_iterator iter =
+       locationIndex.find(key);
+   if (iter != locationIndex.end()) {
+       return iter->second;
+   }
+   unsigned int index = locations.size();
+   locations.push_back(location);
+   locationIndex.insert(std::map<std::string, unsigned int>::value_type(key, index));
+   return index;
+}
+
+bool EventSpool::write(const LoggingEventPtr& event) {
+   if (file == 0 && !open()) {
+       return false;
+   }
+   record.erase();
+   //  length of the record, set below
+   putInt(record, 0);
+   log4cxx_time_t timeStamp = event->getTimeStamp();
+   record.append((const char*) &timeStamp, sizeof(timeStamp));
+   putInt(record, indexOf(event->getLevel()));
+   putInt(record, indexOf(event->getLoggerNamePtr()));
+   putInt(record, indexOf(event->getLocationInformation()));
+   putString(record, event->getRenderedMessage());
+   putString(record, event->getThreadName());
+   LogString ndc;
+   if (event->getNDC(ndc)) {
+       putInt(record, 1);
+       putString(record, ndc);
+   } else {
+       putInt(record, 0);
+   }
+   LoggingEvent::KeySet keys(event->getMDCKeySet());
+   putInt(record, (log4cxx_uint32_t) keys.size());
+   for(LoggingEvent::KeySet::const_iterator iter = keys.begin();
+       iter != keys.end();
+       iter++) {
+       LogString value;
+       event->getMDC(*iter, value);
+       putString(record, *iter);
+       putString(record, value);
+   }
+   keys = event->getPropertyKeySet();
+   putInt(record, (log4cxx_uint32_t) keys.size());
+   for(LoggingEvent::KeySet::const_iterator iter = keys.begin();
+       iter != keys.end();
+       iter++) {
+       LogString value;
+       event->getProperty(*iter, value);
+       putString(record, *iter);
+       putString(record, value);
+   }
+   log4cxx_uint32_t length = (log4cxx_uint32_t) (record.size() - sizeof(length));
+   memcpy(&record[0], &length, sizeof(length));
+
+   apr_off_t offset = writeOffset;
+   apr_status_t stat = apr_file_seek(file, APR_SET, &offset);
+   if (stat == APR_SUCCESS) {
+       stat = apr_file_write_full(file, record.data(), record.size(), NULL);
+   }
+   if (stat != APR_SUCCESS) {
+       fail(LOG4CXX_STR("Unable to write spool file "), stat);
+       return false;
+   }
+   writeOffset += record.size();
+   return true;
+}
+
+size_t EventSpool::read(LoggingEventList& events, size_t maxCount) {
+   size_t count = 0;
+   std::string body;
+   while(count < maxCount && readOffset < writeOffset) {
+       log4cxx_uint32_t length = 0;
+       apr_off_t offset = readOffset;
+       apr_status_t stat = apr_file_seek(file, APR_SET, &offset);
+       if (stat == APR_SUCCESS) {
+           stat = apr_file_read_full(file, &length, sizeof(length), NULL);
+       }
+       LoggingEventPtr event;
+       if (stat == APR_SUCCESS
+           && (log4cxx_int64_t) (sizeof(length) + length) <= writeOffset - readOffset) {
+           body.resize(length);
+           if (length > 0) {
+               stat = apr_file_read_full(file, &body[0], length, NULL);
+           }
+           if (stat == APR_SUCCESS) {
+               event = decode(body);
+           }
+       }
+       if (event == 0) {
+           LogLog::error(LOG4CXX_STR("Discarding unreadable events in spool file ") + fileName);
+           reset();
+           return count;
+       }
+       events.push_back(event);
+       readOffset += sizeof(length) + length;
+       count++;
+   }
+   if (readOffset == writeOffset && writeOffset != 0) {
+       reset();
+   }
+   return count;
+}
+
+LoggingEventPtr EventSpool::decode(const std::string& body) const {
+   RecordReader reader(body);
+   log4cxx_time_t timeStamp = reader.getTime();
+   log4cxx_uint32_t level = reader.getInt();
+   log4cxx_uint32_t logger = reader.getInt();
+   log4cxx_uint32_t location = reader.getInt();
+   LogString message(reader.getString());
+   LogString threadName(reader.getString());
+   bool hasNDC = reader.getInt() != 0;
+   LogString ndc;
+   if (hasNDC) {
+       ndc = reader.getString();
+   }
+   MDC::Map mdc;
+   log4cxx_uint32_t mdcCount = reader.getInt();
+   for(log4cxx_uint32_t i = 0; i < mdcCount && reader.isValid(); i++) {
+       LogString key(reader.getString());
+       mdc[key] = reader.getString();
+   }
+   MDC::Map properties;
+   log4cxx_uint32_t propertyCount = reader.getInt();
+   for(log4cxx_uint32_t i = 0; i < propertyCount && reader.isValid(); i++) {
+       LogString key(reader.getString());
+       properties[key] = reader.getString();
+   }
+   if (!reader.isValid() || !reader.atEnd()
+       || level >= levels.size()
+       || logger >= loggers.size()
+       || location >= locations.size()) {
+       return 0;
+   }
+   LoggingEventPtr event(new LoggingEvent(loggers[logger],
+       levels[level], timeStamp, message, threadName,
+       hasNDC ? &ndc : 0, mdc, locations[location]));
+   for(MDC::Map::const_iterator iter = properties.begin();
+       iter != properties.end();
+       iter++) {
+       event->setProperty(iter->first, iter->second);
+   }
+   return event;
+}
+
+bool EventSpool::isEmpty() const {
+   return readOffset == writeOffset;
+}
+
+const LogString& EventSpool::getFileName() const {
+   return fileName;
+}
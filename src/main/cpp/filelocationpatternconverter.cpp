@@ -48,3 +48,7 @@ void FileLocationPatternConverter::format(
    Pool& /* p */ ) const {
     append(toAppendTo, event->getLocationInformation().getFileName());
 }
+
+bool FileLocationPatternConverter::requiresMDC() const {
+    return false;
+}
@@ -35,6 +35,7 @@ FileWatchdog::FileWatchdog(const File& file1)
  : file(file1), delay(DEFAULT_DELAY), lastModif(0),
 warnedAlready(false), interrupted(0), thread()
 {
+    thread.getSettings().setName(LOG4CXX_STR("FileWatchdog"));
 }
 
 FileWatchdog::~FileWatchdog() {
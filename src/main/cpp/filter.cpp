@@ -47,3 +47,7 @@ void Filter::activateOptions(Pool&) {
 void Filter::setOption(const LogString&, const LogString&) {
 }
 
+bool Filter::requiresMDC() const {
+    return true;
+}
+
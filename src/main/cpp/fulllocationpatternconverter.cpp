@@ -54,3 +54,7 @@ void FullLocationPatternConverter::format(
        p, toAppendTo);
    toAppendTo.append(1, (logchar) 0x29 /* ')' */);
 }
+
+bool FullLocationPatternConverter::requiresMDC() const {
+    return false;
+}
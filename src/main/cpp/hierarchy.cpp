@@ -39,6 +39,7 @@
 #include <log4cxx/defaultconfigurator.h>
 #include <log4cxx/spi/rootlogger.h>
 #include <apr_atomic.h>
+#include <apr_thread_proc.h>
 #include "assert.h"
 
 
@@ -48,12 +49,103 @@ using namespace log4cxx::helpers;
 
 IMPLEMENT_LOG4CXX_OBJECT(Hierarchy)
 
+/**
+ *  Open addressing hash table of loggers.  Slots are only ever filled
+ *  and the table is kept at most half full, so a search ends at the
+ *  matching logger or at an empty slot without needing a lock.
+ */
+class Hierarchy::LoggerTable {
+public:
+    enum { INITIAL_CAPACITY = 64 };
+
+    LoggerTable(size_t capacity1)
+        : capacity(capacity1), count(0), slots(new Slot[capacity1]) {
+        for (size_t i = 0; i < capacity; i++) {
+            slots[i] = 0;
+        }
+    }
+
+    ~LoggerTable() {
+        delete [] slots;
+    }
+
+    Logger* find(const LogString& name) const {
+        size_t mask = capacity - 1;
+        for (size_t i = hash(name) & mask; ; i = (i + 1) & mask) {
+            //   a slot is written once, after the logger is fully linked
+            Logger* logger = slots[i];
+            if (logger == 0 || logger->getName() == name) {
+                return logger;
+            }
+        }
+    }
+
+    bool isFull() const {
+        return (count + 1) * 2 > capacity;
+    }
+
+    void add(Logger* logger) {
+        size_t mask = capacity - 1;
+        size_t i = hash(logger->getName()) & mask;
+        while (slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        apr_atomic_casptr((volatile void**) &slots[i], logger, 0);
+        count++;
+    }
+
+    void addAll(const LoggerTable& src) {
+        for (size_t i = 0; i < src.capacity; i++) {
+            if (src.slots[i] != 0) {
+                add(src.slots[i]);
+            }
+        }
+    }
+
+    void getLoggers(LoggerList& list) const {
+        for (size_t i = 0; i < capacity; i++) {
+            Logger* logger = slots[i];
+            if (logger != 0) {
+                list.push_back(logger);
+            }
+        }
+    }
+
+    const size_t capacity;
+
+private:
+    typedef Logger* volatile Slot;
+    size_t count;
+    Slot* const slots;
+
+    static size_t hash(const LogString& name) {
+        size_t h = 2166136261U;
+        for (LogString::const_iterator iter = name.begin(); iter != name.end(); iter++) {
+            h = (h ^ (unsigned int) *iter) * 16777619U;
+        }
+        return h;
+    }
+
+    LoggerTable(const LoggerTable&);
+    LoggerTable& operator=(const LoggerTable&);
+};
+
+namespace {
+    bool isNameBefore(const LoggerPtr& a, const LoggerPtr& b) {
+        return a->getName() < b->getName();
+    }
+}
+
 Hierarchy::Hierarchy() :
 pool(),
 mutex(pool),
 loggers(new LoggerMap()),
-provisionNodes(new ProvisionNodeMap())
+provisionNodes(new ProvisionNodeMap()),
+table(new LoggerTable(LoggerTable::INITIAL_CAPACITY)),
+epoch(0)
 {
+        searches[0] = 0;
+        searches[1] = 0;
         synchronized sync(mutex);
         root = new RootLogger(pool, Level::getDebug());
         root->setHierarchy(this);
@@ -72,6 +164,7 @@ Hierarchy::~Hierarchy()
 #ifndef APR_HAS_THREADS
 	delete loggers;
 	delete provisionNodes;
+	delete table;
 #endif
 }
 
@@ -99,7 +192,12 @@ void Hierarchy::addHierarchyEventListener(const spi::HierarchyEventListenerPtr&
 void Hierarchy::clear()
 {
         synchronized sync(mutex);
-        loggers->clear();
+        //
+        //   the cleared loggers are released only after searches
+        //   of the old table have taken their references.
+        LoggerMap cleared;
+        cleared.swap(*loggers);
+        replaceTable(new LoggerTable(LoggerTable::INITIAL_CAPACITY));
 }
 
 void Hierarchy::emitNoAppenderWarning(const LoggerPtr& logger)
@@ -123,17 +221,10 @@ void Hierarchy::emitNoAppenderWarning(const LoggerPtr& logger)
 
 LoggerPtr Hierarchy::exists(const LogString& name)
 {
-        synchronized sync(mutex);
-
-        LoggerPtr logger;
-        LoggerMap::iterator it = loggers->find(name);
-        if (it != loggers->end())
-        {
-                logger = it->second;
-        }
-
-
-        return logger;
+        apr_uint32_t searchEpoch = beginSearch();
+        LoggerPtr existing(table->find(name));
+        endSearch(searchEpoch);
+        return existing;
 }
 
 void Hierarchy::setThreshold(const LevelPtr& l)
@@ -146,6 +237,7 @@ void Hierarchy::setThreshold(const LevelPtr& l)
             if (thresholdInt != Level::ALL_INT) {
                setConfigured(true);
             }
+            Logger::invalidateThresholds();
         }
 }
 
@@ -213,6 +305,16 @@ LoggerPtr Hierarchy::getLogger(const LogString& name)
 LoggerPtr Hierarchy::getLogger(const LogString& name,
      const spi::LoggerFactoryPtr& factory)
 {
+        //
+        //   existing loggers are found without locking
+        apr_uint32_t searchEpoch = beginSearch();
+        LoggerPtr existing(table->find(name));
+        endSearch(searchEpoch);
+        if (existing != 0)
+        {
+                return existing;
+        }
+
         synchronized sync(mutex);
 
         LoggerMap::iterator it = loggers->find(name);
@@ -235,6 +337,7 @@ LoggerPtr Hierarchy::getLogger(const LogString& name,
                 }
 
                 updateParents(logger);
+                publishLogger(logger);
                 return logger;
         }
 
@@ -242,17 +345,11 @@ LoggerPtr Hierarchy::getLogger(const LogString& name,
 
 LoggerList Hierarchy::getCurrentLoggers() const
 {
-        synchronized sync(mutex);
-
         LoggerList v;
-        LoggerMap::const_iterator it, itEnd = loggers->end();
-
-        for (it = loggers->begin(); it != itEnd; it++)
-        {
-                v.push_back(it->second);
-        }
-
-
+        apr_uint32_t searchEpoch = beginSearch();
+        table->getLoggers(v);
+        endSearch(searchEpoch);
+        std::sort(v.begin(), v.end(), isNameBefore);
         return v;
 }
 
@@ -296,6 +393,8 @@ void Hierarchy::resetConfiguration()
                 logger->setResourceBundle(0);
         }
 
+        Logger::invalidateThresholds();
+
         //rendererMap.clear();
 }
 
@@ -372,6 +471,8 @@ void Hierarchy::updateParents(LoggerPtr logger)
         {
                 logger->parent = root;
         }
+
+        Logger::invalidateThresholds();
 }
 
 void Hierarchy::updateChildren(ProvisionNode& pn, LoggerPtr logger)
@@ -391,11 +492,61 @@ void Hierarchy::updateChildren(ProvisionNode& pn, LoggerPtr logger)
                         l->parent = logger;
                 }
         }
+
+        // the children and their descendants now inherit from the new logger
+        Logger::invalidateThresholds();
 }
 
 void Hierarchy::setConfigured(bool newValue) {
     synchronized sync(mutex);
-    configured = newValue;
+    if (configured != newValue) {
+        configured = newValue;
+        // unconfigured loggers must go through isDisabled to trigger configuration
+        Logger::invalidateThresholds();
+    }
+}
+
+void Hierarchy::publishLogger(Logger* logger) {
+    LoggerTable* current = table;
+    if (current->isFull()) {
+        LoggerTable* grown = new LoggerTable(current->capacity * 2);
+        grown->addAll(*current);
+        grown->add(logger);
+        replaceTable(grown);
+    } else {
+        current->add(logger);
+    }
+}
+
+apr_uint32_t Hierarchy::beginSearch() const {
+    for(;;) {
+        apr_uint32_t current = apr_atomic_read32(&epoch);
+        apr_atomic_inc32(&searches[current]);
+        //
+        //   a search registered in the current epoch is waited for
+        //   by the next replacement before the table it sees is deleted.
+        if (apr_atomic_read32(&epoch) == current) {
+            return current;
+        }
+        apr_atomic_dec32(&searches[current]);
+    }
+}
+
+void Hierarchy::endSearch(apr_uint32_t searchEpoch) const {
+    apr_atomic_dec32(&searches[searchEpoch]);
+}
+
+void Hierarchy::replaceTable(LoggerTable* newTable) {
+    LoggerTable* old = (LoggerTable*)
+        apr_atomic_xchgptr((volatile void**) &table, newTable);
+    //
+    //   searches starting from now on see the new table,
+    //   wait for those which may still be in the old one.
+    apr_uint32_t previous = apr_atomic_xchg32(&epoch, apr_atomic_read32(&epoch) ^ 1);
+    while (apr_atomic_read32(&searches[previous]) != 0) {
+        apr_thread_yield();
+    }
+    delete old;
 }
 
 bool Hierarchy::isConfigured() {
@@ -38,3 +38,7 @@ LogString Layout::getContentType() const { return LOG4CXX_STR("text/plain"); }
 void Layout::appendHeader(LogString&, log4cxx::helpers::Pool&) {}
 
 void Layout::appendFooter(LogString&, log4cxx::helpers::Pool&) {}
+
+bool Layout::requiresMDC() const { return true; }
+
+bool Layout::formatUTF8(std::string&, const spi::LoggingEventPtr&, Pool&) const { return false; }
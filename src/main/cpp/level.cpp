@@ -118,6 +118,10 @@ void Level::toString(std::string& dst) const {
     Transcoder::encode(name, dst);
 }
 
+void Level::toUTF8(std::string& dst) const {
+    Transcoder::encodeUTF8(name, dst);
+}
+
 #if LOG4CXX_WCHAR_T_API
 LevelPtr Level::toLevel(const std::wstring& sArg)
 {
@@ -85,3 +85,7 @@ LogString LevelPatternConverter::getStyleClass(const ObjectPtr& obj) const {
 
     return LOG4CXX_STR("level");
   }
+
+bool LevelPatternConverter::requiresMDC() const {
+    return false;
+}
@@ -50,3 +50,7 @@ void LineLocationPatternConverter::format(
        event->getLocationInformation().getLineNumber(),
        p, toAppendTo);
 }
+
+bool LineLocationPatternConverter::requiresMDC() const {
+    return false;
+}
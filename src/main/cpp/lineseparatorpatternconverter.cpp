@@ -55,3 +55,7 @@ void LineSeparatorPatternConverter::format(
   Pool& /* p */) const {
   toAppendTo.append(LOG4CXX_EOL);
  }
+
+bool LineSeparatorPatternConverter::requiresMDC() const {
+    return false;
+}
@@ -60,3 +60,6 @@ void LiteralPatternConverter::format(
   toAppendTo.append(literal);
  }
 
+bool LiteralPatternConverter::requiresMDC() const {
+    return false;
+}
@@ -19,6 +19,7 @@
 #include <log4cxx/logger.h>
 #include <log4cxx/spi/loggingevent.h>
 #include <log4cxx/logmanager.h>
+#include <log4cxx/hierarchy.h>
 #include <log4cxx/spi/loggerfactory.h>
 #include <log4cxx/appender.h>
 #include <log4cxx/level.h>
@@ -29,11 +30,13 @@
 #include <log4cxx/helpers/transcoder.h>
 #include <log4cxx/helpers/appenderattachableimpl.h>
 #include <log4cxx/helpers/exception.h>
+#include <log4cxx/helpers/threadspecificdata.h>
 #if !defined(LOG4CXX)
 #define LOG4CXX 1
 #endif
 #include <log4cxx/private/log4cxx_private.h>
 #include <log4cxx/helpers/aprinitializer.h>
+#include <apr_atomic.h>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
@@ -41,11 +44,57 @@ using namespace log4cxx::spi;
 
 IMPLEMENT_LOG4CXX_OBJECT(Logger)
 
+namespace {
+    //
+    //   Bumped by every change of a level, a parent chain, a repository
+    //   threshold or a configured state.  A logger trusts its cached
+    //   threshold only while it was computed in the current generation.
+    //   Starts above the generation of a new logger, which is 0.
+    //
+    volatile apr_uint32_t currentThresholdGeneration = 1;
+
+    //
+    //   Pool for the duration of one logging request.  Borrows the
+    //   calling thread's recycled pool, or creates a private one
+    //   when an enclosing request (an appender that logs) holds it.
+    //
+    class RequestPool {
+    public:
+        RequestPool() : shared(ThreadSpecificData::acquirePool()), local(0) {
+        }
+
+        ~RequestPool() {
+            if (shared != 0) {
+                ThreadSpecificData::releasePool(shared);
+            }
+            delete local;
+        }
+
+        Pool& get() {
+            if (shared != 0) {
+                return *shared;
+            }
+            if (local == 0) {
+                local = new Pool();
+            }
+            return *local;
+        }
+
+    private:
+        RequestPool(const RequestPool&);
+        RequestPool& operator=(const RequestPool&);
+        Pool* shared;
+        Pool* local;
+    };
+}
+
 Logger::Logger(Pool& p, const LogString& name1)
-: pool(&p), name(), level(), parent(), resourceBundle(),
-repository(), aai(), mutex(p)
+: pool(&p), name(), loggerName(), level(), parent(), resourceBundle(),
+repository(), aai(new AppenderAttachableImpl(p)), mutex(p),
+threshold(0), thresholdGeneration(0)
 {
     name = name1;
+    loggerName = new LoggerName(name1);
     additive = true;
 }
 
@@ -66,11 +115,6 @@ void Logger::addAppender(const AppenderPtr& newAppender)
    log4cxx::spi::LoggerRepository* rep = 0;
    {
         synchronized sync(mutex);
-
-        if (aai == 0)
-        {
-                  aai = new AppenderAttachableImpl(*pool);
-        }
         aai->addAppender(newAppender);
         rep = repository;
    }
@@ -84,17 +128,15 @@ void Logger::callAppenders(const spi::LoggingEventPtr& event, Pool& p) const
 {
         int writes = 0;
 
-        for(LoggerPtr logger(const_cast<Logger*>(this)); 
-          logger != 0; 
+        //
+        //   ancestors are owned by the repository and appender lists
+        //   are published as snapshots, so the walk takes no locks
+        //   and no references.
+        for(const Logger* logger = this;
+          logger != 0;
          logger = logger->parent)
         {
-                // Protected against simultaneous call to addAppender, removeAppender,...
-                synchronized sync(logger->mutex);
-
-                if (logger->aai != 0)
-                {
-                        writes += logger->aai->appendLoopOnAppenders(event, p);
-                }
+                writes += logger->aai->appendLoopOnAppenders(event, p);
 
                 if(!logger->additive)
                 {
@@ -121,28 +163,36 @@ void Logger::closeNestedAppenders()
 void Logger::forcedLog(const LevelPtr& level1, const std::string& message,
         const LocationInfo& location) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_CHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg, location));
-        callAppenders(event, p);
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, msg, location));
+        callAppenders(event, p.get());
 }
 
 
 void Logger::forcedLog(const LevelPtr& level1, const std::string& message) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_CHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg,
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, msg,
               LocationInfo::getLocationUnavailable()));
-        callAppenders(event, p);
+        callAppenders(event, p.get());
 }
 
 void Logger::forcedLogLS(const LevelPtr& level1, const LogString& message,
         const LocationInfo& location) const
 {
-        Pool p;
-        LoggingEventPtr event(new LoggingEvent(name, level1, message, location));
-        callAppenders(event, p);
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, message, location));
+        callAppenders(event, p.get());
+}
+
+void Logger::forcedLog(const LevelPtr& level1, const DeferredMessage& message,
+        const LocationInfo& location) const
+{
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, message, location));
+        callAppenders(event, p.get());
 }
 
 
@@ -153,27 +203,11 @@ bool Logger::getAdditivity() const
 
 AppenderList Logger::getAllAppenders() const
 {
-        synchronized sync(mutex);
-
-        if (aai == 0)
-        {
-                return AppenderList();
-        }
-        else
-        {
-                return aai->getAllAppenders();
-        }
+        return aai->getAllAppenders();
 }
 
 AppenderPtr Logger::getAppender(const LogString& name1) const
 {
-        synchronized sync(mutex);
-
-        if (aai == 0 || name1.empty())
-        {
-                return 0;
-        }
-
         return aai->getAppender(name1);
 }
 
@@ -253,87 +287,88 @@ LevelPtr Logger::getLevel() const
 
 bool Logger::isAttached(const AppenderPtr& appender) const
 {
-        synchronized sync(mutex);
-
-        if (appender == 0 || aai == 0)
-        {
-                return false;
-        }
-        else
-        {
-                return aai->isAttached(appender);
-        }
+        return aai->isAttached(appender);
 }
 
 bool Logger::isTraceEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::TRACE_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::TRACE_INT;
+        return isLevelEnabled(Level::TRACE_INT);
 }
 
 bool Logger::isDebugEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::DEBUG_INT))
+        return isLevelEnabled(Level::DEBUG_INT);
+}
+
+bool Logger::isEnabledFor(const LevelPtr& level1) const
+{
+        return isLevelEnabled(level1->toInt());
+}
+
+bool Logger::isLevelEnabled(int levelInt) const
+{
+        if (LOG4CXX_UNLIKELY(apr_atomic_read32(&thresholdGeneration)
+                != apr_atomic_read32(&currentThresholdGeneration)))
         {
-                return false;
+                return updateThreshold(levelInt);
         }
-
-        return getEffectiveLevel()->toInt() <= Level::DEBUG_INT;
+        return levelInt >= (int) apr_atomic_read32(&threshold);
 }
 
-bool Logger::isEnabledFor(const LevelPtr& level1) const
+bool Logger::updateThreshold(int levelInt) const
 {
-        if(repository == 0 || repository->isDisabled(level1->toInt()))
+        apr_uint32_t generation = apr_atomic_read32(&currentThresholdGeneration);
+
+        //  isDisabled performs the default configuration on first use
+        if(repository == 0 || repository->isDisabled(levelInt))
         {
                 return false;
         }
 
-        return level1->isGreaterOrEqual(getEffectiveLevel());
+        int effective = getEffectiveLevel()->toInt();
+
+        //  only a Hierarchy tells its loggers when to drop the cached value
+        Hierarchy* hierarchy = dynamic_cast<Hierarchy*>(repository);
+        if (hierarchy != 0 && hierarchy->isConfigured())
+        {
+                int repositoryThreshold = hierarchy->getThreshold()->toInt();
+                int newThreshold = (effective > repositoryThreshold) ? effective : repositoryThreshold;
+                synchronized sync(mutex);
+                //  a value computed before a configuration change is not published
+                if (apr_atomic_read32(&currentThresholdGeneration) == generation)
+                {
+                        apr_atomic_set32(&threshold, (apr_uint32_t) newThreshold);
+                        apr_atomic_set32(&thresholdGeneration, generation);
+                }
+        }
+
+        return levelInt >= effective;
+}
+
+void Logger::invalidateThresholds()
+{
+        apr_atomic_inc32(&currentThresholdGeneration);
 }
 
 
 bool Logger::isInfoEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::INFO_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::INFO_INT;
+        return isLevelEnabled(Level::INFO_INT);
 }
 
 bool Logger::isErrorEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::ERROR_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::ERROR_INT;
+        return isLevelEnabled(Level::ERROR_INT);
 }
 
 bool Logger::isWarnEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::WARN_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::WARN_INT;
+        return isLevelEnabled(Level::WARN_INT);
 }
 
 bool Logger::isFatalEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::FATAL_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::FATAL_INT;
+        return isLevelEnabled(Level::FATAL_INT);
 }
 
 /*void Logger::l7dlog(const LevelPtr& level, const String& key,
@@ -364,12 +399,7 @@ bool Logger::isFatalEnabled() const
 void Logger::l7dlog(const LevelPtr& level1, const LogString& key,
                     const LocationInfo& location, const std::vector<LogString>& params) const
 {
-        if (repository == 0 || repository->isDisabled(level1->toInt()))
-        {
-                return;
-        }
-
-        if (level1->isGreaterOrEqual(getEffectiveLevel()))
+        if (isEnabledFor(level1))
         {
                 LogString pattern = getResourceBundleString(key);
                 LogString msg;
@@ -438,35 +468,18 @@ void Logger::l7dlog(const LevelPtr& level1, const std::string& key,
 void Logger::removeAllAppenders()
 {
         synchronized sync(mutex);
-
-        if(aai != 0)
-        {
-                aai->removeAllAppenders();
-                aai = 0;
-        }
+        aai->removeAllAppenders();
 }
 
 void Logger::removeAppender(const AppenderPtr& appender)
 {
         synchronized sync(mutex);
-
-        if(appender == 0 || aai == 0)
-        {
-                return;
-        }
-
         aai->removeAppender(appender);
 }
 
 void Logger::removeAppender(const LogString& name1)
 {
         synchronized sync(mutex);
-
-        if(name1.empty() || aai == 0)
-        {
-                return;
-        }
-
         aai->removeAppender(name1);
 }
 
@@ -483,7 +496,15 @@ void Logger::setHierarchy(spi::LoggerRepository * repository1)
 
 void Logger::setLevel(const LevelPtr& level1)
 {
+        if (this->level == level1)
+        {
+                return;
+        }
+
         this->level = level1;
+
+        //  descendants inherit the level, so their thresholds are stale too
+        invalidateThresholds();
 }
 
 
@@ -622,19 +643,19 @@ LoggerPtr Logger::getLoggerLS(const LogString& name) {
 void Logger::forcedLog(const LevelPtr& level1, const std::wstring& message,
         const LocationInfo& location) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_WCHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg, location));
-        callAppenders(event, p);
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, msg, location));
+        callAppenders(event, p.get());
 }
 
 void Logger::forcedLog(const LevelPtr& level1, const std::wstring& message) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_WCHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg,
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, msg,
            LocationInfo::getLocationUnavailable()));
-        callAppenders(event, p);
+        callAppenders(event, p.get());
 }
 
 void Logger::getName(std::wstring& rv) const {
@@ -744,19 +765,19 @@ void Logger::warn(const std::wstring& msg) const {
 void Logger::forcedLog(const LevelPtr& level1, const std::basic_string<UniChar>& message,
         const LocationInfo& location) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_UNICHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg, location));
-        callAppenders(event, p);
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, msg, location));
+        callAppenders(event, p.get());
 }
 
 void Logger::forcedLog(const LevelPtr& level1, const std::basic_string<UniChar>& message) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_UNICHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg,
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, msg,
            LocationInfo::getLocationUnavailable()));
-        callAppenders(event, p);
+        callAppenders(event, p.get());
 }
 #endif
 
@@ -863,19 +884,19 @@ void Logger::warn(const std::basic_string<UniChar>& msg) const {
 void Logger::forcedLog(const LevelPtr& level1, const CFStringRef& message,
         const LocationInfo& location) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_CFSTRING(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg, location));
-        callAppenders(event, p);
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, msg, location));
+        callAppenders(event, p.get());
 }
 
 void Logger::forcedLog(const LevelPtr& level1, const CFStringRef& message) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_CFSTRING(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg,
+        LoggingEventPtr event(LoggingEvent::create(loggerName, level1, msg,
            LocationInfo::getLocationUnavailable()));
-        callAppenders(event, p);
+        callAppenders(event, p.get());
 }
 
 void Logger::getName(CFStringRef& rv) const {
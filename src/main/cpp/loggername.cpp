@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logstring.h>
+#include <log4cxx/spi/loggername.h>
+#include <log4cxx/pattern/nameabbreviator.h>
+#include <log4cxx/helpers/transcoder.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <apr_atomic.h>
+
+using namespace log4cxx;
+using namespace log4cxx::spi;
+using namespace log4cxx::helpers;
+using namespace log4cxx::pattern;
+
+IMPLEMENT_LOG4CXX_OBJECT(LoggerName)
+
+/**
+ *  Abbreviated name, entries are only added to the list and freed
+ *  with the name.  NameAbbreviator::getAbbreviator returns one
+ *  abbreviator per pattern, so the list holds at most one entry
+ *  for each pattern ever configured.
+ */
+struct LoggerName::Abbreviation {
+        Abbreviation(const NameAbbreviatorPtr& abbreviator1, const LogString& name)
+           : abbreviator(abbreviator1), value(name), next(0) {
+           abbreviator->abbreviate(0, value);
+        }
+
+        const NameAbbreviatorPtr abbreviator;
+        LogString value;
+        Abbreviation* next;
+};
+
+LoggerName::LoggerName(const LogString& name1)
+   : name(name1), utf8(), hashCode(StringHelper::hashCode(name1)), abbreviations(0) {
+   Transcoder::encodeUTF8(name, utf8);
+}
+
+LoggerName::~LoggerName() {
+   Abbreviation* abbreviation = abbreviations;
+   while (abbreviation != 0) {
+       Abbreviation* next = abbreviation->next;
+       delete abbreviation;
+       abbreviation = next;
+   }
+}
+
+const LogString& LoggerName::getAbbreviation(const NameAbbreviatorPtr& abbreviator) const {
+   Abbreviation* head = abbreviations;
+   for(Abbreviation* abbreviation = head;
+       abbreviation != 0;
+       abbreviation = abbreviation->next) {
+       if (abbreviation->abbreviator == abbreviator) {
+           return abbreviation->value;
+       }
+   }
+   Abbreviation* added = new Abbreviation(abbreviator, name);
+   while(true) {
+       added->next = head;
+       Abbreviation* previous = (Abbreviation*)
+           apr_atomic_casptr((volatile void**) &abbreviations, added, head);
+       if (previous == head) {
+           return added->value;
+       }
+       //  another thread added abbreviations, use its entry if it matches
+       for(Abbreviation* abbreviation = previous;
+           abbreviation != head;
+           abbreviation = abbreviation->next) {
+           if (abbreviation->abbreviator == abbreviator) {
+               delete added;
+               return abbreviation->value;
+           }
+       }
+       head = previous;
+   }
+}
@@ -49,7 +49,9 @@ void LoggerPatternConverter::format(
   const LoggingEventPtr& event,
   LogString& toAppendTo,
   Pool& /* p */ ) const {
-   int initialLength = toAppendTo.length();
-   toAppendTo.append(event->getLoggerName());
-   abbreviate(initialLength, toAppendTo);
+   toAppendTo.append(event->getLoggerNamePtr()->getAbbreviation(getNameAbbreviator()));
  }
+
+bool LoggerPatternConverter::requiresMDC() const {
+    return false;
+}
@@ -28,10 +28,16 @@
 #include <log4cxx/helpers/aprinitializer.h>
 #include <log4cxx/helpers/threadspecificdata.h>
 #include <log4cxx/helpers/transcoder.h>
+#include <log4cxx/helpers/deferredmessage.h>
+#include <log4cxx/helpers/clock.h>
+#include <log4cxx/helpers/synchronized.h>
+#include <log4cxx/helpers/mutex.h>
 
 #include <apr_time.h>
 #include <apr_portable.h>
 #include <apr_strings.h>
+#include <apr_atomic.h>
+#include <apr_thread_proc.h>
 #include <log4cxx/helpers/stringhelper.h>
 #include <log4cxx/helpers/objectoutputstream.h>
 #include <log4cxx/helpers/bytebuffer.h>
@@ -53,36 +59,365 @@ log4cxx_time_t LoggingEvent::getStartTime() {
 }
 
 LoggingEvent::LoggingEvent() :
+   logger(new LoggerName(LogString())),
    ndc(0),
-   mdcCopy(0),
+   mdcCopy(),
    properties(0),
    ndcLookupRequired(true),
    mdcCopyLookupRequired(true),
+   deferredStorage(0),
+   deferred(0),
+   rendering(0),
    timeStamp(0),
-   locationInfo() {
+   timeStampInCycles(0),
+   locationInfo(),
+   pooled(false) {
 }
 
 LoggingEvent::LoggingEvent(
         const LogString& logger1, const LevelPtr& level1,
         const LogString& message1, const LocationInfo& locationInfo1) :
+   logger(new LoggerName(logger1)),
+   level(level1),
+   ndc(0),
+   mdcCopy(),
+   properties(0),
+   ndcLookupRequired(true),
+   mdcCopyLookupRequired(true),
+   message(message1),
+   deferredStorage(0),
+   deferred(0),
+   rendering(0),
+   timeStamp(0),
+   timeStampInCycles(0),
+   locationInfo(locationInfo1),
+   threadName(getCurrentThreadName()),
+   pooled(false) {
+   readClock();
+}
+
+LoggingEvent::LoggingEvent(
+        const LoggerNamePtr& logger1, const LevelPtr& level1,
+        const LogString& message1, const LocationInfo& locationInfo1) :
    logger(logger1),
    level(level1),
    ndc(0),
-   mdcCopy(0),
+   mdcCopy(),
    properties(0),
    ndcLookupRequired(true),
    mdcCopyLookupRequired(true),
    message(message1),
-   timeStamp(apr_time_now()),
+   deferredStorage(0),
+   deferred(0),
+   rendering(0),
+   timeStamp(0),
+   timeStampInCycles(0),
+   locationInfo(locationInfo1),
+   threadName(getCurrentThreadName()),
+   pooled(false) {
+   readClock();
+}
+
+LoggingEvent::LoggingEvent(
+        const LoggerNamePtr& logger1, const LevelPtr& level1,
+        log4cxx_time_t timeStamp1, const LogString& message1,
+        const LogString& threadName1, const LogString* ndc1,
+        const MDC::Map& mdc1, const LocationInfo& locationInfo1) :
+   logger(logger1),
+   level(level1),
+   ndc(ndc1 == 0 ? 0 : new LogString(*ndc1)),
+   mdcCopy(mdc1.empty() ? 0 : new MDCSnapshot(mdc1)),
+   properties(0),
+   ndcLookupRequired(false),
+   mdcCopyLookupRequired(false),
+   message(message1),
+   deferredStorage(0),
+   deferred(0),
+   rendering(0),
+   timeStamp(timeStamp1),
+   timeStampInCycles(0),
+   locationInfo(locationInfo1),
+   threadName(threadName1),
+   pooled(false) {
+}
+
+LoggingEvent::LoggingEvent(
+        const LogString& logger1, const LevelPtr& level1,
+        const DeferredMessage& message1, const LocationInfo& locationInfo1) :
+   logger(new LoggerName(logger1)),
+   level(level1),
+   ndc(0),
+   mdcCopy(),
+   properties(0),
+   ndcLookupRequired(true),
+   mdcCopyLookupRequired(true),
+   message(),
+   deferredStorage(new DeferredMessage(message1)),
+   deferred(deferredStorage),
+   rendering(0),
+   timeStamp(0),
+   timeStampInCycles(0),
    locationInfo(locationInfo1),
-   threadName(getCurrentThreadName()) {
+   threadName(getCurrentThreadName()),
+   pooled(false) {
+   readClock();
 }
 
 LoggingEvent::~LoggingEvent()
 {
         delete ndc;
-        delete mdcCopy;
         delete properties;
+        delete deferredStorage;
+}
+
+namespace {
+    /**
+     *  Number of released events kept by each thread.
+     */
+    const size_t THREAD_CACHE_SIZE = 64;
+    /**
+     *  Number of events moved at a time between a thread
+     *  and the shared list.
+     */
+    const size_t TRANSFER_SIZE = THREAD_CACHE_SIZE / 2;
+    /**
+     *  Number of events kept in the shared list, typically
+     *  released by the dispatcher of an AsyncAppender.
+     */
+    const size_t SHARED_CACHE_SIZE = 4096;
+    /**
+     *  Message capacity above which the message is
+     *  freed rather than kept with a recycled event.
+     */
+    const size_t MAX_RETAINED_CAPACITY = 1024;
+
+    bool sharedEventsDestroyed = false;
+
+    class SharedEvents {
+    public:
+        SharedEvents() : mutex(APRInitializer::getRootPool()), events() {
+        }
+
+        ~SharedEvents() {
+            sharedEventsDestroyed = true;
+            for(std::vector<LoggingEvent*>::iterator iter = events.begin();
+                iter != events.end();
+                iter++) {
+                delete *iter;
+            }
+        }
+
+        Mutex mutex;
+        std::vector<LoggingEvent*> events;
+
+    private:
+        SharedEvents(const SharedEvents&);
+        SharedEvents& operator=(const SharedEvents&);
+    };
+
+    SharedEvents* getSharedEvents() {
+        static SharedEvents shared;
+        if (sharedEventsDestroyed) {
+            return 0;
+        }
+        return &shared;
+    }
+}
+
+LoggingEvent* LoggingEvent::acquire(const LoggerNamePtr& logger1,
+        const LevelPtr& level1, const LocationInfo& locationInfo1)
+{
+        LoggingEvent* event = 0;
+        std::vector<LoggingEvent*>* cache = ThreadSpecificData::getEventCache();
+        if (cache != 0) {
+            if (cache->empty()) {
+                SharedEvents* shared = getSharedEvents();
+                if (shared != 0) {
+                    synchronized sync(shared->mutex);
+                    size_t count = shared->events.size();
+                    if (count > TRANSFER_SIZE) {
+                        count = TRANSFER_SIZE;
+                    }
+                    cache->insert(cache->end(), shared->events.end() - count, shared->events.end());
+                    shared->events.resize(shared->events.size() - count);
+                }
+            }
+            if (!cache->empty()) {
+                event = cache->back();
+                cache->pop_back();
+            }
+        }
+        if (event == 0) {
+            event = new LoggingEvent();
+            event->pooled = true;
+        }
+        event->logger = logger1;
+        event->level = level1;
+        event->readClock();
+        event->locationInfo = locationInfo1;
+        event->threadName = ThreadSpecificData::getThreadName();
+        return event;
+}
+
+LoggingEventPtr LoggingEvent::create(const LogString& logger1,
+        const LevelPtr& level1, const LogString& message1,
+        const LocationInfo& locationInfo1)
+{
+        return create(LoggerNamePtr(new LoggerName(logger1)), level1, message1, locationInfo1);
+}
+
+LoggingEventPtr LoggingEvent::create(const LogString& logger1,
+        const LevelPtr& level1, const DeferredMessage& message1,
+        const LocationInfo& locationInfo1)
+{
+        return create(LoggerNamePtr(new LoggerName(logger1)), level1, message1, locationInfo1);
+}
+
+LoggingEventPtr LoggingEvent::create(const LoggerNamePtr& logger1,
+        const LevelPtr& level1, const LogString& message1,
+        const LocationInfo& locationInfo1)
+{
+        LoggingEvent* event = acquire(logger1, level1, locationInfo1);
+        event->message.assign(message1);
+        return event;
+}
+
+LoggingEventPtr LoggingEvent::create(const LoggerNamePtr& logger1,
+        const LevelPtr& level1, const DeferredMessage& message1,
+        const LocationInfo& locationInfo1)
+{
+        LoggingEvent* event = acquire(logger1, level1, locationInfo1);
+        if (event->deferredStorage == 0) {
+            event->deferredStorage = new DeferredMessage(message1);
+        } else {
+            *event->deferredStorage = message1;
+        }
+        event->message.erase();
+        event->deferred = event->deferredStorage;
+        return event;
+}
+
+void LoggingEvent::releaseRef() const
+{
+        if (apr_atomic_dec32(&ref) == 0)
+        {
+                if (pooled) {
+                    recycle(const_cast<LoggingEvent*>(this));
+                } else {
+                    delete this;
+                }
+        }
+}
+
+void LoggingEvent::recycle(LoggingEvent* event)
+{
+        delete event->ndc;
+        event->ndc = 0;
+        event->ndcLookupRequired = true;
+        event->mdcCopy = 0;
+        event->mdcCopyLookupRequired = true;
+        delete event->properties;
+        event->properties = 0;
+        event->deferred = 0;
+        if (event->message.capacity() > MAX_RETAINED_CAPACITY) {
+            LogString().swap(event->message);
+        }
+
+        std::vector<LoggingEvent*>* cache = ThreadSpecificData::getEventCache();
+        if (cache != 0 && cache->size() < THREAD_CACHE_SIZE) {
+            cache->push_back(event);
+            return;
+        }
+        SharedEvents* shared = getSharedEvents();
+        if (shared != 0) {
+            synchronized sync(shared->mutex);
+            if (shared->events.size() < SHARED_CACHE_SIZE) {
+                shared->events.push_back(event);
+                event = 0;
+            }
+            if (cache != 0) {
+                size_t count = TRANSFER_SIZE;
+                if (count > SHARED_CACHE_SIZE - shared->events.size()) {
+                    count = SHARED_CACHE_SIZE - shared->events.size();
+                }
+                shared->events.insert(shared->events.end(), cache->end() - count, cache->end());
+                cache->resize(cache->size() - count);
+            }
+        }
+        if (event != 0) {
+            if (cache != 0 && cache->size() < THREAD_CACHE_SIZE) {
+                cache->push_back(event);
+            } else {
+                delete event;
+            }
+        }
+}
+
+void LoggingEvent::renderMessage() const
+{
+        if (apr_atomic_cas32(&rendering, 1, 0) == 0)
+        {
+                DeferredMessage* current = deferred;
+                if (current != 0)
+                {
+                        try
+                        {
+                                current->format(message);
+                        }
+                        catch(std::exception& e)
+                        {
+                                //  publish a placeholder so that other
+                                //  threads do not wait for the message forever
+                                message.erase(message.begin(), message.end());
+                                try
+                                {
+                                        message.append(LOG4CXX_STR("[message could not be formatted]"));
+                                        LogLog::error(LOG4CXX_STR("Could not format message of logging event."), e);
+                                }
+                                catch(std::exception&)
+                                {
+                                }
+                        }
+                        apr_atomic_xchgptr((volatile void**) &deferred, 0);
+                }
+                apr_atomic_set32(&rendering, 0);
+        }
+        else
+        {
+                //  another thread is formatting the message
+                while (apr_atomic_casptr((volatile void**) &deferred, 0, 0) != 0)
+                {
+                        apr_thread_yield();
+                }
+        }
+}
+
+void LoggingEvent::readClock()
+{
+        bool cycles = false;
+        timeStamp = Clock::read(cycles);
+        timeStampInCycles = cycles ? 1 : 0;
+}
+
+log4cxx_time_t LoggingEvent::convertTimeStamp() const
+{
+        //
+        //   converted once, so the time stamp does not move
+        //   when the clock is recalibrated later
+        if (apr_atomic_cas32(&timeStampInCycles, 2, 1) == 1)
+        {
+                timeStamp = Clock::toTime(timeStamp);
+                apr_atomic_set32(&timeStampInCycles, 0);
+        }
+        else
+        {
+                //  another thread is converting the time stamp
+                while (apr_atomic_read32(&timeStampInCycles) != 0)
+                {
+                        apr_thread_yield();
+                }
+        }
+        return timeStamp;
 }
 
 bool LoggingEvent::getNDC(LogString& dest) const
@@ -106,11 +441,12 @@ bool LoggingEvent::getMDC(const LogString& key, LogString& dest) const
 {
    // Note the mdcCopy is used if it exists. Otherwise we use the MDC
     // that is associated with the thread.
-    if (mdcCopy != 0 && !mdcCopy->empty())
+    if (mdcCopy != 0)
         {
-                MDC::Map::const_iterator it = mdcCopy->find(key);
+                const MDC::Map& map = mdcCopy->getMap();
+                MDC::Map::const_iterator it = map.find(key);
 
-                if (it != mdcCopy->end())
+                if (it != map.end())
                 {
                         if (!it->second.empty())
                         {
@@ -128,10 +464,11 @@ LoggingEvent::KeySet LoggingEvent::getMDCKeySet() const
 {
         LoggingEvent::KeySet set;
 
-        if (mdcCopy != 0 && !mdcCopy->empty())
+        if (mdcCopy != 0)
         {
+                const MDC::Map& map = mdcCopy->getMap();
                 MDC::Map::const_iterator it;
-                for (it = mdcCopy->begin(); it != mdcCopy->end(); it++)
+                for (it = map.begin(); it != map.end(); it++)
                 {
                         set.push_back(it->first);
 
@@ -139,9 +476,9 @@ LoggingEvent::KeySet LoggingEvent::getMDCKeySet() const
         }
         else
         {
-                ThreadSpecificData* data = ThreadSpecificData::getCurrentData();
+                const ThreadSpecificData* data = ThreadSpecificData::getCurrentData();
                 if (data != 0) {
-                    MDC::Map& m = data->getMap();
+                    const MDC::Map& m = data->getMap();
 
                     for(MDC::Map::const_iterator it = m.begin(); it != m.end(); it++) {
                         set.push_back(it->first);
@@ -157,13 +494,8 @@ void LoggingEvent::getMDCCopy() const
         if(mdcCopyLookupRequired)
         {
                 mdcCopyLookupRequired = false;
-                // the clone call is required for asynchronous logging.
-                ThreadSpecificData* data = ThreadSpecificData::getCurrentData();
-                if (data != 0) {
-                    mdcCopy = new MDC::Map(data->getMap());
-                } else {
-                    mdcCopy = new MDC::Map();
-                }
+                // the copy is required for asynchronous logging.
+                mdcCopy = ThreadSpecificData::getMDCSnapshot();
        }
 }
 
@@ -203,23 +535,7 @@ LoggingEvent::KeySet LoggingEvent::getPropertyKeySet() const
 
 
 const LogString LoggingEvent::getCurrentThreadName() {
-#if APR_HAS_THREADS
-#if defined(_WIN32)
-   char result[20];
-   DWORD threadId = GetCurrentThreadId();
-   apr_snprintf(result, sizeof(result), LOG4CXX_WIN32_THREAD_FMTSPEC, threadId);
-#else
-   // apr_os_thread_t encoded in HEX takes needs as many characters
-   // as two times the size of the type, plus an additional null byte.
-   char result[sizeof(apr_os_thread_t) * 3 + 10];
-   apr_os_thread_t threadId = apr_os_thread_current();
-   apr_snprintf(result, sizeof(result), LOG4CXX_APR_THREAD_FMTSPEC, (void*) &threadId);
-#endif
-   LOG4CXX_DECODE_CHAR(str, (const char*) result);
-   return str;
-#else
-   return LOG4CXX_STR("0x00000000");
-#endif
+   return ThreadSpecificData::getThreadName();
 }
 
 
@@ -300,20 +616,20 @@ void LoggingEvent::write(helpers::ObjectOutputStream& os, Pool& p) const {
       // mdc and ndc lookup required should always be false
       char lookupsRequired[] = { 0, 0 };
       os.writeBytes(lookupsRequired, sizeof(lookupsRequired), p);
-      os.writeLong(timeStamp/1000, p);
-      os.writeObject(logger, p);
+      os.writeLong(getTimeStamp()/1000, p);
+      os.writeObject(*logger, p);
       locationInfo.write(os, p);
-      if (mdcCopy == 0 || mdcCopy->size() == 0) {
+      if (mdcCopy == 0) {
           os.writeNull(p);
       } else {
-          os.writeObject(*mdcCopy, p);
+          os.writeObject(mdcCopy->getMap(), p);
       }
       if (ndc == 0) {
           os.writeNull(p);
       } else {
           os.writeObject(*ndc, p);
       }
-      os.writeObject(message, p);
+      os.writeObject(getMessage(), p);
       os.writeObject(threadName, p);
       //  throwable
       os.writeNull(p);
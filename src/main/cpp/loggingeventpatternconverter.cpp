@@ -47,3 +47,7 @@ void LoggingEventPatternConverter::format(const ObjectPtr& obj,
 bool LoggingEventPatternConverter::handlesThrowable() const {
     return false;
 }
+
+bool LoggingEventPatternConverter::requiresMDC() const {
+    return true;
+}
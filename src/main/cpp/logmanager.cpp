@@ -31,8 +31,10 @@
 #include <log4cxx/helpers/exception.h>
 #include <log4cxx/helpers/optionconverter.h>
 #include <log4cxx/helpers/loglog.h>
+#include <log4cxx/asyncappender.h>
 
 #include <apr_general.h>
+#include <apr_time.h>
 
 #include <log4cxx/spi/loggingevent.h>
 #include <log4cxx/file.h>
@@ -49,6 +51,7 @@ using namespace log4cxx::helpers;
 IMPLEMENT_LOG4CXX_OBJECT(DefaultRepositorySelector)
 
 void * LogManager::guard = 0;
+volatile int LogManager::shutdownTimeout = -1;
 
 
 
@@ -202,9 +205,45 @@ LoggerList LogManager::getCurrentLoggers()
 
 void LogManager::shutdown()
 {
+        int timeout = shutdownTimeout;
+        if (timeout >= 0)
+        {
+                //
+                //   asynchronous appenders share the deadline, the
+                //   repository then closes the other appenders.
+                //
+                log4cxx_time_t deadline = apr_time_now() + (log4cxx_time_t) timeout * 1000;
+                LoggerList loggers = getCurrentLoggers();
+                loggers.push_back(getRootLogger());
+                for (LoggerList::iterator it = loggers.begin(); it != loggers.end(); it++)
+                {
+                        AppenderList appenders = (*it)->getAllAppenders();
+                        for (AppenderList::iterator iter = appenders.begin();
+                             iter != appenders.end();
+                             iter++)
+                        {
+                                AsyncAppenderPtr async(*iter);
+                                if (async != 0)
+                                {
+                                        log4cxx_time_t remaining = deadline - apr_time_now();
+                                        async->close(remaining > 0 ? (int) (remaining / 1000) : 0);
+                                }
+                        }
+                }
+        }
         getLoggerRepository()->shutdown();
 }
 
+void LogManager::setShutdownTimeout(int timeout)
+{
+        shutdownTimeout = timeout;
+}
+
+int LogManager::getShutdownTimeout()
+{
+        return shutdownTimeout;
+}
+
 void LogManager::resetConfiguration()
 {
         getLoggerRepository()->resetConfiguration();
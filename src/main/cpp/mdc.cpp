@@ -56,9 +56,10 @@ bool MDC::get(const LogString& key, LogString& value)
 {
         ThreadSpecificData* data = ThreadSpecificData::getCurrentData();
         if (data != 0) {
-            Map& map = data->getMap();
+            const ThreadSpecificData& current = *data;
+            const Map& map = current.getMap();
 
-            Map::iterator it = map.find(key);
+            Map::const_iterator it = map.find(key);
             if (it != map.end()) {
                 value.append(it->second);
                 return true;
@@ -81,18 +82,7 @@ std::string MDC::get(const std::string& key)
 
 bool MDC::remove(const LogString& key, LogString& value)
 {
-        ThreadSpecificData* data = ThreadSpecificData::getCurrentData();
-        if (data != 0) {
-            Map& map = data->getMap();
-            Map::iterator it;
-            if ((it = map.find(key)) != map.end()) {
-                value = it->second;
-                map.erase(it);
-                data->recycle();
-                return true;
-            }
-        }
-        return false;
+        return ThreadSpecificData::remove(key, value);
 }
 
 std::string MDC::remove(const std::string& key)
@@ -109,12 +99,7 @@ std::string MDC::remove(const std::string& key)
 
 void MDC::clear()
 {
-        ThreadSpecificData* data = ThreadSpecificData::getCurrentData();
-        if (data != 0) {
-            Map& map = data->getMap();
-            map.erase(map.begin(), map.end());
-            data->recycle();
-        }
+        ThreadSpecificData::clearMap();
 }
 
 
@@ -17,21 +17,79 @@
 
 #include <log4cxx/helpers/messagebuffer.h>
 #include <log4cxx/helpers/transcoder.h>
+#include <log4cxx/helpers/threadspecificdata.h>
 
 using namespace log4cxx::helpers;
 
-CharMessageBuffer::CharMessageBuffer() : stream(0) {}
+MessageBufferCache::MessageBufferCache() : charStorage(0)
+#if LOG4CXX_WCHAR_T_API
+   , wideStorage(0)
+#endif
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API || LOG4CXX_LOGCHAR_IS_UNICHAR
+   , uniStorage(0)
+#endif
+{
+}
+
+MessageBufferCache::~MessageBufferCache() {
+   delete charStorage;
+#if LOG4CXX_WCHAR_T_API
+   delete wideStorage;
+#endif
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API || LOG4CXX_LOGCHAR_IS_UNICHAR
+   delete uniStorage;
+#endif
+}
+
+namespace {
+   /**
+    *  Takes the storage of the current thread or, if it is in use
+    *  by an enclosing logging statement, creates private storage.
+    */
+   template<class T>
+   MessageBufferStorage<T>* acquireStorage(MessageBufferStorage<T>* MessageBufferCache::* slot) {
+      MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+      if (cache != 0) {
+         MessageBufferStorage<T>*& cached = cache->*slot;
+         if (cached == 0) {
+            cached = new MessageBufferStorage<T>(true);
+         }
+         if (!cached->inUse) {
+            cached->inUse = true;
+            return cached;
+         }
+      }
+      return new MessageBufferStorage<T>(false);
+   }
+
+   template<class T>
+   void releaseStorage(MessageBufferStorage<T>* storage) {
+      if (storage != 0) {
+         if (storage->cached) {
+            storage->reset();
+            storage->inUse = false;
+         } else {
+            delete storage;
+         }
+      }
+   }
+}
+
+CharMessageBuffer::CharMessageBuffer() : storage(0), streamUsed(false) {}
 
 CharMessageBuffer::~CharMessageBuffer() {
-   delete stream;
+   releaseStorage(storage);
 }
 
-CharMessageBuffer& CharMessageBuffer::operator<<(const std::basic_string<char>& msg) {
-   if (stream == 0) {
-      buf.append(msg);
-   } else {
-      *stream << msg;
+std::basic_string<char>& CharMessageBuffer::buffer() {
+   if (storage == 0) {
+      storage = acquireStorage(&MessageBufferCache::charStorage);
    }
+   return storage->buf;
+}
+
+CharMessageBuffer& CharMessageBuffer::operator<<(const std::basic_string<char>& msg) {
+   buffer().append(msg);
    return *this;
 }
 
@@ -40,11 +98,7 @@ CharMessageBuffer& CharMessageBuffer::operator<<(const char* msg) {
    if (actualMsg == 0) {
       actualMsg = "null";
    }
-   if (stream == 0) {
-      buf.append(actualMsg);
-   } else {
-      *stream << actualMsg;
-   }
+   buffer().append(actualMsg);
    return *this;
 }
 CharMessageBuffer& CharMessageBuffer::operator<<(char* msg) {
@@ -52,36 +106,26 @@ CharMessageBuffer& CharMessageBuffer::operator<<(char* msg) {
 }
 
 CharMessageBuffer& CharMessageBuffer::operator<<(const char msg) {
-   if (stream == 0) {
-      buf.append(1, msg);
-   } else {
-      buf.assign(1, msg);
-      *stream << buf;
-   }
+   buffer().append(1, msg);
    return *this;
 }
 
 CharMessageBuffer::operator std::basic_ostream<char>&() {
-   if (stream == 0) {
-     stream = new std::basic_ostringstream<char>();
-     if (!buf.empty()) {
-        *stream << buf;
-     }
-   }
-   return *stream;
+   buffer();
+   streamUsed = true;
+   return storage->stream;
 }
 
 const std::basic_string<char>& CharMessageBuffer::str(std::basic_ostream<char>&) {
-   buf = stream->str();
-   return buf;
+   return buffer();
 }
 
 const std::basic_string<char>& CharMessageBuffer::str(CharMessageBuffer&) {
-   return buf;
+   return buffer();
 }
 
 bool CharMessageBuffer::hasStream() const {
-    return (stream != 0);
+    return streamUsed;
 }
 
 std::ostream& CharMessageBuffer::operator<<(ios_base_manip manip) {
@@ -103,18 +147,21 @@ std::ostream& CharMessageBuffer::operator<<(void* val) { return ((std::ostream&)
 
 
 #if LOG4CXX_WCHAR_T_API
-WideMessageBuffer::WideMessageBuffer() : stream(0) {}
+WideMessageBuffer::WideMessageBuffer() : storage(0), streamUsed(false) {}
 
 WideMessageBuffer::~WideMessageBuffer() {
-   delete stream;
+   releaseStorage(storage);
 }
 
-WideMessageBuffer& WideMessageBuffer::operator<<(const std::basic_string<wchar_t>& msg) {
-   if (stream == 0) {
-      buf.append(msg);
-   } else {
-      *stream << msg;
+std::basic_string<wchar_t>& WideMessageBuffer::buffer() {
+   if (storage == 0) {
+      storage = acquireStorage(&MessageBufferCache::wideStorage);
    }
+   return storage->buf;
+}
+
+WideMessageBuffer& WideMessageBuffer::operator<<(const std::basic_string<wchar_t>& msg) {
+   buffer().append(msg);
    return *this;
 }
 
@@ -123,11 +170,7 @@ WideMessageBuffer& WideMessageBuffer::operator<<(const wchar_t* msg) {
    if (actualMsg == 0) {
       actualMsg = L"null";
    }
-   if (stream == 0) {
-      buf.append(actualMsg);
-   } else {
-      *stream << actualMsg;
-   }
+   buffer().append(actualMsg);
    return *this;
 }
 
@@ -136,36 +179,26 @@ WideMessageBuffer& WideMessageBuffer::operator<<(wchar_t* msg) {
 }
 
 WideMessageBuffer& WideMessageBuffer::operator<<(const wchar_t msg) {
-   if (stream == 0) {
-      buf.append(1, msg);
-   } else {
-      buf.assign(1, msg);
-      *stream << buf;
-   }
+   buffer().append(1, msg);
    return *this;
 }
 
 WideMessageBuffer::operator std::basic_ostream<wchar_t>&() {
-   if (stream == 0) {
-     stream = new std::basic_ostringstream<wchar_t>();
-     if (!buf.empty()) {
-        *stream << buf;
-     }
-   }
-   return *stream;
+   buffer();
+   streamUsed = true;
+   return storage->stream;
 }
 
 const std::basic_string<wchar_t>& WideMessageBuffer::str(std::basic_ostream<wchar_t>&) {
-   buf = stream->str();
-   return buf;
+   return buffer();
 }
 
 const std::basic_string<wchar_t>& WideMessageBuffer::str(WideMessageBuffer&) {
-   return buf;
+   return buffer();
 }
 
 bool WideMessageBuffer::hasStream() const {
-    return (stream != 0);
+    return streamUsed;
 }
 
 std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(ios_base_manip manip) {
@@ -186,24 +219,16 @@ std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(long double val) { re
 std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(void* val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
 
 
-MessageBuffer::MessageBuffer()  : wbuf(0)
-#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
-   , ubuf(0)
-#endif   
-{
+MessageBuffer::MessageBuffer() {
 }
 
 MessageBuffer::~MessageBuffer() {
-    delete wbuf;
-#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
-    delete ubuf;
-#endif   
 }
 
 bool MessageBuffer::hasStream() const {
-    bool retval = cbuf.hasStream() || (wbuf != 0 && wbuf->hasStream());
+    bool retval = cbuf.hasStream() || wbuf.hasStream();
 #if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
-    retval = retval || (ubuf != 0 && ubuf->hasStream());    
+    retval = retval || ubuf.hasStream();
 #endif   
     return retval;
 }
@@ -242,30 +267,26 @@ const std::string& MessageBuffer::str(std::ostream& os) {
 }
 
 WideMessageBuffer& MessageBuffer::operator<<(const std::wstring& msg) {
-   wbuf = new WideMessageBuffer();
-   return (*wbuf) << msg;
+   return wbuf << msg;
 }
 
 WideMessageBuffer& MessageBuffer::operator<<(const wchar_t* msg) {
-   wbuf = new WideMessageBuffer();
-   return (*wbuf) << msg;
+   return wbuf << msg;
 }
 WideMessageBuffer& MessageBuffer::operator<<(wchar_t* msg) {
-   wbuf = new WideMessageBuffer();
-   return (*wbuf) << (const wchar_t*) msg;
+   return wbuf << (const wchar_t*) msg;
 }
 
 WideMessageBuffer& MessageBuffer::operator<<(const wchar_t msg) {
-   wbuf = new WideMessageBuffer();
-   return (*wbuf) << msg;
+   return wbuf << msg;
 }
 
 const std::wstring& MessageBuffer::str(WideMessageBuffer& buf) {
-   return wbuf->str(buf);
+   return wbuf.str(buf);
 }
 
 const std::wstring& MessageBuffer::str(std::basic_ostream<wchar_t>& os) {
-   return wbuf->str(os);
+   return wbuf.str(os);
 }
 
 std::ostream& MessageBuffer::operator<<(bool val) { return cbuf.operator<<(val); }
@@ -285,46 +306,45 @@ std::ostream& MessageBuffer::operator<<(void* val) { return cbuf.operator<<(val)
 
 #if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
 UniCharMessageBuffer& MessageBuffer::operator<<(const std::basic_string<log4cxx::UniChar>& msg) {
-   ubuf = new UniCharMessageBuffer();
-   return (*ubuf) << msg;
+   return ubuf << msg;
 }
 
 UniCharMessageBuffer& MessageBuffer::operator<<(const log4cxx::UniChar* msg) {
-   ubuf = new UniCharMessageBuffer();
-   return (*ubuf) << msg;
+   return ubuf << msg;
 }
 UniCharMessageBuffer& MessageBuffer::operator<<(log4cxx::UniChar* msg) {
-   ubuf = new UniCharMessageBuffer();
-   return (*ubuf) << (const log4cxx::UniChar*) msg;
+   return ubuf << (const log4cxx::UniChar*) msg;
 }
 
 UniCharMessageBuffer& MessageBuffer::operator<<(const log4cxx::UniChar msg) {
-   ubuf = new UniCharMessageBuffer();
-   return (*ubuf) << msg;
+   return ubuf << msg;
 }
 
 const std::basic_string<log4cxx::UniChar>& MessageBuffer::str(UniCharMessageBuffer& buf) {
-   return ubuf->str(buf);
+   return ubuf.str(buf);
 }
 
 const std::basic_string<log4cxx::UniChar>& MessageBuffer::str(std::basic_ostream<log4cxx::UniChar>& os) {
-   return ubuf->str(os);
+   return ubuf.str(os);
 }
 
 
-UniCharMessageBuffer::UniCharMessageBuffer() : stream(0) {}
+UniCharMessageBuffer::UniCharMessageBuffer() : storage(0), streamUsed(false) {}
 
 UniCharMessageBuffer::~UniCharMessageBuffer() {
-   delete stream;
+   releaseStorage(storage);
+}
+
+std::basic_string<log4cxx::UniChar>& UniCharMessageBuffer::buffer() {
+   if (storage == 0) {
+      storage = acquireStorage(&MessageBufferCache::uniStorage);
+   }
+   return storage->buf;
 }
 
 
 UniCharMessageBuffer& UniCharMessageBuffer::operator<<(const std::basic_string<log4cxx::UniChar>& msg) {
-   if (stream == 0) {
-        buf.append(msg);
-   } else {
-      *stream << buf;
-   }
+   buffer().append(msg);
    return *this;
 }
 
@@ -334,11 +354,7 @@ UniCharMessageBuffer& UniCharMessageBuffer::operator<<(const log4cxx::UniChar* m
    if (actualMsg == 0) {
       actualMsg = nullLiteral;
    }
-   if (stream == 0) {
-        buf.append(actualMsg);
-   } else {
-      *stream << actualMsg;
-   }
+   buffer().append(actualMsg);
    return *this;
 }
 
@@ -347,35 +363,26 @@ UniCharMessageBuffer& UniCharMessageBuffer::operator<<(log4cxx::UniChar* msg) {
 }
 
 UniCharMessageBuffer& UniCharMessageBuffer::operator<<(const log4cxx::UniChar msg) {
-   if (stream == 0) {
-        buf.append(1, msg);
-   } else {
-      *stream << msg;
-   }
+   buffer().append(1, msg);
    return *this;
 }
 
 UniCharMessageBuffer::operator UniCharMessageBuffer::uostream&() {
-   if (stream == 0) {
-     stream = new std::basic_ostringstream<UniChar>();
-     if (!buf.empty()) {
-        *stream << buf;
-     }
-   }
-   return *stream;
+   buffer();
+   streamUsed = true;
+   return storage->stream;
 }
 
 const std::basic_string<log4cxx::UniChar>& UniCharMessageBuffer::str(UniCharMessageBuffer::uostream&) {
-    buf = stream->str();
-   return buf;
+   return buffer();
 }
 
 const std::basic_string<log4cxx::UniChar>& UniCharMessageBuffer::str(UniCharMessageBuffer&) {
-   return buf;
+   return buffer();
 }
 
 bool UniCharMessageBuffer::hasStream() const {
-    return (stream != 0);
+    return streamUsed;
 }
 
 UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(ios_base_manip manip) {
@@ -411,20 +418,14 @@ UniCharMessageBuffer& UniCharMessageBuffer::operator<<(const CFStringRef& msg) {
          size_t length = CFStringGetLength(msg);
          std::vector<log4cxx::UniChar> tmp(length);
          CFStringGetCharacters(msg, CFRangeMake(0, length), &tmp[0]);
-         if (stream) {
-            std::basic_string<UniChar> s(&tmp[0], tmp.size());
-            *stream << s;
-         } else {
-            buf.append(&tmp[0], tmp.size());
-        }
+         buffer().append(&tmp[0], tmp.size());
     }
    return *this;
 }
 
 
 UniCharMessageBuffer& MessageBuffer::operator<<(const CFStringRef& msg) {
-   ubuf = new UniCharMessageBuffer();
-   return (*ubuf) << msg;
+   return ubuf << msg;
 }
 #endif
 
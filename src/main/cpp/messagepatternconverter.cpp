@@ -50,3 +50,6 @@ void MessagePatternConverter::format(
    toAppendTo.append(event->getRenderedMessage());
  }
 
+bool MessagePatternConverter::requiresMDC() const {
+    return false;
+}
@@ -49,3 +49,7 @@ void MethodLocationPatternConverter::format(
   Pool& /* p */ ) const {
    append(toAppendTo, event->getLocationInformation().getMethodName());
  }
+
+bool MethodLocationPatternConverter::requiresMDC() const {
+    return false;
+}
@@ -18,7 +18,14 @@
 #include <log4cxx/pattern/nameabbreviator.h>
 #include <log4cxx/helpers/exception.h>
 #include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/mutex.h>
+#include <log4cxx/helpers/synchronized.h>
+#if !defined(LOG4CXX)
+#define LOG4CXX 1
+#endif
+#include <log4cxx/helpers/aprinitializer.h>
 #include <vector>
+#include <map>
 #include <limits.h>
 
 using namespace log4cxx;
@@ -236,15 +243,66 @@ IMPLEMENT_LOG4CXX_OBJECT(MaxElementAbbreviator)
 IMPLEMENT_LOG4CXX_OBJECT(PatternAbbreviator)
 
 
+namespace {
+    bool sharedAbbreviatorsDestroyed = false;
+
+    /**
+     *  Abbreviators by pattern.
+     */
+    class SharedAbbreviators {
+    public:
+        SharedAbbreviators() : mutex(APRInitializer::getRootPool()), abbreviators() {
+        }
+
+        ~SharedAbbreviators() {
+            sharedAbbreviatorsDestroyed = true;
+        }
+
+        Mutex mutex;
+        std::map<LogString, NameAbbreviatorPtr> abbreviators;
+
+    private:
+        SharedAbbreviators(const SharedAbbreviators&);
+        SharedAbbreviators& operator=(const SharedAbbreviators&);
+    };
+
+    SharedAbbreviators* getSharedAbbreviators() {
+        static SharedAbbreviators shared;
+        if (sharedAbbreviatorsDestroyed) {
+            return 0;
+        }
+        return &shared;
+    }
+
+    NameAbbreviatorPtr createAbbreviator(const LogString& pattern);
+}
 
 NameAbbreviatorPtr NameAbbreviator::getAbbreviator(const LogString& pattern) {
+    SharedAbbreviators* shared = getSharedAbbreviators();
+    if (shared == 0) {
+        return createAbbreviator(pattern);
+    }
+    //
+    //   one instance per pattern, so the abbreviations kept by
+    //   LoggerName are reused when a layout is activated again
+    //
+    synchronized sync(shared->mutex);
+    NameAbbreviatorPtr& abbreviator = shared->abbreviators[pattern];
+    if (abbreviator == 0) {
+        abbreviator = createAbbreviator(pattern);
+    }
+    return abbreviator;
+}
+
+namespace {
+NameAbbreviatorPtr createAbbreviator(const LogString& pattern) {
     if (pattern.length() > 0) {
       //  if pattern is just spaces and numbers then
       //     use MaxElementAbbreviator
       LogString trimmed(StringHelper::trim(pattern));
 
       if (trimmed.length() == 0) {
-        return getDefaultAbbreviator();
+        return NameAbbreviator::getDefaultAbbreviator();
       }
 
       LogString::size_type i = 0;
@@ -310,8 +368,9 @@ NameAbbreviatorPtr NameAbbreviator::getAbbreviator(const LogString& pattern) {
     //
     //  no matching abbreviation, return defaultAbbreviator
     //
-    return getDefaultAbbreviator();
+    return NameAbbreviator::getDefaultAbbreviator();
   }
+}
 
   /**
    * Gets default abbreviator.
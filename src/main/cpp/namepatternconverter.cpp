@@ -54,3 +54,7 @@ NameAbbreviatorPtr NamePatternConverter::getAbbreviator(
 void NamePatternConverter::abbreviate(int nameStart, LogString& buf) const {
     abbreviator->abbreviate(nameStart, buf);
 }
+
+const NameAbbreviatorPtr& NamePatternConverter::getNameAbbreviator() const {
+    return abbreviator;
+}
@@ -52,3 +52,7 @@ void NDCPatternConverter::format(
        toAppendTo.append(LOG4CXX_STR("null"));
    }
  }
+
+bool NDCPatternConverter::requiresMDC() const {
+    return false;
+}
@@ -23,6 +23,7 @@
 #include <log4cxx/helpers/bytebuffer.h>
 #include <log4cxx/helpers/outputstream.h>
 #include <log4cxx/helpers/charsetencoder.h>
+#include <log4cxx/spi/loggername.h>
 #include "apr_pools.h"
 
 using namespace log4cxx;
@@ -92,6 +93,22 @@ void ObjectOutputStream::writeObject(const LogString& val, Pool& p)
 	os->write(dataBuf,	p);
 }
 
+void ObjectOutputStream::writeObject(const spi::LoggerName& val, Pool& p)
+{
+	objectHandle++;
+	writeByte(TC_STRING, p);
+	char bytes[2];
+	const std::string& utf8 = val.getUTF8();
+	size_t len = utf8.size();
+	ByteBuffer dataBuf(const_cast<char*>(utf8.data()), len);
+	bytes[1] = (char) (len & 0xFF);
+	bytes[0] = (char) ((len >> 8) & 0xFF);
+	ByteBuffer lenBuf(bytes, sizeof(bytes));
+
+	os->write(lenBuf,	p);
+	os->write(dataBuf,	p);
+}
+
 void ObjectOutputStream::writeObject(const MDC::Map& val, Pool& p)
 {
 	//
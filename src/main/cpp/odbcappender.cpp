@@ -143,6 +143,16 @@ void ODBCAppender::append(const spi::LoggingEventPtr& event, log4cxx::helpers::P
 #endif
 }
 
+void ODBCAppender::appendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p)
+{
+#if LOG4CXX_HAVE_ODBC
+   buffer.insert(buffer.end(), events.begin(), events.end());
+
+   if (buffer.size() >= bufferSize)
+      flushBuffer(p);
+#endif
+}
+
 LogString ODBCAppender::getLogStatement(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p) const
 {
    LogString sbuf;
@@ -86,3 +86,16 @@ void OutputStreamWriter::write(const LogString& str, Pool& p) {
   }
 }
 
+bool OutputStreamWriter::isUTF8() const {
+  return enc->isUTF8();
+}
+
+void OutputStreamWriter::writeUTF8(const std::string& str, Pool& p) {
+  if (!enc->isUTF8()) {
+    Writer::writeUTF8(str, p);
+  } else if (str.length() > 0) {
+    //  already encoded, handed to the stream without a copy
+    ByteBuffer buf(const_cast<char*>(str.data()), str.length());
+    out->write(buf, p);
+  }
+}
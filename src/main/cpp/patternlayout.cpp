@@ -24,6 +24,7 @@
 #include <log4cxx/pattern/loggingeventpatternconverter.h>
 #include <log4cxx/pattern/formattinginfo.h>
 #include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/transcoder.h>
 #include <log4cxx/helpers/pool.h>
 #include <log4cxx/helpers/optionconverter.h>
 
@@ -46,6 +47,7 @@
 #include <log4cxx/pattern/ndcpatternconverter.h>
 #include <log4cxx/pattern/propertiespatternconverter.h>
 #include <log4cxx/pattern/throwableinformationpatternconverter.h>
+#include <limits.h>
 
 
 using namespace log4cxx;
@@ -76,23 +78,89 @@ void PatternLayout::setConversionPattern(const LogString& pattern)
     activateOptions(pool);
 }
 
-void PatternLayout::format(LogString& output,
+inline void PatternLayout::formatOp(const Op& op, LogString& output,
       const spi::LoggingEventPtr& event,
       Pool& pool) const
 {
-  std::vector<FormattingInfoPtr>::const_iterator formatterIter =
-     patternFields.begin();
-  for(std::vector<LoggingEventPatternConverterPtr>::const_iterator
-           converterIter = patternConverters.begin();
-      converterIter != patternConverters.end();
-      converterIter++, formatterIter++) {
       int startField = output.length();
-      (*converterIter)->format(event, output, pool);
-      (*formatterIter)->format(startField, output);
+      switch(op.type) {
+      case Op::LITERAL:
+          output.append(op.text);
+          break;
+      case Op::MESSAGE:
+          output.append(event->getRenderedMessage());
+          break;
+      case Op::LEVEL:
+          output.append(event->getLevel()->toString());
+          break;
+      case Op::LOGGER:
+          if (op.abbreviator == 0) {
+              output.append(event->getLoggerName());
+          } else {
+              output.append(event->getLoggerNamePtr()->getAbbreviation(op.abbreviator));
+          }
+          break;
+      case Op::THREAD:
+          output.append(event->getThreadName());
+          break;
+      case Op::DATE:
+          //  bound call, the converter is known to be a DatePatternConverter
+          static_cast<const DatePatternConverter*>(&*op.converter)->DatePatternConverter::format(
+              event, output, pool);
+          break;
+      default:
+          op.converter->format(event, output, pool);
+      }
+      if (op.padding != 0) {
+          op.padding->format(startField, output);
+      }
+}
+
+void PatternLayout::format(LogString& output,
+      const spi::LoggingEventPtr& event,
+      Pool& pool) const
+{
+  for(std::vector<Op>::const_iterator op = ops.begin();
+      op != ops.end();
+      op++) {
+      formatOp(*op, output, event, pool);
   }
 
 }
 
+bool PatternLayout::formatUTF8(std::string& output,
+      const spi::LoggingEventPtr& event,
+      Pool& pool) const
+{
+#if LOG4CXX_LOGCHAR_IS_UTF8
+  format(output, event, pool);
+#else
+  LogString field;
+  for(std::vector<Op>::const_iterator op = ops.begin();
+      op != ops.end();
+      op++) {
+      if (op->type == Op::LITERAL) {
+          output.append(op->utf8);
+          continue;
+      }
+      if (op->padding == 0) {
+          if (op->type == Op::LOGGER && op->abbreviator == 0) {
+              output.append(event->getLoggerNamePtr()->getUTF8());
+              continue;
+          }
+          if (op->type == Op::LEVEL) {
+              event->getLevel()->toUTF8(output);
+              continue;
+          }
+      }
+      field.erase(field.begin(), field.end());
+      formatOp(*op, field, event, pool);
+      Transcoder::encodeUTF8(field, output);
+  }
+#endif
+  return true;
+}
+
 void PatternLayout::setOption(const LogString& option, const LogString& value)
 {
         if (StringHelper::equalsIgnoreCase(option,
@@ -103,6 +171,19 @@ void PatternLayout::setOption(const LogString& option, const LogString& value)
         }
 }
 
+bool PatternLayout::requiresMDC() const
+{
+       for(std::vector<LoggingEventPatternConverterPtr>::const_iterator
+               converterIter = patternConverters.begin();
+           converterIter != patternConverters.end();
+           converterIter++) {
+           if ((*converterIter)->requiresMDC()) {
+               return true;
+           }
+       }
+       return false;
+}
+
 void PatternLayout::activateOptions(Pool&)
 {
         LogString pat(conversionPattern);
@@ -129,6 +210,68 @@ void PatternLayout::activateOptions(Pool&)
              patternConverters.push_back(eventConverter);
            }
        }
+       compile();
+}
+
+void PatternLayout::compile()
+{
+       ops.clear();
+       Pool p;
+       std::vector<FormattingInfoPtr>::const_iterator fieldIter = patternFields.begin();
+       for(std::vector<LoggingEventPatternConverterPtr>::const_iterator
+               converterIter = patternConverters.begin();
+           converterIter != patternConverters.end();
+           converterIter++, fieldIter++) {
+           const LoggingEventPatternConverterPtr& converter = *converterIter;
+           bool padded = (*fieldIter)->getMinLength() > 0
+               || (*fieldIter)->getMaxLength() != INT_MAX;
+           //
+           //   only the exact classes are inlined, subclasses may
+           //   change the output.
+           //
+           const Class& cls = converter->getClass();
+           if (&cls == &LiteralPatternConverter::getStaticClass()
+               || &cls == &LineSeparatorPatternConverter::getStaticClass()) {
+               //  constant output, padded once here
+               LogString text;
+               converter->format(ObjectPtr(), text, p);
+               (*fieldIter)->format(0, text);
+               if (ops.empty() || ops.back().type != Op::LITERAL) {
+                   ops.push_back(Op());
+                   ops.back().type = Op::LITERAL;
+               }
+               ops.back().text.append(text);
+               continue;
+           }
+           Op op;
+           op.type = Op::CONVERTER;
+           op.converter = converter;
+           if (padded) {
+               op.padding = *fieldIter;
+           }
+           if (&cls == &MessagePatternConverter::getStaticClass()) {
+               op.type = Op::MESSAGE;
+           } else if (&cls == &LevelPatternConverter::getStaticClass()) {
+               op.type = Op::LEVEL;
+           } else if (&cls == &ThreadPatternConverter::getStaticClass()) {
+               op.type = Op::THREAD;
+           } else if (&cls == &DatePatternConverter::getStaticClass()) {
+               op.type = Op::DATE;
+           } else if (&cls == &LoggerPatternConverter::getStaticClass()) {
+               op.type = Op::LOGGER;
+               const NameAbbreviatorPtr& abbreviator =
+                   static_cast<const LoggerPatternConverter*>(&*converter)->getNameAbbreviator();
+               if (abbreviator != NameAbbreviator::getDefaultAbbreviator()) {
+                   op.abbreviator = abbreviator;
+               }
+           }
+           ops.push_back(op);
+       }
+       for(std::vector<Op>::iterator iter = ops.begin(); iter != ops.end(); iter++) {
+           if (iter->type == Op::LITERAL) {
+               Transcoder::encodeUTF8(iter->text, iter->utf8);
+           }
+       }
 }
 
 #define RULES_PUT(spec, cls) \
@@ -84,3 +84,7 @@ char* Pool::pstrdup(const char* s) {
 char* Pool::pstrdup(const std::string& s) {
     return apr_pstrndup(pool, s.data(), s.length());
 }
+
+void Pool::clear() {
+    apr_pool_clear(pool);
+}
@@ -80,3 +80,7 @@ void PropertiesPatternConverter::format(
     }
  }
 
+
+bool PropertiesPatternConverter::requiresMDC() const {
+    return true;
+}
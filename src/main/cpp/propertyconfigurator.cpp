@@ -33,6 +33,7 @@
 #include <log4cxx/spi/loggerrepository.h>
 #include <log4cxx/helpers/stringtokenizer.h>
 #include <log4cxx/helpers/synchronized.h>
+#include <log4cxx/helpers/clock.h>
 #include <apr_file_io.h>
 #include <apr_file_info.h>
 #include <apr_pools.h>
@@ -139,6 +140,18 @@ void PropertyConfigurator::configureAndWatch(const File& configFilename)
 
 void PropertyConfigurator::configureAndWatch(
         const File& configFilename, long delay)
+{
+    startWatchdog(configFilename, delay, 0);
+}
+
+void PropertyConfigurator::configureAndWatch(
+        const File& configFilename, long delay, const ThreadSettings& settings)
+{
+    startWatchdog(configFilename, delay, &settings);
+}
+
+void PropertyConfigurator::startWatchdog(
+        const File& configFilename, long delay, const ThreadSettings* settings)
 {
 	if(pdog)
 	{
@@ -148,6 +161,10 @@ void PropertyConfigurator::configureAndWatch(
     pdog = new PropertyWatchdog(configFilename);
     APRInitializer::registerCleanup(pdog);
     pdog->setDelay(delay);
+    if (settings != 0)
+    {
+        pdog->getThreadSettings() = *settings;
+    }
     pdog->start();
 }
 #endif
@@ -177,6 +194,24 @@ void PropertyConfigurator::doConfigure(helpers::Properties& properties,
                     + LOG4CXX_STR("]."));
         }
 
+        static const LogString CLOCK_KEY(LOG4CXX_STR("log4j.clock"));
+        LogString clockStr =
+                OptionConverter::findAndSubst(CLOCK_KEY, properties);
+
+        if (!clockStr.empty())
+        {
+                Clock::setType(clockStr);
+        }
+
+        static const LogString SHUTDOWN_TIMEOUT_KEY(LOG4CXX_STR("log4j.shutdownTimeout"));
+        LogString shutdownTimeoutStr =
+                OptionConverter::findAndSubst(SHUTDOWN_TIMEOUT_KEY, properties);
+
+        if (!shutdownTimeoutStr.empty())
+        {
+                LogManager::setShutdownTimeout(OptionConverter::toInt(shutdownTimeoutStr, -1));
+        }
+
         configureRootLogger(properties, hierarchy);
         configureLoggerFactory(properties);
         parseCatsAndRenderers(properties, hierarchy);
@@ -51,3 +51,6 @@ void RelativeTimePatternConverter::format(
     StringHelper::toString(delta, p, toAppendTo);
  }
 
+bool RelativeTimePatternConverter::requiresMDC() const {
+    return false;
+}
@@ -46,6 +46,42 @@ using namespace log4cxx::rolling;
 using namespace log4cxx::helpers;
 using namespace log4cxx::spi;
 
+#ifndef LOG4CXX_MULTI_PROCESS
+namespace {
+    /**
+     *  Gets the number of bytes of the UTF-8 encoding of a string.
+     *  @param msg string.
+     *  @param start index of the first character to count.
+     *  @return number of bytes.
+     */
+    size_t utf8Length(const LogString& msg, size_t start) {
+#if LOG4CXX_LOGCHAR_IS_UTF8
+        return msg.length() - start;
+#else
+        size_t length = 0;
+        for(LogString::const_iterator iter = msg.begin() + start;
+            iter != msg.end();
+            iter++) {
+            unsigned int ch = (unsigned int) *iter;
+            if (ch < 0x80) {
+                length += 1;
+            } else if (ch < 0x800) {
+                length += 2;
+            } else if (ch >= 0xD800 && ch <= 0xDFFF) {
+                //  each half of a surrogate pair, 4 bytes per pair
+                length += 2;
+            } else if (ch < 0x10000) {
+                length += 3;
+            } else {
+                length += 4;
+            }
+        }
+        return length;
+#endif
+    }
+}
+#endif
+
 
 IMPLEMENT_LOG4CXX_OBJECT(RollingFileAppenderSkeleton)
 IMPLEMENT_LOG4CXX_OBJECT(RollingFileAppender)
@@ -352,6 +388,14 @@ void RollingFileAppenderSkeleton::reopenLatestFile(Pool& p){
  * {@inheritDoc}
 */
 void RollingFileAppenderSkeleton::subAppend(const LoggingEventPtr& event, Pool& p) {
+  beforeWrite(event, p);
+  FileAppender::subAppend(event, p);
+}
+
+/**
+ * {@inheritDoc}
+*/
+void RollingFileAppenderSkeleton::beforeWrite(const LoggingEventPtr& event, Pool& p) {
   // The rollover check must precede actual writing. This is the
   // only correct behavior for time driven triggers.
   if (
@@ -394,8 +438,54 @@ void RollingFileAppenderSkeleton::subAppend(const LoggingEventPtr& event, Pool&
       reopenLatestFile(p);
   }
 #endif
+}
 
-  FileAppender::subAppend(event, p);
+/**
+ * {@inheritDoc}
+*/
+void RollingFileAppenderSkeleton::subAppendBatch(const spi::LoggingEventList& events, Pool& p) {
+#ifdef LOG4CXX_MULTI_PROCESS
+  //  the file must be re-checked before every write
+  for(spi::LoggingEventList::const_iterator iter = events.begin();
+      iter != events.end();
+      iter++) {
+    subAppend(*iter, p);
+  }
+#else
+  LogString msg;
+  //
+  //   bytes formatted but not yet written count towards the file
+  //   length.  The count is exact for a UTF-8 writer, other encodings
+  //   are approximated by the number of characters so size based
+  //   triggers may see slightly different sizes than when each event
+  //   is written individually.
+  size_t pending = 0;
+  bool utf8 = isWriterUTF8();
+  for(spi::LoggingEventList::const_iterator iter = events.begin();
+      iter != events.end();
+      iter++) {
+    if (
+      triggeringPolicy->isTriggeringEvent(
+          this, *iter, getFile(), getFileLength() + pending)) {
+      if (!msg.empty()) {
+          writeFormatted(msg, p);
+          msg.erase();
+          pending = 0;
+      }
+      try {
+          _event = &(const_cast<LoggingEventPtr &>(*iter));
+          rollover(p);
+      } catch (std::exception& ex) {
+          LogLog::warn(LOG4CXX_STR("Exception during rollover attempt."));
+      }
+      utf8 = isWriterUTF8();
+    }
+    size_t start = msg.length();
+    layout->format(msg, *iter, p);
+    pending += utf8 ? utf8Length(msg, start) : msg.length() - start;
+  }
+  writeFormatted(msg, p);
+#endif
 }
 
 /**
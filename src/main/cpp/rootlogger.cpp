@@ -43,8 +43,7 @@ void RootLogger::setLevel(const LevelPtr& level1)
    }
    else
    {
-
-      this->level = level1;
+      Logger::setLevel(level1);
    }
 }
 
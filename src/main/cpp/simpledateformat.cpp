@@ -177,18 +177,25 @@ namespace log4cxx
 class LiteralToken : public PatternToken
 {
 public:
-  LiteralToken( logchar ch1, int count1 ) : ch( ch1 ), count( count1 )
+  LiteralToken( logchar ch1, int count1 ) : text( count1, ch1 )
   {
   }
 
+  /**
+   * Extends the literal, so a run of separators is appended at once.
+   */
+  void append( logchar ch, int count )
+  {
+    text.append( count, ch );
+  }
+
   void format( LogString& s, const apr_time_exp_t & , Pool & /* p */ ) const
   {
-    s.append( count, ch );
+    s.append( text );
   }
 
 private:
-  logchar ch;
-  int count;
+  LogString text;
 };
 
 
@@ -218,16 +225,33 @@ public:
 
   virtual int getField( const apr_time_exp_t & tm ) const = 0;
 
-  void format( LogString& s, const apr_time_exp_t & tm, Pool & p ) const
+  void format( LogString& s, const apr_time_exp_t & tm, Pool & /* p */ ) const
   {
-    size_t initialLength = s.length();
-
-    StringHelper::toString( getField( tm ), p, s );
-    size_t finalLength = s.length();
-    if ( initialLength + width > finalLength )
+    //
+    //   digits are written right to left into a local buffer,
+    //     zero padding goes before any sign as it always has.
+    //
+    logchar buf[16];
+    logchar* end = buf + sizeof( buf ) / sizeof( buf[0] );
+    logchar* start = end;
+    int field = getField( tm );
+    unsigned int value = field < 0 ? 0U - (unsigned int) field : (unsigned int) field;
+    do
     {
-      s.insert( initialLength, ( initialLength + width ) - finalLength, (logchar) 0x30 /* '0' */);
+      *--start = (logchar) ( 0x30 /* '0' */ + value % 10 );
+      value /= 10;
     }
+    while ( value != 0 );
+    if ( field < 0 )
+    {
+      *--start = (logchar) 0x2D /* '-' */;
+    }
+    size_t length = end - start;
+    if ( width > length )
+    {
+      s.append( width - length, (logchar) 0x30 /* '0' */ );
+    }
+    s.append( start, end );
   }
 
 private:
@@ -720,6 +744,15 @@ void SimpleDateFormat::addToken(const logchar spec, const int repeat, const std:
                break;
 
                default:
+                 if ( !pattern.empty() )
+                 {
+                   LiteralToken * literal = dynamic_cast < LiteralToken * > ( pattern.back() );
+                   if ( literal != NULL )
+                   {
+                     literal->append( spec, repeat );
+                     return;
+                   }
+                 }
                  token = ( new LiteralToken( spec, repeat ) );
              }
              assert( token != NULL );
@@ -789,7 +822,7 @@ SimpleDateFormat::~SimpleDateFormat()
 void SimpleDateFormat::format( LogString & s, log4cxx_time_t time, Pool & p ) const
 {
   apr_time_exp_t exploded;
-  apr_status_t stat = timeZone->explode( & exploded, time );
+  apr_status_t stat = timeZone->explodeCached( & exploded, time );
   if ( stat == APR_SUCCESS )
   {
     for ( PatternTokenList::const_iterator iter = pattern.begin(); iter != pattern.end(); iter++ )
@@ -39,6 +39,7 @@ SocketAppenderSkeleton::SocketAppenderSkeleton(int defaultPort, int reconnection
    reconnectionDelay(reconnectionDelay1),
    locationInfo(false),
    thread() {
+    thread.getSettings().setName(LOG4CXX_STR("SocketConnector"));
 }
 
 SocketAppenderSkeleton::SocketAppenderSkeleton(InetAddressPtr address1, int port1, int delay)
@@ -49,6 +50,7 @@ SocketAppenderSkeleton::SocketAppenderSkeleton(InetAddressPtr address1, int port
    reconnectionDelay(delay),
    locationInfo(false),
    thread() {
+    thread.getSettings().setName(LOG4CXX_STR("SocketConnector"));
     remoteHost = this->address->getHostName();
 }
 
@@ -59,6 +61,7 @@ SocketAppenderSkeleton::SocketAppenderSkeleton(const LogString& host, int port1,
     reconnectionDelay(delay),
     locationInfo(false),
     thread() {
+    thread.getSettings().setName(LOG4CXX_STR("SocketConnector"));
 }
 
 SocketAppenderSkeleton::~SocketAppenderSkeleton()
@@ -125,7 +128,7 @@ void SocketAppenderSkeleton::setOption(const LogString& option, const LogString&
         {
                 setReconnectionDelay(OptionConverter::toInt(value, getDefaultDelay()));
         }
-        else
+        else if (!thread.getSettings().setOption(option, value))
         {
                 AppenderSkeleton::setOption(option, value);
         }
@@ -51,11 +51,13 @@ SocketHubAppender::~SocketHubAppender()
 SocketHubAppender::SocketHubAppender()
  : port(DEFAULT_PORT), streams(), locationInfo(false), thread()
 {
+        thread.getSettings().setName(LOG4CXX_STR("SocketHub"));
 }
 
 SocketHubAppender::SocketHubAppender(int port1)
  : port(port1), streams(), locationInfo(false), thread()
 {
+        thread.getSettings().setName(LOG4CXX_STR("SocketHub"));
         startServer();
 }
 
@@ -75,7 +77,7 @@ void SocketHubAppender::setOption(const LogString& option,
         {
                 setLocationInfo(OptionConverter::toBoolean(value, true));
         }
-        else
+        else if (!thread.getSettings().setOption(option, value))
         {
                 AppenderSkeleton::setOption(option, value);
         }
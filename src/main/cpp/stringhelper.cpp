@@ -100,6 +100,15 @@ bool StringHelper::endsWith(const LogString& s, const LogString& suffix)
     return false;
 }
 
+unsigned int StringHelper::hashCode(const LogString& s)
+{
+    unsigned int hash = 0;
+    for(LogString::const_iterator iter = s.begin(); iter != s.end(); iter++) {
+      hash = 31 * hash + (unsigned int) *iter;
+    }
+    return hash;
+}
+
 
 int StringHelper::toInt(const LogString& s) {
     std::string as;
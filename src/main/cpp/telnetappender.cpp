@@ -48,6 +48,7 @@ TelnetAppender::TelnetAppender()
 {
    synchronized sync(mutex);
    activeConnections = 0;
+   sh.getSettings().setName(LOG4CXX_STR("TelnetAcceptor"));
 }
 
 TelnetAppender::~TelnetAppender()
@@ -76,7 +77,7 @@ void TelnetAppender::setOption(const LogString& option,
         {
                 setEncoding(value);
         }
-        else
+        else if (!sh.getSettings().setOption(option, value))
         {
                 AppenderSkeleton::setOption(option, value);
         }
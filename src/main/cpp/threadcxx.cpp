@@ -23,6 +23,7 @@
 #include <log4cxx/helpers/pool.h>
 #include <log4cxx/helpers/threadlocal.h>
 #include <log4cxx/helpers/synchronized.h>
+#include <log4cxx/helpers/threadspecificdata.h>
 #include <apr_thread_cond.h>
 
 using namespace log4cxx::helpers;
@@ -128,6 +129,7 @@ void* LOG4CXX_THREAD_FUNC ThreadLaunch::launcher(apr_thread_t* thread, void* dat
 	LaunchPackage* package = (LaunchPackage*) data;
 	ThreadLocal& tls = getThreadLocal();
 	tls.set(package->getThread());
+    package->getThread()->settings.apply();
     {
       (package->getRunnable())(thread, package->getData());
       package->getThread()->ending();
@@ -235,6 +237,10 @@ bool Thread::interrupted() {
    return false;
 }
 
+void Thread::setCurrentThreadName(const LogString& name) {
+    ThreadSpecificData::setThreadName(name);
+}
+
 bool Thread::isCurrentThread() const {
 #if APR_HAS_THREADS
     const void* tls = getThreadLocal().get();
@@ -48,3 +48,6 @@
     toAppendTo.append(event->getThreadName());
   }
 
+bool ThreadPatternConverter::requiresMDC() const {
+    return false;
+}
@@ -0,0 +1,252 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+#include <log4cxx/logstring.h>
+#include <log4cxx/helpers/threadsettings.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/optionconverter.h>
+#include <log4cxx/helpers/transcoder.h>
+#include <log4cxx/helpers/loglog.h>
+#include <log4cxx/helpers/pool.h>
+#if !defined(LOG4CXX)
+#define LOG4CXX 1
+#endif
+#include <log4cxx/private/log4cxx_private.h>
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#elif defined(__APPLE__)
+#include <pthread.h>
+#endif
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+
+namespace {
+    /**
+     *  Longest thread name accepted by pthread_setname_np on Linux,
+     *  without the terminating null.
+     */
+    const size_t MAX_NATIVE_NAME = 15;
+
+    /**
+     *  Number of processors an affinity may refer to.
+     */
+#if defined(__linux__)
+    const int MAX_CPUS = CPU_SETSIZE;
+#elif defined(_WIN32)
+    const int MAX_CPUS = sizeof(DWORD_PTR) * 8;
+#else
+    const int MAX_CPUS = 1024;
+#endif
+
+    /**
+     *  Parses a list of processors like "0,2-3".
+     *  @return false if the list is malformed or refers
+     *  to a processor at or above MAX_CPUS.
+     */
+    bool parseCpus(const LogString& list, std::vector<int>& cpus) {
+        LogString::size_type start = 0;
+        while (start <= list.length()) {
+            LogString::size_type end = list.find(LOG4CXX_STR(','), start);
+            if (end == LogString::npos) {
+                end = list.length();
+            }
+            LogString token(StringHelper::trim(list.substr(start, end - start)));
+            if (!token.empty()) {
+                LogString::size_type dash = token.find(LOG4CXX_STR('-'), 1);
+                LogString first(token.substr(0, dash));
+                LogString last(dash == LogString::npos ? first : token.substr(dash + 1));
+                for(LogString::const_iterator iter = token.begin();
+                    iter != token.end();
+                    iter++) {
+                    if ((*iter < 0x30 || *iter > 0x39) && *iter != LOG4CXX_STR('-')) {
+                        return false;
+                    }
+                }
+                first = StringHelper::trim(first);
+                last = StringHelper::trim(last);
+                //  longer numbers would overflow and are out of range anyway
+                if (first.length() > 9 || last.length() > 9) {
+                    return false;
+                }
+                int from = StringHelper::toInt(first);
+                int to = StringHelper::toInt(last);
+                if (from < 0 || to < from || to >= MAX_CPUS) {
+                    return false;
+                }
+                for(int cpu = from; cpu <= to; cpu++) {
+                    cpus.push_back(cpu);
+                }
+            }
+            start = end + 1;
+        }
+        return true;
+    }
+
+    /**
+     *  Encodes the thread name for the operating system, truncated
+     *  without splitting a multibyte character.
+     */
+    std::string nativeName(const LogString& name) {
+        std::string encoded;
+        Transcoder::encodeUTF8(name, encoded);
+        if (encoded.length() > MAX_NATIVE_NAME) {
+            size_t length = MAX_NATIVE_NAME;
+            while (length > 0 && (encoded[length] & 0xC0) == 0x80) {
+                length--;
+            }
+            encoded.erase(length);
+        }
+        return encoded;
+    }
+}
+
+
+ThreadSettings::ThreadSettings() : priority(0), prioritySet(false) {
+}
+
+ThreadSettings::ThreadSettings(const LogString& name1)
+    : name(name1), priority(0), prioritySet(false) {
+}
+
+void ThreadSettings::setName(const LogString& name1) {
+    name = name1;
+}
+
+const LogString& ThreadSettings::getName() const {
+    return name;
+}
+
+void ThreadSettings::setAffinity(const LogString& list) {
+    std::vector<int> parsed;
+    if (parseCpus(list, parsed)) {
+        affinity = list;
+        cpus.swap(parsed);
+    } else {
+        Pool p;
+        LogString msg(LOG4CXX_STR("Invalid thread affinity: "));
+        msg.append(list);
+        msg.append(LOG4CXX_STR(", processors are numbered from 0 to "));
+        StringHelper::toString(MAX_CPUS - 1, p, msg);
+        LogLog::warn(msg);
+    }
+}
+
+const LogString& ThreadSettings::getAffinity() const {
+    return affinity;
+}
+
+void ThreadSettings::setPriority(int nice) {
+    priority = nice;
+    prioritySet = true;
+}
+
+int ThreadSettings::getPriority() const {
+    return priority;
+}
+
+bool ThreadSettings::hasPriority() const {
+    return prioritySet;
+}
+
+bool ThreadSettings::setOption(const LogString& option, const LogString& value) {
+    if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("THREADNAME"), LOG4CXX_STR("threadname"))) {
+        setName(value);
+    } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("THREADAFFINITY"), LOG4CXX_STR("threadaffinity"))) {
+        setAffinity(value);
+    } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("THREADPRIORITY"), LOG4CXX_STR("threadpriority"))) {
+        setPriority(OptionConverter::toInt(value, 0));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void ThreadSettings::apply(const LogString& suffix) const {
+    if (!name.empty()) {
+        LogString threadName(name + suffix);
+        Thread::setCurrentThreadName(threadName);
+#if LOG4CXX_HAS_PTHREAD_SETNAME_NP && defined(__linux__)
+        pthread_setname_np(pthread_self(), nativeName(threadName).c_str());
+#elif LOG4CXX_HAS_PTHREAD_SETNAME_NP && defined(__APPLE__)
+        pthread_setname_np(nativeName(threadName).c_str());
+#endif
+    }
+    if (!cpus.empty()) {
+        bool applied = false;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for(std::vector<int>::const_iterator iter = cpus.begin();
+            iter != cpus.end();
+            iter++) {
+            if (*iter < CPU_SETSIZE) {
+                CPU_SET(*iter, &set);
+            }
+        }
+        applied = pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+        DWORD_PTR mask = 0;
+        for(std::vector<int>::const_iterator iter = cpus.begin();
+            iter != cpus.end();
+            iter++) {
+            if (*iter < (int) (sizeof(mask) * 8)) {
+                mask |= ((DWORD_PTR) 1) << *iter;
+            }
+        }
+        applied = SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#endif
+        if (!applied) {
+            LogLog::warn(LOG4CXX_STR("Unable to set thread affinity: ") + affinity);
+        }
+    }
+    if (prioritySet) {
+        bool applied = false;
+#if defined(__linux__)
+        //   on Linux the nice value is an attribute of the thread
+        applied = setpriority(PRIO_PROCESS, (id_t) syscall(SYS_gettid), priority) == 0;
+#elif defined(_WIN32)
+        int level = THREAD_PRIORITY_NORMAL;
+        if (priority <= -15) {
+            level = THREAD_PRIORITY_HIGHEST;
+        } else if (priority <= -5) {
+            level = THREAD_PRIORITY_ABOVE_NORMAL;
+        } else if (priority >= 15) {
+            level = THREAD_PRIORITY_LOWEST;
+        } else if (priority >= 5) {
+            level = THREAD_PRIORITY_BELOW_NORMAL;
+        }
+        applied = SetThreadPriority(GetCurrentThread(), level) != 0;
+#endif
+        if (!applied) {
+            Pool p;
+            LogString msg(LOG4CXX_STR("Unable to set thread priority: "));
+            StringHelper::toString(priority, p, msg);
+            LogLog::warn(msg);
+        }
+    }
+}
@@ -18,21 +18,40 @@
 #include <log4cxx/logstring.h>
 #include <log4cxx/helpers/threadspecificdata.h>
 #include <log4cxx/helpers/exception.h>
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/messagebuffer.h>
+#include <log4cxx/spi/loggingevent.h>
 #include <apr_thread_proc.h>
+#include <apr_portable.h>
+#include <apr_strings.h>
 #if !defined(LOG4CXX)
 #define LOG4CXX 1
 #endif
 #include <log4cxx/helpers/aprinitializer.h>
+#include <log4cxx/helpers/transcoder.h>
+#include <log4cxx/private/log4cxx_private.h>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
 
 
 ThreadSpecificData::ThreadSpecificData()
-    : ndcStack(), mdcMap() {
+    : ndcStack(), mdcMap(), mdcSnapshot(), pool(0), poolInUse(false), messageBuffers(0),
+      threadName(), events() {
 }
 
 ThreadSpecificData::~ThreadSpecificData() {
+    //  a thread that exits after apr_terminate finds its pool
+    //  already destroyed with the global pool
+    if (!APRInitializer::isDestructed) {
+        delete pool;
+    }
+    delete messageBuffers;
+    for(std::vector<spi::LoggingEvent*>::iterator iter = events.begin();
+        iter != events.end();
+        iter++) {
+        delete *iter;
+    }
 }
 
 
@@ -40,10 +59,27 @@ log4cxx::NDC::Stack& ThreadSpecificData::getStack() {
   return ndcStack;
 }
 
+const log4cxx::MDC::Map& ThreadSpecificData::getMap() const {
+  return mdcMap;
+}
+
 log4cxx::MDC::Map& ThreadSpecificData::getMap() {
+  //  the caller may change the map, later events need a new snapshot
+  mdcSnapshot = 0;
   return mdcMap;
 }
 
+spi::MDCSnapshotPtr ThreadSpecificData::getMDCSnapshot() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0 || data->mdcMap.empty()) {
+        return 0;
+    }
+    if (data->mdcSnapshot == 0) {
+        data->mdcSnapshot = new spi::MDCSnapshot(data->mdcMap);
+    }
+    return data->mdcSnapshot;
+}
+
 ThreadSpecificData& ThreadSpecificData::getDataNoThreads() {
     static ThreadSpecificData noThreadData;
     return noThreadData;
@@ -61,7 +97,9 @@ ThreadSpecificData* ThreadSpecificData::getCurrentData() {
 
 void ThreadSpecificData::recycle() {
 #if APR_HAS_THREADS
-    if(ndcStack.empty() && mdcMap.empty()) {
+    //  keep the data of threads that log so their pool, buffers and name are reused
+    if(ndcStack.empty() && mdcMap.empty() && pool == 0 && messageBuffers == 0
+       && threadName.empty() && events.empty()) {
         void* pData = NULL;
         apr_status_t stat = apr_threadkey_private_get(&pData, APRInitializer::getTlsKey());
         if (stat == APR_SUCCESS && pData == this) {
@@ -80,13 +118,141 @@ void ThreadSpecificData::put(const LogString& key, const LogString& val) {
         data = createCurrentData();
     }
     if (data != 0) {
-        data->getMap()[key] = val;
+        log4cxx::MDC::Map::iterator it = data->mdcMap.find(key);
+        if (it == data->mdcMap.end()) {
+            data->mdcMap.insert(log4cxx::MDC::Map::value_type(key, val));
+            data->mdcSnapshot = 0;
+        } else if (it->second != val) {
+            //  the snapshot stays valid while the value does not change
+            it->second = val;
+            data->mdcSnapshot = 0;
+        }
     }
 }
 
+bool ThreadSpecificData::remove(const LogString& key, LogString& prevVal) {
+    ThreadSpecificData* data = getCurrentData();
+    if (data != 0) {
+        log4cxx::MDC::Map::iterator it = data->mdcMap.find(key);
+        if (it != data->mdcMap.end()) {
+            prevVal = it->second;
+            data->mdcMap.erase(it);
+            data->mdcSnapshot = 0;
+            data->recycle();
+            return true;
+        }
+    }
+    return false;
+}
 
+void ThreadSpecificData::clearMap() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data != 0) {
+        data->mdcMap.clear();
+        data->mdcSnapshot = 0;
+        data->recycle();
+    }
+}
 
 
+
+
+Pool* ThreadSpecificData::acquirePool() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data == 0 || data->poolInUse) {
+        return 0;
+    }
+    if (data->pool == 0) {
+        data->pool = new Pool();
+    }
+    data->poolInUse = true;
+    return data->pool;
+}
+
+void ThreadSpecificData::releasePool(Pool* p) {
+    ThreadSpecificData* data = getCurrentData();
+    if (data != 0 && data->pool == p) {
+        p->clear();
+        data->poolInUse = false;
+    }
+}
+
+MessageBufferCache* ThreadSpecificData::getMessageBufferCache() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data == 0) {
+        return 0;
+    }
+    if (data->messageBuffers == 0) {
+        data->messageBuffers = new MessageBufferCache();
+    }
+    return data->messageBuffers;
+}
+
+namespace {
+    const LogString noThreadName;
+}
+
+const LogString& ThreadSpecificData::getThreadName() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data == 0) {
+        return noThreadName;
+    }
+    if (data->threadName.empty()) {
+        data->threadName = formatThreadId();
+    }
+    return data->threadName;
+}
+
+void ThreadSpecificData::setThreadName(const LogString& name) {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data != 0) {
+        data->threadName = name;
+    }
+}
+
+std::vector<spi::LoggingEvent*>* ThreadSpecificData::getEventCache() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data == 0) {
+        return 0;
+    }
+    return &data->events;
+}
+
+LogString ThreadSpecificData::formatThreadId() {
+#if APR_HAS_THREADS
+#if defined(_WIN32)
+   char result[20];
+   DWORD threadId = GetCurrentThreadId();
+   apr_snprintf(result, sizeof(result), LOG4CXX_WIN32_THREAD_FMTSPEC, threadId);
+#else
+   // apr_os_thread_t encoded in HEX takes needs as many characters
+   // as two times the size of the type, plus an additional null byte.
+   char result[sizeof(apr_os_thread_t) * 3 + 10];
+   apr_os_thread_t threadId = apr_os_thread_current();
+   apr_snprintf(result, sizeof(result), LOG4CXX_APR_THREAD_FMTSPEC, (void*) &threadId);
+#endif
+   LOG4CXX_DECODE_CHAR(str, (const char*) result);
+   return str;
+#else
+   return LOG4CXX_STR("0x00000000");
+#endif
+}
+
 void ThreadSpecificData::push(const LogString& val) {
     ThreadSpecificData* data = getCurrentData();
     if (data == 0) {
@@ -62,3 +62,7 @@ void ThrowableInformationPatternConverter::format(
 bool ThrowableInformationPatternConverter::handlesThrowable() const {
     return true;
 }
+
+bool ThrowableInformationPatternConverter::requiresMDC() const {
+    return false;
+}
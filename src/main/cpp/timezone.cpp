@@ -27,6 +27,8 @@
 #include <apr_time.h>
 #include <apr_pools.h>
 #include <apr_strings.h>
+#include <apr_atomic.h>
+#include <limits>
 #include <log4cxx/helpers/transcoder.h>
 #include <log4cxx/helpers/stringhelper.h>
 #include <log4cxx/helpers/pool.h>
@@ -167,12 +169,91 @@ namespace log4cxx
 
 
 
-TimeZone::TimeZone( const LogString & id1 ) : id( id1 )
+#undef min
+
+/**
+ *  Fields of the minute expanded last, published with a sequence
+ *  number that is odd while they are rewritten.
+ */
+struct TimeZone::ExplodedMinute
+{
+  ExplodedMinute() : sequence( 0 ), start( std::numeric_limits<log4cxx_time_t>::min() )
+  {
+  }
+
+  enum { FIELD_COUNT = 9 };
+
+  volatile unsigned int sequence;
+  /** Time of the start of the minute. */
+  volatile log4cxx_time_t start;
+  /** tm_min to tm_gmtoff. */
+  volatile apr_int32_t fields[FIELD_COUNT];
+};
+
+TimeZone::TimeZone( const LogString & id1 ) : id( id1 ), minute( new ExplodedMinute() )
 {
 }
 
 TimeZone::~TimeZone()
 {
+  delete minute;
+}
+
+log4cxx_status_t TimeZone::explodeCached( apr_time_exp_t * result, log4cxx_time_t input ) const
+{
+  if ( input < 0 )
+  {
+    return explode( result, input );
+  }
+  const log4cxx_time_t USEC_PER_MINUTE = 60 * APR_USEC_PER_SEC;
+  log4cxx_time_t start = input - input % USEC_PER_MINUTE;
+  int usec = (int) ( input - start );
+
+  unsigned int sequence = apr_atomic_read32( &minute->sequence );
+  if ( ( sequence & 1 ) == 0 && minute->start == start )
+  {
+    result->tm_min = minute->fields[0];
+    result->tm_hour = minute->fields[1];
+    result->tm_mday = minute->fields[2];
+    result->tm_mon = minute->fields[3];
+    result->tm_year = minute->fields[4];
+    result->tm_wday = minute->fields[5];
+    result->tm_yday = minute->fields[6];
+    result->tm_isdst = minute->fields[7];
+    result->tm_gmtoff = minute->fields[8];
+    if ( apr_atomic_read32( &minute->sequence ) == sequence )
+    {
+      result->tm_sec = usec / APR_USEC_PER_SEC;
+      result->tm_usec = usec % APR_USEC_PER_SEC;
+      return APR_SUCCESS;
+    }
+  }
+
+  log4cxx_status_t stat = explode( result, input );
+  //
+  //   offsets with seconds, as some historical local times have,
+  //     do not start their minutes on minutes of UTC.
+  //
+  if ( stat == APR_SUCCESS && result->tm_gmtoff % 60 == 0 )
+  {
+    sequence = apr_atomic_read32( &minute->sequence );
+    if ( ( sequence & 1 ) == 0
+      && apr_atomic_cas32( &minute->sequence, sequence + 1, sequence ) == sequence )
+    {
+      minute->start = start;
+      minute->fields[0] = result->tm_min;
+      minute->fields[1] = result->tm_hour;
+      minute->fields[2] = result->tm_mday;
+      minute->fields[3] = result->tm_mon;
+      minute->fields[4] = result->tm_year;
+      minute->fields[5] = result->tm_wday;
+      minute->fields[6] = result->tm_yday;
+      minute->fields[7] = result->tm_isdst;
+      minute->fields[8] = result->tm_gmtoff;
+      apr_atomic_inc32( &minute->sequence );
+    }
+  }
+  return stat;
 }
 
 const TimeZonePtr & TimeZone::getDefault()
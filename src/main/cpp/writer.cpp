@@ -17,8 +17,10 @@
 
 #include <log4cxx/logstring.h>
 #include <log4cxx/helpers/writer.h>
+#include <log4cxx/helpers/transcoder.h>
 #include <stdexcept>
 
+using namespace log4cxx;
 using namespace log4cxx::helpers;
 
 IMPLEMENT_LOG4CXX_OBJECT(Writer)
@@ -29,6 +31,16 @@ Writer::Writer() {
 Writer::~Writer() {
 }
 
+bool Writer::isUTF8() const {
+    return false;
+}
+
+void Writer::writeUTF8(const std::string& str, Pool& p) {
+    LogString decoded;
+    Transcoder::decodeUTF8(str, decoded);
+    write(decoded, p);
+}
+
 #ifdef LOG4CXX_MULTI_PROCESS                  
 OutputStreamPtr Writer::getOutPutStreamPtr(){
     throw std::logic_error("getOutPutStreamPtr must be implemented in the derived class that you are using");
@@ -20,6 +20,7 @@
 #include <log4cxx/helpers/synchronized.h>
 #include <log4cxx/layout.h>
 #include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/optionconverter.h>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
@@ -30,6 +31,7 @@ IMPLEMENT_LOG4CXX_OBJECT(WriterAppender)
 WriterAppender::WriterAppender() {
    synchronized sync(mutex);
    immediateFlush = true;
+   formatOutsideLock = false;
 }
 
 WriterAppender::WriterAppender(const LayoutPtr& layout1,
@@ -38,6 +40,7 @@ WriterAppender::WriterAppender(const LayoutPtr& layout1,
       Pool p;
       synchronized sync(mutex);
       immediateFlush = true;
+      formatOutsideLock = false;
       activateOptions(p);
 }
 
@@ -45,6 +48,7 @@ WriterAppender::WriterAppender(const LayoutPtr& layout1)
     : AppenderSkeleton(layout1) {
     synchronized sync(mutex);
     immediateFlush = true;
+    formatOutsideLock = false;
 }
 
 
@@ -77,6 +81,48 @@ void WriterAppender::activateOptions(Pool& p)
 
 
 
+void WriterAppender::doAppend(const spi::LoggingEventPtr& event, Pool& pool1)
+{
+        LayoutPtr layout1;
+        bool utf8 = false;
+        {
+                synchronized sync(mutex);
+                if (!formatOutsideLock) {
+                        if (isAppendable(event)) {
+                                append(event, pool1);
+                        }
+                        return;
+                }
+                if (!isAppendable(event) || !checkEntryConditions()) {
+                        return;
+                }
+                layout1 = layout;
+                utf8 = writer->isUTF8();
+        }
+
+        //
+        //   only the write and what has to precede it are serialized,
+        //   the layout runs on the calling thread without the lock
+        //
+        std::string bytes;
+        LogString msg;
+        bool encoded = utf8 && layout1->formatUTF8(bytes, event, pool1);
+        if (!encoded) {
+                layout1->format(msg, event, pool1);
+        }
+
+        synchronized sync(mutex);
+        if (!checkEntryConditions()) {
+                return;
+        }
+        beforeWrite(event, pool1);
+        if (encoded) {
+                writeFormattedUTF8(bytes, pool1);
+        } else {
+                writeFormatted(msg, pool1);
+        }
+}
+
 void WriterAppender::append(const spi::LoggingEventPtr& event, Pool& pool1)
 {
 
@@ -88,6 +134,16 @@ void WriterAppender::append(const spi::LoggingEventPtr& event, Pool& pool1)
         subAppend(event, pool1);
 }
 
+void WriterAppender::appendBatch(const spi::LoggingEventList& events, Pool& pool1)
+{
+        if(!checkEntryConditions())
+        {
+                return;
+        }
+
+        subAppendBatch(events, pool1);
+}
+
 /**
    This method determines if there is a sense in attempting to append.
 
@@ -211,16 +267,71 @@ void WriterAppender::setEncoding(const LogString& enc) {
 
 void WriterAppender::subAppend(const spi::LoggingEventPtr& event, Pool& p)
 {
+        //
+        //   a layout that can produce UTF-8 directly saves the
+        //   writer a second pass through its encoder,
+        //   a failed rollover may have left no writer at all
+        //
+        if (writer != NULL && writer->isUTF8()) {
+                std::string bytes;
+                if (layout->formatUTF8(bytes, event, p)) {
+                        writeFormattedUTF8(bytes, p);
+                        return;
+                }
+        }
         LogString msg;
         layout->format(msg, event, p);
+        writeFormatted(msg, p);
+}
+
+void WriterAppender::subAppendBatch(const spi::LoggingEventList& events, Pool& p)
+{
+        if (writer != NULL && writer->isUTF8() && !events.empty()) {
+                std::string bytes;
+                if (layout->formatUTF8(bytes, events.front(), p)) {
+                        for(spi::LoggingEventList::const_iterator iter = events.begin() + 1;
+                            iter != events.end();
+                            iter++)
+                        {
+                                layout->formatUTF8(bytes, *iter, p);
+                        }
+                        writeFormattedUTF8(bytes, p);
+                        return;
+                }
+        }
+        LogString msg;
+        for(spi::LoggingEventList::const_iterator iter = events.begin();
+            iter != events.end();
+            iter++)
         {
-           synchronized sync(mutex);
-         if (writer != NULL) {
+                layout->format(msg, *iter, p);
+        }
+        writeFormatted(msg, p);
+}
+
+void WriterAppender::writeFormatted(const LogString& msg, Pool& p)
+{
+        synchronized sync(mutex);
+        if (writer != NULL) {
            writer->write(msg, p);
-              if (immediateFlush) {
-               writer->flush(p);
-              }
-         }
+           if (immediateFlush) {
+              writer->flush(p);
+           }
+        }
+}
+
+void WriterAppender::beforeWrite(const spi::LoggingEventPtr&, Pool&)
+{
+}
+
+void WriterAppender::writeFormattedUTF8(const std::string& msg, Pool& p)
+{
+        synchronized sync(mutex);
+        if (writer != NULL) {
+           writer->writeUTF8(msg, p);
+           if (immediateFlush) {
+              writer->flush(p);
+           }
         }
 }
 
@@ -256,9 +367,15 @@ bool WriterAppender::requiresLayout() const {
    return true;
 }
 
+bool WriterAppender::isWriterUTF8() const {
+   return writer != NULL && writer->isUTF8();
+}
+
 void WriterAppender::setOption(const LogString& option, const LogString& value) {
     if(StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("ENCODING"), LOG4CXX_STR("encoding"))) {
        setEncoding(value);
+    } else if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("FORMATOUTSIDELOCK"), LOG4CXX_STR("formatoutsidelock"))) {
+       setFormatOutsideLock(OptionConverter::toBoolean(value, false));
     } else {
       AppenderSkeleton::setOption(option, value);
     }
@@ -269,3 +386,8 @@ void WriterAppender::setImmediateFlush(bool value) {
     synchronized sync(mutex);
     immediateFlush = value; 
 }
+
+void WriterAppender::setFormatOutsideLock(bool value) {
+    synchronized sync(mutex);
+    formatOutsideLock = value;
+}
@@ -37,6 +37,7 @@ namespace log4cxx
         {
         class LoggingEvent;
         typedef helpers::ObjectPtrT<LoggingEvent> LoggingEventPtr;
+        typedef std::vector<LoggingEventPtr> LoggingEventList;
 
         class Filter;
         typedef helpers::ObjectPtrT<Filter> FilterPtr;
@@ -94,6 +95,15 @@ namespace log4cxx
         virtual void doAppend(const spi::LoggingEventPtr& event,
               log4cxx::helpers::Pool& pool) = 0;
 
+        /**
+         Log a sequence of events in <code>Appender</code> specific way.
+         Appenders that can write several events with a single output
+         operation, such as a single write and flush, should override
+         this method. The default implementation calls
+         <code>doAppend</code> for each event in turn.
+        */
+        virtual void doAppendBatch(const spi::LoggingEventList& events,
+              log4cxx::helpers::Pool& pool);
 
         /**
          Get the name of this appender. The name uniquely identifies the
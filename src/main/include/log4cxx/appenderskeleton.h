@@ -85,6 +85,21 @@ namespace log4cxx
                 */
                 virtual void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p) = 0;
 
+                /**
+                Called by AppenderSkeleton::doAppendBatch with the events that
+                passed the threshold and filters. The default implementation
+                calls <code>append</code> for each event; subclasses that can
+                write a batch more cheaply should override it.
+                */
+                virtual void appendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p);
+
+                /**
+                Returns true if the appender is open and the event passes
+                the threshold and the filters.  Reports an error if the
+                appender is closed.  Must be called with the lock held.
+                */
+                bool isAppendable(const spi::LoggingEventPtr& event) const;
+
         public:
                 DECLARE_ABSTRACT_LOG4CXX_OBJECT(AppenderSkeleton)
                 BEGIN_LOG4CXX_CAST_MAP()
@@ -112,6 +127,15 @@ namespace log4cxx
                 virtual void activateOptions(log4cxx::helpers::Pool& /* pool */) {}
                 virtual void setOption(const LogString& option, const LogString& value);
 
+        protected:
+                /**
+                Starts a new configuration generation, called when
+                the layout or the filters change.
+                */
+                static void configurationChanged();
+
+        public:
+
                 /**
                 Add a filter to end of the filter list.
                 */
@@ -165,6 +189,22 @@ namespace log4cxx
                 */
                 bool isAsSevereAsThreshold(const LevelPtr& level) const;
 
+                /**
+                Returns true if the appender reads the mapped diagnostic
+                context of the events it appends.  By default this is the
+                case if its layout or one of its filters requires the MDC,
+                or if it does not use a layout and may read the event itself.
+                Used by the AsyncAppender to skip copying the MDC.
+                */
+                virtual bool requiresMDC() const;
+
+                /**
+                Gets a counter changed whenever the layout or the filters
+                of any appender change, so that the AsyncAppender knows
+                when to ask its appenders requiresMDC again.
+                */
+                static unsigned int getConfigurationGeneration();
+
 
                 /**
                 * This method performs threshold checks and invokes filters before
@@ -173,6 +213,13 @@ namespace log4cxx
                 * */
                 void doAppend(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& pool);
 
+                /**
+                * Performs the same checks as doAppend for each event while
+                * holding the appender lock once, then delegates the accepted
+                * events to AppenderSkeleton#appendBatch.
+                * */
+                void doAppendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& pool);
+
                 /**
                 Set the {@link spi::ErrorHandler ErrorHandler} for this Appender.
                 */
@@ -184,7 +231,7 @@ namespace log4cxx
                 {@link net::SocketAppender SocketAppender} ignores the layout set
                 here.
                 */
-                void setLayout(const LayoutPtr& layout1) { this->layout = layout1; }
+                void setLayout(const LayoutPtr& layout1) { this->layout = layout1; configurationChanged(); }
 
                 /**
                 Set the name of this Appender.
@@ -202,7 +249,14 @@ namespace log4cxx
                 */
                 void setThreshold(const LevelPtr& threshold);
 
+        private:
+                /**
+                Returns true if the threshold and the filter chain accept the event.
+                */
+                bool isAccepted(const spi::LoggingEventPtr& event) const;
+
         }; // class AppenderSkeleton
+        LOG4CXX_PTR_DEF(AppenderSkeleton);
 }  // namespace log4cxx
 
 #if defined(_MSC_VER)
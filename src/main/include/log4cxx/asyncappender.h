@@ -31,6 +31,10 @@
 #include <log4cxx/helpers/thread.h>
 #include <log4cxx/helpers/mutex.h>
 #include <log4cxx/helpers/condition.h>
+#include <log4cxx/helpers/eventringbuffer.h>
+#include <log4cxx/helpers/eventspool.h>
+
+typedef struct apr_threadkey_t apr_threadkey_t;
 
 
 namespace log4cxx
@@ -46,7 +50,54 @@ namespace log4cxx
         attach multiple appenders to an AsyncAppender.
 
         <p>The AsyncAppender uses a separate thread to serve the events in
-        its bounded buffer.
+        its bounded buffer.  The <b>DispatcherCount</b> option runs several
+        dispatcher threads, each with its own buffer.  Events are assigned to
+        a dispatcher by logger name, or by thread name if <b>ShardBy</b> is
+        <code>Thread</code>, so that the events of one logger or thread are
+        appended in order.
+
+        <p>The <b>OverflowPolicy</b> option selects what happens when the
+        buffer is full: <code>Block</code> waits for space,
+        <code>Discard</code> counts the event in a summary appended later,
+        <code>DropOldest</code> makes room by discarding the oldest buffered
+        event, <code>DiscardBelowThreshold</code> discards events less severe
+        than <b>DiscardThreshold</b> (WARN by default) and waits for the
+        others, and <code>Spool</code> writes events to the binary
+        <b>SpoolFile</b> from which the dispatcher reads them once it has
+        caught up.
+
+        <p>A positive <b>StagingSize</b> lets each producer thread collect
+        events in a block of its own that is handed to the dispatcher when
+        it holds StagingSize events, when it is older than <b>StagingDelay</b>
+        milliseconds or when an event as severe as <b>StagingLevel</b>
+        (ERROR by default) is appended, so that chatty threads do not touch
+        the shared buffer for every event.
+
+        <p>The <b>WaitStrategy</b> option selects how the dispatcher waits
+        for events and how producers wait for space under the Block policy:
+        <code>Blocking</code> (the default) waits on a condition at once,
+        <code>SpinThenPark</code> first retries for a short while, spinning
+        and then yielding, so that the other side rarely needs a signal,
+        and <code>BusySpin</code> never waits on a condition, keeping a
+        core busy for the lowest latency.
+
+        <p>Queue depth, dispatch latency, the time producers waited for
+        space and the discarded events are available through getQueueDepth
+        and the other metrics methods.  A positive <b>MetricsInterval</b>
+        logs them every MetricsInterval milliseconds at INFO level on
+        <b>MetricsLogger</b>, by default <code>log4cxx.AsyncAppender</code>.
+
+        <p>The mapped diagnostic context of the calling thread is only
+        captured with the events if an attached appender requires it, see
+        AppenderSkeleton::requiresMDC.  Appenders are examined when they are
+        attached and again after the layout or the filters of an appender
+        changed.
+
+        <p>The <b>ThreadName</b>, <b>ThreadAffinity</b> and
+        <b>ThreadPriority</b> options configure the dispatcher threads, see
+        helpers::ThreadSettings.  Dispatchers after the first add
+        <code>-</code><i>n</i> to the name.  Running dispatchers apply
+        changed settings the next time they wake up.
 
         <p><b>Important note:</b> The <code>AsyncAppender</code> can only
         be script configured using the {@link xml::DOMConfigurator DOMConfigurator}.
@@ -57,6 +108,46 @@ namespace log4cxx
         {
         public:
                 DECLARE_LOG4CXX_OBJECT(AsyncAppender)
+
+                /**
+                 * What append does with an event when the buffer is full.
+                 */
+                enum OverflowPolicy {
+                    /** Wait for space in the buffer. */
+                    BLOCK,
+                    /** Count the event in a discard summary. */
+                    DISCARD,
+                    /** Discard the oldest buffered event to make room. */
+                    DROP_OLDEST,
+                    /** Discard events below the discard threshold, wait for the others. */
+                    DISCARD_BELOW_THRESHOLD,
+                    /** Write the event to the spool file. */
+                    SPOOL
+                };
+
+                /**
+                 * Number of buckets of the latency histogram.
+                 */
+                enum { LATENCY_BUCKETS = 24 };
+
+                /**
+                 * Discarded events counted by logger name.
+                 */
+                typedef std::map<LogString, unsigned int> DiscardCountMap;
+
+                /**
+                 * How the dispatcher waits for events and producers
+                 * wait for space.
+                 */
+                enum WaitStrategy {
+                    /** Wait on a condition. */
+                    BLOCKING,
+                    /** Spin, then yield, then wait on a condition. */
+                    SPIN_THEN_PARK,
+                    /** Spin without waiting on a condition. */
+                    BUSY_SPIN
+                };
+
                 BEGIN_LOG4CXX_CAST_MAP()
                         LOG4CXX_CAST_ENTRY(AsyncAppender)
                         LOG4CXX_CAST_ENTRY_CHAIN(AppenderSkeleton)
@@ -83,6 +174,13 @@ namespace log4cxx
                 */
                 void addAppender(const AppenderPtr& newAppender);
 
+                /**
+                 * Checks threshold and filters like AppenderSkeleton::doAppend
+                 * but only takes the appender mutex if filters are attached,
+                 * so that producers do not serialize before the buffer.
+                 */
+                void doAppend(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& pool);
+
                 void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
 
                 /**
@@ -92,6 +190,27 @@ namespace log4cxx
                 */
                 void close();
 
+                /**
+                 * Waits until the events appended before the call, including
+                 * staged and spooled events, have been appended to the
+                 * attached appenders.
+                 * @param timeout maximum wait in milliseconds.
+                 * @return false if the timeout elapsed, or if called by
+                 * a dispatcher thread.
+                 */
+                bool flush(int timeout);
+
+                /**
+                 * Flushes the buffered events within a deadline and closes
+                 * the appender.  Events still buffered at the deadline are
+                 * discarded instead of appended so that closing does not
+                 * wait for a slow downstream appender beyond its current
+                 * append.
+                 * @param timeout maximum wait in milliseconds for the flush.
+                 * @return false if events were discarded.
+                 */
+                bool close(int timeout);
+
                 /**
                  * Get iterator over attached appenders.
                  * @return list of all attached appenders.
@@ -121,6 +240,13 @@ namespace log4cxx
                 bool isAttached(const AppenderPtr& appender) const;
 
                 virtual bool requiresLayout() const;
+
+                /**
+                 * Returns true if one of the attached appenders requires
+                 * the MDC, only then the MDC of the calling thread is
+                 * captured with each event.
+                 */
+                virtual bool requiresMDC() const;
                     
                 /**
                  * Removes and closes all attached appenders.
@@ -148,7 +274,7 @@ namespace log4cxx
                 /**
                 * The <b>BufferSize</b> option takes a non-negative integer value.
                 * This integer value determines the maximum size of the bounded
-                * buffer.
+                * buffer, rounded up to a power of two.
                 * */
                 void setBufferSize(int size);
 
@@ -174,6 +300,165 @@ namespace log4cxx
                  * @return true if calling thread will be blocked when buffer is full.
                  */
                  bool getBlocking() const;
+
+                /**
+                 * Sets the policy applied when the buffer is full,
+                 * setBlocking selects BLOCK or DISCARD.
+                 * @param policy overflow policy.
+                 */
+                 void setOverflowPolicy(OverflowPolicy policy);
+
+                 OverflowPolicy getOverflowPolicy() const;
+
+                /**
+                 * Sets the level below which events are discarded when the
+                 * buffer is full and the policy is DISCARD_BELOW_THRESHOLD.
+                 * @param level threshold, WARN by default.
+                 */
+                 void setDiscardThreshold(const LevelPtr& level);
+
+                 LevelPtr getDiscardThreshold() const;
+
+                /**
+                 * Sets the file used by the SPOOL policy.  The file is
+                 * created on the first overflow, truncated whenever the
+                 * dispatcher has read all events and removed when the
+                 * appender is destroyed.
+                 * Events are discarded if it cannot be written.  Each
+                 * dispatcher after the first appends its number to the name.
+                 * @param file path of the spool file.
+                 */
+                 void setSpoolFile(const LogString& file);
+
+                 LogString getSpoolFile() const;
+
+                /**
+                 * Sets the number of dispatcher threads, each with its own
+                 * buffer of BufferSize events.  With more than one
+                 * dispatcher the attached appenders are called concurrently
+                 * and must be thread safe, as AppenderSkeleton is.  Should
+                 * be set before logging starts since events of one source
+                 * may be reordered while the count changes.
+                 * @param count number of dispatchers, from 1 to 64.
+                 */
+                 void setDispatcherCount(int count);
+
+                 int getDispatcherCount() const;
+
+                /**
+                 * Sets whether events are assigned to dispatchers by
+                 * thread name instead of logger name.
+                 * @param value true to keep the events of each thread in order.
+                 */
+                 void setShardByThread(bool value);
+
+                 bool getShardByThread() const;
+
+                /**
+                 * Sets how the dispatcher waits for events and producers
+                 * wait for space in the buffer.
+                 * @param strategy wait strategy, BLOCKING by default.
+                 */
+                 void setWaitStrategy(WaitStrategy strategy);
+
+                 WaitStrategy getWaitStrategy() const;
+
+                /**
+                 * Sets the number of events a producer thread stages before
+                 * handing them to the dispatcher.  Should be set before
+                 * logging starts.
+                 * @param size block size, 0 (the default) disables staging.
+                 */
+                 void setStagingSize(int size);
+
+                 int getStagingSize() const;
+
+                /**
+                 * Sets the level at which a staged block is handed to the
+                 * dispatcher immediately.
+                 * @param level level, ERROR by default.
+                 */
+                 void setStagingLevel(const LevelPtr& level);
+
+                 LevelPtr getStagingLevel() const;
+
+                /**
+                 * Sets the time after which the dispatcher collects staged
+                 * events of threads that stopped logging.
+                 * @param delay delay in milliseconds, 10 by default.
+                 */
+                 void setStagingDelay(int delay);
+
+                 int getStagingDelay() const;
+
+                /**
+                 * Gets the number of events waiting in the buffers of all
+                 * dispatchers, approximate while events are added.
+                 * Staged and spooled events are not included.
+                 * @return number of events.
+                 */
+                 int getQueueDepth() const;
+
+                /**
+                 * Gets the largest number of events a dispatcher found in
+                 * its buffers since the metrics were reset.
+                 * @return high-water mark.
+                 */
+                 int getMaxQueueDepth() const;
+
+                /**
+                 * Gets the latency histogram of the dispatched events,
+                 * measured from the time stamp of each event to the time
+                 * it was taken from the buffer.  Bucket i counts the events
+                 * dispatched in less than 2^i microseconds, the last
+                 * bucket all slower events.
+                 * @return LATENCY_BUCKETS counts.
+                 */
+                 std::vector<unsigned int> getLatencyHistogram() const;
+
+                /**
+                 * Gets the total time producers waited for space in
+                 * the buffer.
+                 * @return time in microseconds.
+                 */
+                 log4cxx_time_t getBlockedTime() const;
+
+                /**
+                 * Gets the number of discarded events of each logger.
+                 * @return discard counts.
+                 */
+                 DiscardCountMap getDiscardCounts() const;
+
+                /**
+                 * Resets the high-water mark, the latency histogram, the
+                 * blocked time and the discard counts.
+                 */
+                 void resetMetrics();
+
+                /**
+                 * Sets the interval at which the metrics are logged.
+                 * @param interval interval in milliseconds, 0 (the default)
+                 * disables logging.
+                 */
+                 void setMetricsInterval(int interval);
+
+                 int getMetricsInterval() const;
+
+                /**
+                 * Sets the logger on which the metrics are logged.
+                 * @param name logger name.
+                 */
+                 void setMetricsLogger(const LogString& name);
+
+                 LogString getMetricsLogger() const;
+
+                /**
+                 * Sets the name, affinity and priority of the dispatcher threads.
+                 * @param settings thread settings.
+                 */
+                 void setThreadSettings(const helpers::ThreadSettings& settings);
+
+                 helpers::ThreadSettings getThreadSettings() const;
                  
                  
                  /**
@@ -193,16 +478,157 @@ namespace log4cxx
                 enum { DEFAULT_BUFFER_SIZE = 128 };
 
                 /**
-                 * Event buffer.
+                 * The default staging delay in milliseconds.
+                */
+                enum { DEFAULT_STAGING_DELAY = 10 };
+
+                /**
+                 * Number of spinning and yielding retries of SPIN_THEN_PARK.
+                */
+                enum { SPIN_TRIES = 1000, YIELD_TRIES = 100 };
+
+                /**
+                 *  Events staged by one producer thread for one shard.  The
+                 *  block is registered with the shard, which deletes it, the
+                 *  owner thread marks it abandoned when it exits.
+                 */
+                class StagingBlock {
+                public:
+                    StagingBlock();
+
+                    /**
+                     *  Spins until the block is owned, held briefly by the
+                     *  producer or by the dispatcher collecting the block.
+                     */
+                    void lock();
+                    bool tryLock();
+                    void unlock();
+
+                    LoggingEventList events;
+
+                    /**
+                     *  Time at which the first staged event was added.
+                     */
+                    log4cxx_time_t since;
+
+                    volatile unsigned int locked;
+                    volatile unsigned int abandoned;
+
+                private:
+                    StagingBlock(const StagingBlock&);
+                    StagingBlock& operator=(const StagingBlock&);
+                };
+
+                /**
+                 *  Staging blocks of one thread, kept under stagingKey.
+                 */
+                struct StagingThread;
+                static void releaseStagingThread(void* data);
+
+                /**
+                 *  Buffer and thread of one dispatcher.
+                 */
+                class Shard {
+                public:
+                    Shard(AsyncAppender* appender, int index, int capacity, helpers::Pool& p);
+                    ~Shard();
+
+                    AsyncAppender* const appender;
+                    const int index;
+
+                    /**
+                     * Event buffer, producers add events without locking.
+                    */
+                    helpers::EventRingBuffer* volatile buffer;
+
+                    /**
+                     * Buffers replaced by setBufferSize, still drained by the
+                     * dispatcher since producers may hold on to them.
+                     */
+                    std::vector<helpers::EventRingBuffer*> retiredBuffers;
+                    volatile unsigned int retiredCount;
+
+                    ::log4cxx::helpers::Condition bufferNotEmpty;
+
+                    /**
+                     *  Set while the dispatcher waits for bufferNotEmpty.
+                     */
+                    volatile unsigned int dispatcherWaiting;
+
+                    /**
+                     *  Set while spool holds events, producers then write to the
+                     *  spool instead of the buffer so that events stay in order.
+                     */
+                    volatile unsigned int spooling;
+
+                    /**
+                     * Spool used by the SPOOL policy, guarded by bufferMutex.
+                    */
+                    helpers::EventSpool* spool;
+
+                    /**
+                     *  Staging blocks of producer threads, guarded by bufferMutex,
+                     *  stagingGeneration changes whenever the list changes.
+                     */
+                    std::vector<StagingBlock*> stagingBlocks;
+                    volatile unsigned int stagingGeneration;
+
+                    /**
+                     *  Number of staging blocks holding events.
+                     */
+                    volatile unsigned int stagedBlocks;
+
+                    /**
+                     *  Flush requests counted by flush, and the last request
+                     *  served by the dispatcher.
+                     */
+                    volatile unsigned int flushRequested;
+                    volatile unsigned int flushCompleted;
+
+                    helpers::Thread dispatcher;
+
+                private:
+                    Shard(const Shard&);
+                    Shard& operator=(const Shard&);
+                };
+
+                enum { MAX_DISPATCHERS = 64 };
+
+                /**
+                 *  Shards, events are only assigned to the first shardCount,
+                 *  the others are kept until the appender is destroyed.
+                 */
+                Shard* shards[MAX_DISPATCHERS];
+                volatile unsigned int shardCount;
+                int startedShards;
+
+                /**
+                 * Are events assigned to shards by thread name.
+                */
+                bool shardByThread;
+
+                /**
+                 * Wait strategy.
                 */
-                LoggingEventList buffer;
+                WaitStrategy waitStrategy;
 
                 /**
-                 *  Mutex used to guard access to buffer and discardMap.
+                 *  Mutex used to guard access to discardMap, the shards and
+                 *  the conditions.  Producers only take it when the buffer
+                 *  is full or the dispatcher is parked.
                  */
                 ::log4cxx::helpers::Mutex bufferMutex;
                 ::log4cxx::helpers::Condition bufferNotFull;
-                ::log4cxx::helpers::Condition bufferNotEmpty;
+
+                /**
+                 *  Number of producers waiting for bufferNotFull.
+                 */
+                volatile unsigned int blockedProducers;
+
+                /**
+                 *  Set when discardMap is not empty.
+                 */
+                volatile unsigned int discarding;
     
                 class DiscardSummary {
                 private:
@@ -260,25 +686,222 @@ namespace log4cxx
                 helpers::AppenderAttachableImplPtr appenders;
 
                 /**
-                 *  Dispatcher.
+                 * Should location info be included in dispatched messages.
+                */
+                bool locationInfo;
+
+                /**
+                 * What to do when the buffer is full.
+                */
+                OverflowPolicy overflowPolicy;
+
+                /**
+                 * Level below which DISCARD_BELOW_THRESHOLD discards events.
+                */
+                LevelPtr discardThreshold;
+
+                /**
+                 * Path of the spool file.
+                */
+                LogString spoolFile;
+
+                /**
+                 * Staging options.
+                */
+                int stagingSize;
+                LevelPtr stagingLevel;
+                int stagingDelay;
+
+                /**
+                 * Integer value of stagingLevel, read by producers.
+                */
+                int stagingLevelInt;
+
+                /**
+                 * Key of the staging blocks of the current thread, created
+                 * when staging is enabled.
+                */
+                apr_threadkey_t* stagingKey;
+
+                /**
+                 * Metrics, updated by the dispatchers without locking
+                 * except blockedTime and discardCounts which are
+                 * guarded by bufferMutex.
+                */
+                mutable volatile unsigned int maxQueueDepth;
+                mutable volatile unsigned int latencyHistogram[LATENCY_BUCKETS];
+                log4cxx_time_t blockedTime;
+                DiscardCountMap discardCounts;
+                int metricsInterval;
+                LogString metricsLogger;
+
+                /**
+                 * Settings of the dispatcher threads, guarded by bufferMutex,
+                 * and the number of times they were changed.
                  */
-                helpers::Thread dispatcher;
+                helpers::ThreadSettings threadSettings;
+                volatile unsigned int threadSettingsGeneration;
 
                 /**
-                 * Should location info be included in dispatched messages.
+                 * Signaled under bufferMutex when a dispatcher served a flush.
                 */
-                bool locationInfo;
+                ::log4cxx::helpers::Condition flushed;
 
                 /**
-                 * Does appender block when buffer is full.
+                 * Set by close(int) when the flush deadline passed, the
+                 * dispatchers then count buffered events instead of
+                 * appending them.
                 */
-                bool blocking;
+                volatile unsigned int abandoning;
+                volatile unsigned int abandonedEvents;
+
+                /**
+                 * Non-zero if an attached appender requires the MDC,
+                 * updated when appenders are attached or removed.
+                 */
+                mutable volatile unsigned int captureMDC;
+
+                /**
+                 * AppenderSkeleton configuration generation in which
+                 * captureMDC was determined.
+                 */
+                mutable volatile unsigned int captureMDCGeneration;
+
 
                 /**
                  *  Dispatch routine.
                  */
                 static void* LOG4CXX_THREAD_FUNC dispatch(apr_thread_t* thread, void* data);
 
+                /**
+                 *  Creates a shard and starts its dispatcher, called with
+                 *  bufferMutex held.
+                 */
+                void startShard();
+
+                /**
+                 *  Gets the shard of an event.
+                 */
+                Shard* getShard(const spi::LoggingEventPtr& event);
+
+                /**
+                 *  Determines whether the current thread is a dispatcher.
+                 */
+                bool isDispatcherThread() const;
+
+                /**
+                 *  Moves buffered events and discard summaries to a list,
+                 *  called by the dispatcher.
+                 *  @return number of events taken from the buffers.
+                 */
+                int drainBuffers(Shard* shard,
+                    std::vector<helpers::EventRingBuffer*>& rings,
+                    unsigned int& ringCount,
+                    LoggingEventList& events,
+                    helpers::Pool& p);
+
+                /**
+                 *  Adds an event to the buffer of a shard, applying the
+                 *  wait strategy and the overflow policy if it is full.
+                 */
+                void enqueue(Shard* shard, const spi::LoggingEventPtr& event);
+
+                /**
+                 *  Retries adding an event to a full buffer as the wait
+                 *  strategy allows.
+                 *  @return false if the event was not added.
+                 */
+                bool spinOffer(Shard* shard, const spi::LoggingEventPtr& event);
+
+                /**
+                 *  Retries finding events as the wait strategy allows.
+                 *  @return true if events may be dispatched.
+                 */
+                bool spinWait(Shard* shard);
+
+                /**
+                 *  Applies the overflow policy to an event that did not fit
+                 *  the buffer, called with bufferMutex held.
+                 */
+                void overflow(Shard* shard, const spi::LoggingEventPtr& event);
+
+                /**
+                 *  Adds an event to the discard summaries, called with
+                 *  bufferMutex held.
+                 */
+                void discard(const spi::LoggingEventPtr& event);
+
+                /**
+                 *  Waits until events are buffered or the appender is closed.
+                 *  @return false if closed.
+                 */
+                bool park(Shard* shard);
+
+                /**
+                 *  Determines whether all buffers are empty, called with bufferMutex held.
+                 */
+                bool isBufferEmpty(const Shard* shard) const;
+
+                /**
+                 *  Records the depth and latencies of drained events.
+                 */
+                void updateMetrics(int depth, const LoggingEventList& events);
+
+                /**
+                 *  Logs the metrics on the metrics logger, called by
+                 *  the first dispatcher.
+                 */
+                void logMetrics(helpers::Pool& p);
+
+                /**
+                 *  Determines whether the attached appenders require the
+                 *  MDC, called with the appenders mutex held.
+                 */
+                void updateCaptureMDC() const;
+
+                /**
+                 *  Returns captureMDC, determined again if the layout or
+                 *  the filters of an appender changed since.
+                 */
+                bool isCapturingMDC() const;
+
+                /**
+                 *  Applies the thread settings to the calling dispatcher.
+                 *  @param generation generation last applied, updated.
+                 */
+                void applyThreadSettings(Shard* shard, unsigned int& generation);
+
+                /**
+                 *  Gets the staging block of the current thread for a shard.
+                 *  @return block, or null if the thread does not stage events.
+                 */
+                StagingBlock* getStagingBlock(Shard* shard);
+
+                /**
+                 *  Stages an event, handing the block over when it is full
+                 *  or the event is severe enough.
+                 */
+                void stage(Shard* shard, StagingBlock* block, const spi::LoggingEventPtr& event);
+
+                /**
+                 *  Moves staged events to the buffer of the shard, called by
+                 *  the producer with the block locked.
+                 */
+                void handOff(Shard* shard, StagingBlock* block);
+
+                /**
+                 *  Moves staged events older than the staging delay, or all
+                 *  staged events if force is set, to the buffer and deletes
+                 *  abandoned blocks, called by the dispatcher.
+                 *  @return false if a block was skipped because its
+                 *  producer held it.
+                 */
+                bool collectStaged(Shard* shard,
+                    std::vector<StagingBlock*>& blocks,
+                    unsigned int& generation,
+                    bool force,
+                    LoggingEventList& events);
+
         }; // class AsyncAppender
         LOG4CXX_PTR_DEF(AsyncAppender);
 }  //  namespace log4cxx
@@ -174,6 +174,11 @@ namespace log4cxx
                         */
                   void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool&);
 
+                        /**
+                        * Adds all events to the buffer and flushes it at most once.
+                        */
+                  void appendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool&);
+
                         /**
                         * By default getLogStatement sends the event to the required Layout object.
                         * The layout will format the given pattern into a workable SQL string.
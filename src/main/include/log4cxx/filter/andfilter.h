@@ -97,6 +97,8 @@ namespace log4cxx
             void setAcceptOnMatch(bool acceptOnMatch);
             
             FilterDecision decide(const spi::LoggingEventPtr & event) const;
+
+            bool requiresMDC() const;
         };
         LOG4CXX_PTR_DEF(AndFilter);
 
@@ -59,6 +59,9 @@ namespace log4cxx
                         */
                         FilterDecision decide(const spi::LoggingEventPtr& event) const
                                 { return spi::Filter::DENY; }
+
+                        bool requiresMDC() const
+                                { return false; }
                 }; // class DenyAllFilter
 
                 LOG4CXX_PTR_DEF(DenyAllFilter);
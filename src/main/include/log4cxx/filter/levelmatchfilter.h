@@ -90,6 +90,9 @@ namespace log4cxx
                         <b>AcceptOnMatch</b> property is set to false.
                         */
                         FilterDecision decide(const spi::LoggingEventPtr& event) const;
+
+                        bool requiresMDC() const
+                                { return false; }
                 }; // class LevelMatchFilter
             LOG4CXX_PTR_DEF(LevelMatchFilter);
         }  // namespace filter
@@ -129,6 +129,9 @@ namespace log4cxx
                         <b>AcceptOnMatch</b> property is set to false.
                         */
                         FilterDecision decide(const spi::LoggingEventPtr& event) const;
+
+                        bool requiresMDC() const
+                                { return false; }
                 }; // class LevelRangeFilter
             LOG4CXX_PTR_DEF(LevelRangeFilter);
         }  // namespace filter
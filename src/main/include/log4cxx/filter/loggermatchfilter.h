@@ -92,6 +92,9 @@ namespace log4cxx
                         <b>AcceptOnMatch</b> property is set to false.
                         */
                         FilterDecision decide(const spi::LoggingEventPtr& event) const;
+
+                        bool requiresMDC() const
+                                { return false; }
                 }; // class LoggerMatchFilter
             LOG4CXX_PTR_DEF(LoggerMatchFilter);
         }  // namespace filter
@@ -84,6 +84,9 @@ namespace log4cxx
                         is there is no string match.
                         */
                         FilterDecision decide(const spi::LoggingEventPtr& event) const;
+
+                        bool requiresMDC() const
+                                { return false; }
                }; // class StringMatchFilter
             LOG4CXX_PTR_DEF(StringMatchFilter);
         }  // namespace filter
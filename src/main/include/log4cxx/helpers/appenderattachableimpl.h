@@ -44,10 +44,6 @@ namespace log4cxx
             public virtual spi::AppenderAttachable,
             public virtual helpers::ObjectImpl
         {
-        protected:
-            /** Array of appenders. */
-            AppenderList  appenderList;
-
         public:            
             /**
              *   Create new instance.
@@ -55,6 +51,8 @@ namespace log4cxx
              */
             AppenderAttachableImpl(Pool& pool);
 
+            ~AppenderAttachableImpl();
+
             DECLARE_ABSTRACT_LOG4CXX_OBJECT(AppenderAttachableImpl)
             BEGIN_LOG4CXX_CAST_MAP()
                 LOG4CXX_CAST_ENTRY(AppenderAttachableImpl)
@@ -72,10 +70,20 @@ namespace log4cxx
 
             /**
              Call the <code>doAppend</code> method on all attached appenders.
+             Does not block on changes to the list of appenders,
+             the appenders attached when the call started are used.
             */
             int appendLoopOnAppenders(const spi::LoggingEventPtr& event,
                 log4cxx::helpers::Pool& p);
 
+            /**
+             Call the <code>doAppendBatch</code> method on all attached
+             appenders, so each appender receives the whole sequence of
+             events at once.
+            */
+            int appendLoopOnAppenders(const spi::LoggingEventList& events,
+                log4cxx::helpers::Pool& p);
+
             /**
              * Get all previously added appenders as an Enumeration.
              */
@@ -108,10 +116,42 @@ namespace log4cxx
              */
             virtual void removeAppender(const LogString& name);
 
+            /**
+             * Mutex held while the list of appenders is changed.
+             */
             inline const log4cxx::helpers::Mutex& getMutex() const { return mutex; }
 
+        protected:
+            /**
+             * Gets the current list of appenders, which replaces the former
+             * appenderList member.  The list is never modified, adding or
+             * removing an appender publishes a new one, and stays valid
+             * while the caller holds getMutex().
+             * @return current list of appenders.
+             */
+            const AppenderList& getAppenderList() const;
+
         private:
+            class AppenderListSnapshot;
             log4cxx::helpers::Mutex mutex;
+            /**
+             *  Current list of appenders, never modified once published.
+             *  Replaced as a whole while holding mutex.
+             */
+            AppenderListSnapshot* volatile snapshot;
+            /**
+             *  Number of readers taking a reference to snapshot,
+             *  indexed by the epoch in which they started.
+             */
+            mutable volatile log4cxx_uint32_t readers[2];
+            /**
+             *  Flipped between 0 and 1 on every publication.
+             */
+            mutable volatile log4cxx_uint32_t epoch;
+
+            AppenderListSnapshot* acquire() const;
+            static void release(AppenderListSnapshot* list);
+            void publish(const AppenderList& appenders);
             AppenderAttachableImpl(const AppenderAttachableImpl&);
             AppenderAttachableImpl& operator=(const AppenderAttachableImpl&);
         };
@@ -35,6 +35,7 @@ namespace log4cxx
                   WriterPtr out;
                   size_t sz;
                   LogString buf;
+                  std::string utf8;
 
           public:
                   DECLARE_ABSTRACT_LOG4CXX_OBJECT(BufferedWriter)
@@ -50,6 +51,8 @@ namespace log4cxx
                   virtual void close(Pool& p);
                   virtual void flush(Pool& p);
                   virtual void write(const LogString& str, Pool& p);
+                  virtual bool isUTF8() const;
+                  virtual void writeUTF8(const std::string& str, Pool& p);
 
           private:
                   BufferedWriter(const BufferedWriter&);
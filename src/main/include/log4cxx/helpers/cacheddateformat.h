@@ -56,7 +56,11 @@ namespace log4cxx
                /**
                 *  Second magic number used to detect the millisecond position.
                 */
-               magic2 = 987000
+               magic2 = 987000,
+               /**
+                *  Magic number used to detect the microsecond position.
+                */
+               microMagic = 654321
               };
 
               /**
@@ -76,28 +80,27 @@ namespace log4cxx
                */
              static const logchar zeroString[];
 
-            /**
-             *   Wrapped formatter.
-             */
-            log4cxx::helpers::DateFormatPtr formatter;
+              /**
+               *  Expected representation of the microsecond magic number.
+               */
+              static const logchar microMagicString[];
 
-            /**
-             *  Index of initial digit of millisecond pattern or
-             *   UNRECOGNIZED_MILLISECONDS or NO_MILLISECONDS.
-             */
-            mutable int millisecondStart;
+              /**
+               *  Expected representation of 0 microseconds.
+               */
+              static const logchar microZeroString[];
 
             /**
-             *  Integral second preceding the previous convered Date.
+             *   Wrapped formatter.
              */
-            mutable log4cxx_time_t slotBegin;
-
+            log4cxx::helpers::DateFormatPtr formatter;
 
             /**
-             *  Cache of previous conversion.
+             *  Index of initial digit of millisecond pattern,
+             *   UNRECOGNIZED_MILLISECONDS or NO_MILLISECONDS.  Once
+             *   negative, the field is no longer searched for.
              */
-            mutable LogString cache;
-
+            mutable volatile int millisecondStart;
 
             /**
              *  Maximum validity period for the cache.
@@ -107,9 +110,42 @@ namespace log4cxx
             const int expiration;
 
             /**
-             *  Date requested in previous conversion.
+             *  Incremented after each change of the time zone, dates
+             *  formatted before are no longer published or reused.
              */
-            mutable log4cxx_time_t previousTime;
+            mutable volatile unsigned int timeZoneGeneration;
+
+            enum {
+                /**
+                 *  Longest formatted date kept in the cache.
+                 */
+                CAPACITY = 64
+            };
+
+            /**
+             *  Formatted date of the current second, shared by all threads.
+             *  A thread that formats a new second publishes it here and
+             *  others copy it and patch the millisecond or microsecond
+             *  digits.  The sequence is odd while the slot is rewritten,
+             *  readers retry with the wrapped formatter if it changed
+             *  while they copied the slot.
+             */
+            struct Slot {
+                volatile unsigned int sequence;
+                /** Time zone generation the date was formatted in. */
+                volatile unsigned int generation;
+                /** Date that was formatted. */
+                volatile log4cxx_time_t time;
+                /** Integral second preceding time. */
+                volatile log4cxx_time_t begin;
+                /** Index of the subsecond digits or a negative constant. */
+                volatile int fieldStart;
+                /** Number of subsecond digits, 3 or 6. */
+                volatile int fieldDigits;
+                volatile size_t length;
+                volatile logchar text[CAPACITY];
+            };
+            mutable Slot slot;
 
        public:
           /**
@@ -137,6 +173,20 @@ namespace log4cxx
                   const log4cxx::helpers::DateFormatPtr& formatter,
                   log4cxx::helpers::Pool& pool);
 
+            /**
+             * Finds start of a six digit microsecond field in formatted time.
+             * @param time long time
+             * @param formatted String corresponding formatted string
+             * @param formatter DateFormat date format
+             * @param pool pool.
+             * @return int position in string of first digit of microseconds,
+             *    UNRECOGNIZED_MILLISECONDS if there is no such field.
+             */
+            static int findMicrosecondStart(
+              log4cxx_time_t time, const LogString& formatted,
+                  const log4cxx::helpers::DateFormatPtr& formatter,
+                  log4cxx::helpers::Pool& pool);
+
             /**
              * Formats a Date into a date/time string.
              *
@@ -194,6 +244,19 @@ namespace log4cxx
                CachedDateFormat(const CachedDateFormat&);
                CachedDateFormat& operator=(const CachedDateFormat&);
 
+               /**
+                * Formats from the published slot if it covers the date.
+                * @return true if the date was appended.
+                */
+               bool formatCached(LogString& sbuf, log4cxx_time_t date) const;
+
+               /**
+                * Publishes the date formatted by the wrapped formatter
+                * unless another thread is publishing.
+                */
+               void publish(log4cxx_time_t date, const LogString& formatted,
+                   unsigned int generation, log4cxx::helpers::Pool& p) const;
+
                /**
                * Tests if two string regions are equal.
                * @param target target string.
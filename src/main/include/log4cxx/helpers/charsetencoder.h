@@ -106,6 +106,13 @@ namespace log4cxx
                */
                   virtual void flush(ByteBuffer& out);
 
+              /**
+               *   Determines if the encoder produces UTF-8, in which case
+               *     text already encoded in UTF-8 may bypass it.
+               *     The base class returns false.
+               */
+                  virtual bool isUTF8() const;
+
               /**
                *   Determines if the return value from encode indicates
                *     an unconvertable character.
@@ -0,0 +1,99 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_HELPERS_CLOCK_H
+#define _LOG4CXX_HELPERS_CLOCK_H
+
+#include <log4cxx/log4cxx.h>
+#include <log4cxx/logstring.h>
+
+namespace log4cxx
+{
+        namespace helpers
+        {
+                /**
+                 *  Source of the time stamps of logging events.
+                 *
+                 *  <p>The clock is shared by all repositories and may be
+                 *  selected with the <code>log4j.clock</code> property or
+                 *  the <code>clock</code> attribute of a DOMConfigurator
+                 *  configuration:
+                 *  <ul>
+                 *  <li><b>system</b>: apr_time_now(), the default.</li>
+                 *  <li><b>coarse</b>: CLOCK_REALTIME_COARSE where available,
+                 *  cheaper to read with a resolution of a few milliseconds.</li>
+                 *  <li><b>tsc</b>: the processor time stamp counter, stored
+                 *  as raw cycles and converted to time when the time stamp
+                 *  is requested.  Assumes an invariant counter synchronized
+                 *  across processors.</li>
+                 *  </ul>
+                 *  Clocks that are not supported on the platform fall back
+                 *  to system.</p>
+                 */
+                class LOG4CXX_EXPORT Clock
+                {
+                public:
+                        enum Type {
+                            SYSTEM_CLOCK,
+                            COARSE_CLOCK,
+                            TSC_CLOCK
+                        };
+
+                        /**
+                         *  Selects the clock used for new time stamps.
+                         *  @param type clock type.
+                         *  @return clock type actually selected.
+                         */
+                        static Type setType(Type type);
+
+                        /**
+                         *  Selects a clock by name, one of system, coarse or tsc.
+                         *  @param name clock name, case insensitive.
+                         *  @return false if the name is not recognized.
+                         */
+                        static bool setType(const LogString& name);
+
+                        static Type getType();
+
+                        /**
+                         *  Reads the selected clock.
+                         *  @param cycles set to true if the value is in cycles
+                         *  and must be converted with toTime.
+                         *  @return microseconds since 01.01.1970 or cycles.
+                         */
+                        static log4cxx_time_t read(bool& cycles);
+
+                        /**
+                         *  Converts a value read from the tsc clock.
+                         *  @param cycles time stamp counter value.
+                         *  @return microseconds since 01.01.1970.
+                         */
+                        static log4cxx_time_t toTime(log4cxx_time_t cycles);
+
+                        /**
+                         *  Refreshes the calibration of the tsc clock, done by
+                         *  toTime once the last calibration is a second old.
+                         */
+                        static void recalibrate();
+
+                private:
+                        Clock();
+                };
+        }
+}
+
+#endif //_LOG4CXX_HELPERS_CLOCK_H
@@ -61,6 +61,16 @@ namespace log4cxx
                          *  @throws InterruptedException if thread is interrupted.
                          */
                         void await(Mutex& lock);
+                        /**
+                         *  Await signaling of condition for at most a given time.
+                         *  @param lock lock associated with condition, calling thread must
+                         *  own lock.  Lock will be released while waiting and reacquired
+                         *  before returning from wait.
+                         *  @param timeout maximum wait in microseconds.
+                         *  @return false if the timeout elapsed.
+                         *  @throws InterruptedException if thread is interrupted.
+                         */
+                        bool await(Mutex& lock, log4cxx_time_t timeout);
 
                 private:
                         apr_thread_cond_t* condition;
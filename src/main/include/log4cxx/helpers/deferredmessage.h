@@ -0,0 +1,192 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_HELPERS_DEFERRED_MESSAGE_H
+#define _LOG4CXX_HELPERS_DEFERRED_MESSAGE_H
+
+#include <log4cxx/log4cxx.h>
+#include <log4cxx/logstring.h>
+#include <string>
+
+namespace log4cxx {
+
+   namespace helpers {
+
+   /**
+    *   A message whose formatting is deferred until it is first needed.
+    *
+    *   Holds a format string in which each "{}" is replaced by the next
+    *   argument, and copies of up to MAX_ARGUMENTS arguments.  Arguments
+    *   may be of any arithmetic or pointer type, strings are copied.
+    *   The format string itself is not copied and must outlive the
+    *   logging event, in practice it should be a string literal.
+    *
+    *   This class is used by the LOG4CXX_INFO_ASYNC and similar macros
+    *   and is not intended for use outside of that context.
+    */
+   class LOG4CXX_EXPORT DeferredMessage {
+   public:
+        enum { MAX_ARGUMENTS = 8 };
+
+        /**
+         *  Creates a message without arguments.
+         *  @param fmt format, must outlive the message.
+         */
+        explicit DeferredMessage(const char* fmt)
+           : pattern(fmt), count(0) {
+        }
+
+        /**
+         *  Creates a message with arguments.
+         *  @param fmt format, must outlive the message.
+         */
+        template<class A1>
+        DeferredMessage(const char* fmt, const A1& a1)
+           : pattern(fmt), count(0) {
+           add(a1);
+        }
+
+        template<class A1, class A2>
+        DeferredMessage(const char* fmt, const A1& a1, const A2& a2)
+           : pattern(fmt), count(0) {
+           add(a1); add(a2);
+        }
+
+        template<class A1, class A2, class A3>
+        DeferredMessage(const char* fmt, const A1& a1, const A2& a2, const A3& a3)
+           : pattern(fmt), count(0) {
+           add(a1); add(a2); add(a3);
+        }
+
+        template<class A1, class A2, class A3, class A4>
+        DeferredMessage(const char* fmt, const A1& a1, const A2& a2, const A3& a3, const A4& a4)
+           : pattern(fmt), count(0) {
+           add(a1); add(a2); add(a3); add(a4);
+        }
+
+        template<class A1, class A2, class A3, class A4, class A5>
+        DeferredMessage(const char* fmt, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5)
+           : pattern(fmt), count(0) {
+           add(a1); add(a2); add(a3); add(a4); add(a5);
+        }
+
+        template<class A1, class A2, class A3, class A4, class A5, class A6>
+        DeferredMessage(const char* fmt, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6)
+           : pattern(fmt), count(0) {
+           add(a1); add(a2); add(a3); add(a4); add(a5); add(a6);
+        }
+
+        template<class A1, class A2, class A3, class A4, class A5, class A6, class A7>
+        DeferredMessage(const char* fmt, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6, const A7& a7)
+           : pattern(fmt), count(0) {
+           add(a1); add(a2); add(a3); add(a4); add(a5); add(a6); add(a7);
+        }
+
+        template<class A1, class A2, class A3, class A4, class A5, class A6, class A7, class A8>
+        DeferredMessage(const char* fmt, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6, const A7& a7, const A8& a8)
+           : pattern(fmt), count(0) {
+           add(a1); add(a2); add(a3); add(a4); add(a5); add(a6); add(a7); add(a8);
+        }
+
+        /**
+         *  Appends the formatted message.
+         *  @param dest destination.
+         */
+        void format(LogString& dest) const;
+
+   private:
+        enum ArgumentType {
+            BOOL_ARG, CHAR_ARG, LONG_ARG, ULONG_ARG, INT64_ARG, UINT64_ARG,
+            DOUBLE_ARG, POINTER_ARG, STRING_ARG
+        };
+
+        struct Argument {
+            ArgumentType type;
+            union {
+                long l;
+                unsigned long ul;
+                log4cxx_int64_t ll;
+                unsigned long long ull;
+                double d;
+                const void* p;
+                size_t offset;
+            } value;
+            size_t length;
+        };
+
+        const char* pattern;
+        int count;
+        Argument arguments[MAX_ARGUMENTS];
+        /** Characters of all string arguments. */
+        std::string strings;
+
+        inline Argument* next(ArgumentType type) {
+            if (count >= MAX_ARGUMENTS) {
+                return 0;
+            }
+            Argument* arg = arguments + count++;
+            arg->type = type;
+            return arg;
+        }
+
+        inline void add(bool val) {
+            Argument* arg = next(BOOL_ARG);
+            if (arg) arg->value.l = val;
+        }
+        inline void add(char val) {
+            Argument* arg = next(CHAR_ARG);
+            if (arg) arg->value.l = val;
+        }
+        inline void add(signed char val) { add((long) val); }
+        inline void add(unsigned char val) { add((unsigned long) val); }
+        inline void add(short val) { add((long) val); }
+        inline void add(unsigned short val) { add((unsigned long) val); }
+        inline void add(int val) { add((long) val); }
+        inline void add(unsigned int val) { add((unsigned long) val); }
+        inline void add(long val) {
+            Argument* arg = next(LONG_ARG);
+            if (arg) arg->value.l = val;
+        }
+        inline void add(unsigned long val) {
+            Argument* arg = next(ULONG_ARG);
+            if (arg) arg->value.ul = val;
+        }
+        inline void add(log4cxx_int64_t val) {
+            Argument* arg = next(INT64_ARG);
+            if (arg) arg->value.ll = val;
+        }
+        inline void add(unsigned long long val) {
+            Argument* arg = next(UINT64_ARG);
+            if (arg) arg->value.ull = val;
+        }
+        inline void add(float val) { add((double) val); }
+        inline void add(double val) {
+            Argument* arg = next(DOUBLE_ARG);
+            if (arg) arg->value.d = val;
+        }
+        inline void add(const void* val) {
+            Argument* arg = next(POINTER_ARG);
+            if (arg) arg->value.p = val;
+        }
+        void add(const char* val);
+        void add(const std::string& val);
+   };
+
+   }
+}
+
+#endif
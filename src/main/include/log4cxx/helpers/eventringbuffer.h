@@ -0,0 +1,151 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_HELPERS_EVENT_RING_BUFFER_H
+#define _LOG4CXX_HELPERS_EVENT_RING_BUFFER_H
+
+#if defined(_MSC_VER)
+#pragma warning ( push )
+#pragma warning ( disable: 4231 4251 4275 4786 )
+#endif
+
+#include <log4cxx/spi/loggingevent.h>
+
+namespace log4cxx
+{
+        namespace helpers
+        {
+                /**
+                 *  Bounded queue of logging events for many producers and a
+                 *  single consumer.  Producers claim a slot by advancing the
+                 *  enqueue position with compare-and-swap and publish the
+                 *  event through the sequence counter of the slot, the
+                 *  consumer claims published slots with compare-and-swap on
+                 *  the dequeue position and frees them the same way, so
+                 *  producers may also remove the oldest event with poll.
+                 *  Neither side locks.
+                 */
+                class LOG4CXX_EXPORT EventRingBuffer
+                {
+                public:
+                        /**
+                         *  Creates a ring.
+                         *  @param capacity requested capacity, rounded up to
+                         *  a power of two.
+                         */
+                        explicit EventRingBuffer(int capacity);
+                        /**
+                         *  Releases the events still queued.
+                         */
+                        ~EventRingBuffer();
+
+                        /**
+                         *  Adds an event if a slot is free, may be called by any thread.
+                         *  @param event event.
+                         *  @return false if the ring is full.
+                         */
+                        bool offer(const spi::LoggingEventPtr& event);
+
+                        /**
+                         *  Moves the published events to a list, only called
+                         *  by the consumer.
+                         *  @param events list to which events are appended.
+                         *  @return number of events moved.
+                         */
+                        size_t drain(spi::LoggingEventList& events);
+
+                        /**
+                         *  Removes the oldest event, may be called by any thread.
+                         *  @param event receives the removed event.
+                         *  @return false if the ring is empty or the oldest
+                         *  event is still being published.
+                         */
+                        bool poll(spi::LoggingEventPtr& event);
+
+                        /**
+                         *  Determines whether no slot is claimed, including slots
+                         *  whose event is still being published.  Only called by
+                         *  the consumer.
+                         *  @return true if empty.
+                         */
+                        bool isEmpty() const;
+
+                        /**
+                         *  Gets the number of claimed slots, approximate while
+                         *  events are added or removed.
+                         *  @return number of events.
+                         */
+                        int size() const;
+
+                        int getCapacity() const;
+
+                        /**
+                         *  Gets the position at which the next event will be added,
+                         *  events added earlier are behind it.
+                         *  @return enqueue position.
+                         */
+                        unsigned int getEnqueuePosition() const;
+
+                        /**
+                         *  Gets the position of the oldest event not yet removed
+                         *  by drain or poll.
+                         *  @return dequeue position.
+                         */
+                        unsigned int getDequeuePosition() const;
+
+                private:
+                        enum { CACHE_LINE_SIZE = 64 };
+
+                        struct SlotFields {
+                                volatile unsigned int sequence;
+                                spi::LoggingEvent* event;
+                        };
+
+                        /**
+                         *  Slot padded to a cache line so producers
+                         *  writing neighbouring slots do not contend.
+                         */
+                        struct Slot : SlotFields {
+                                char padding[CACHE_LINE_SIZE - sizeof(SlotFields)];
+                        };
+
+                        char padding0[CACHE_LINE_SIZE];
+                        mutable volatile unsigned int enqueuePosition;
+                        char padding1[CACHE_LINE_SIZE - sizeof(unsigned int)];
+                        mutable volatile unsigned int dequeuePosition;
+                        char padding2[CACHE_LINE_SIZE - sizeof(unsigned int)];
+                        const unsigned int mask;
+                        /**
+                         *  Storage of the slots, one cache line longer
+                         *  than needed so that they start on a cache line.
+                         */
+                        char* const storage;
+                        Slot* const slots;
+
+                        static unsigned int roundCapacity(int capacity);
+                        static Slot* alignSlots(char* storage);
+                        EventRingBuffer(const EventRingBuffer&);
+                        EventRingBuffer& operator=(const EventRingBuffer&);
+                };
+        }
+}
+
+#if defined(_MSC_VER)
+#pragma warning ( pop )
+#endif
+
+#endif //_LOG4CXX_HELPERS_EVENT_RING_BUFFER_H
@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_HELPERS_EVENT_SPOOL_H
+#define _LOG4CXX_HELPERS_EVENT_SPOOL_H
+
+#if defined(_MSC_VER)
+#pragma warning ( push )
+#pragma warning ( disable: 4231 4251 4275 4786 )
+#endif
+
+#include <log4cxx/spi/loggingevent.h>
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/file.h>
+#include <map>
+#include <string>
+
+namespace log4cxx
+{
+        namespace helpers
+        {
+                /**
+                 *  First in, first out store of logging events in a local
+                 *  binary file, used by AsyncAppender to hold the events that
+                 *  do not fit in its buffer.  Levels, logger names and
+                 *  locations are kept in memory and only referenced by index
+                 *  from the file, so the file can only be read by the spool
+                 *  that wrote it.  The file is truncated whenever all events
+                 *  have been read and removed when the spool is destroyed.
+                 *
+                 *  <p>Not thread safe, callers must serialize access.
+                 */
+                class LOG4CXX_EXPORT EventSpool
+                {
+                public:
+                        /**
+                         *  Creates a spool, the file is opened on the first write.
+                         *  @param fileName path of the spool file.
+                         */
+                        explicit EventSpool(const LogString& fileName);
+                        /**
+                         *  Closes and removes the spool file.
+                         */
+                        ~EventSpool();
+
+                        /**
+                         *  Appends an event to the file.
+                         *  @param event event, the NDC, thread name and MDC
+                         *  copy must already have been captured.
+                         *  @return false if the file could not be opened or written.
+                         */
+                        bool write(const spi::LoggingEventPtr& event);
+
+                        /**
+                         *  Reads the oldest events.
+                         *  @param events list to which events are appended.
+                         *  @param maxCount maximum number of events to read.
+                         *  @return number of events read.
+                         */
+                        size_t read(spi::LoggingEventList& events, size_t maxCount);
+
+                        /**
+                         *  Determines whether all written events have been read.
+                         *  @return true if empty.
+                         */
+                        bool isEmpty() const;
+
+                        const LogString& getFileName() const;
+
+                private:
+                        LogString fileName;
+                        Pool pool;
+                        apr_file_t* file;
+                        log4cxx_int64_t readOffset;
+                        log4cxx_int64_t writeOffset;
+                        bool failed;
+                        std::string record;
+                        std::vector<LevelPtr> levels;
+                        std::vector<spi::LoggerNamePtr> loggers;
+                        std::map<const spi::LoggerName*, unsigned int> loggerIndex;
+                        std::vector<spi::LocationInfo> locations;
+                        std::map<std::string, unsigned int> locationIndex;
+
+                        bool open();
+                        void reset();
+                        void fail(const LogString& msg, log4cxx_status_t stat);
+                        unsigned int indexOf(const LevelPtr& level);
+                        unsigned int indexOf(const spi::LoggerNamePtr& logger);
+                        unsigned int indexOf(const spi::LocationInfo& location);
+                        spi::LoggingEventPtr decode(const std::string& body) const;
+                        EventSpool(const EventSpool&);
+                        EventSpool& operator=(const EventSpool&);
+                };
+        }
+}
+
+#if defined(_MSC_VER)
+#pragma warning ( pop )
+#endif
+
+#endif //_LOG4CXX_HELPERS_EVENT_SPOOL_H
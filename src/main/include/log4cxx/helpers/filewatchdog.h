@@ -70,6 +70,13 @@ namespace log4cxx
 
                         void start();
 
+                        /**
+                        Gets the name, affinity and priority of the watchdog
+                        thread, to be changed before #start.
+                        */
+                        ThreadSettings& getThreadSettings()
+                                { return thread.getSettings(); }
+
                 private:
                     static void* LOG4CXX_THREAD_FUNC run(apr_thread_t* thread, void* data);
                         Pool pool;
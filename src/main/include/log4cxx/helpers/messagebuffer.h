@@ -29,6 +29,105 @@ namespace log4cxx {
    
    typedef std::ios_base& (*ios_base_manip)(std::ios_base&);
 
+   /**
+    *   Unbuffered stream buffer appending to a string,
+    *   lets stream insertions write directly into a message.
+    */
+   template<class T> class StringStreamBuf : public std::basic_streambuf<T> {
+   public:
+        typedef typename std::basic_streambuf<T>::traits_type traits_type;
+        typedef typename std::basic_streambuf<T>::int_type int_type;
+
+        explicit StringStreamBuf(std::basic_string<T>& dest) : target(dest) {
+        }
+
+   protected:
+        int_type overflow(int_type c) {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                target.append(1, traits_type::to_char_type(c));
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const T* s, std::streamsize n) {
+            target.append(s, (size_t) n);
+            return n;
+        }
+
+   private:
+        std::basic_string<T>& target;
+        StringStreamBuf(const StringStreamBuf&);
+        StringStreamBuf& operator=(const StringStreamBuf&);
+   };
+
+   /**
+    *   String and stream used by a message buffer.  Each thread keeps
+    *   one instance per character type in a MessageBufferCache, so
+    *   their capacity is reused by successive logging statements.
+    */
+   template<class T> class MessageBufferStorage {
+   public:
+        /**
+         *  Largest capacity kept between logging statements.
+         */
+        enum { MAX_RETAINED_CAPACITY = 65536 };
+
+        explicit MessageBufferStorage(bool cached1)
+           : buf(), streambuf(buf), stream(&streambuf),
+             inUse(false), cached(cached1) {
+        }
+
+        /**
+         *  Empties the string and restores the default stream state.
+         */
+        void reset() {
+            if (buf.capacity() > MAX_RETAINED_CAPACITY) {
+                std::basic_string<T>().swap(buf);
+            } else {
+                buf.erase();
+            }
+            stream.clear();
+            stream.flags(std::ios_base::skipws | std::ios_base::dec);
+            stream.precision(6);
+            stream.width(0);
+            stream.fill((T) 0x20);
+        }
+
+        std::basic_string<T> buf;
+        StringStreamBuf<T> streambuf;
+        std::basic_ostream<T> stream;
+        /** true while used by a message buffer. */
+        bool inUse;
+        /** true if owned by a MessageBufferCache. */
+        const bool cached;
+
+   private:
+        MessageBufferStorage(const MessageBufferStorage&);
+        MessageBufferStorage& operator=(const MessageBufferStorage&);
+   };
+
+   /**
+    *   Message buffer storage of one thread,
+    *   owned by ThreadSpecificData and created on demand.
+    */
+   class MessageBufferCache {
+   public:
+        MessageBufferCache();
+        ~MessageBufferCache();
+
+        MessageBufferStorage<char>* charStorage;
+#if LOG4CXX_WCHAR_T_API
+        MessageBufferStorage<wchar_t>* wideStorage;
+#endif
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API || LOG4CXX_LOGCHAR_IS_UNICHAR
+        MessageBufferStorage<UniChar>* uniStorage;
+#endif
+
+   private:
+        MessageBufferCache(const MessageBufferCache&);
+        MessageBufferCache& operator=(const MessageBufferCache&);
+   };
+
    /**
     *   This class is used by the LOG4CXX_INFO and similar
     *   macros to support insertion operators in the message parameter.
@@ -175,14 +274,20 @@ namespace log4cxx {
          */
       CharMessageBuffer& operator=(const CharMessageBuffer&);
 
-      /**
-         * Encapsulated std::string.
+        /**
+         *  Returns the string of storage, acquiring storage on first use.
          */
-        std::basic_string<char> buf;
+        std::basic_string<char>& buffer();
+
         /**
-         *  Encapsulated stream, created on demand.
+         *  Storage of the current thread or private to this buffer
+         *  when nested in another logging statement, acquired on demand.
          */
-        std::basic_ostringstream<char>* stream;
+        MessageBufferStorage<char>* storage;
+        /**
+         *  true once the stream of storage has been used.
+         */
+        bool streamUsed;
    };
 
 template<class V>
@@ -350,14 +455,20 @@ std::basic_ostream<char>& operator<<(CharMessageBuffer& os, const V& val) {
          */
       UniCharMessageBuffer& operator=(const UniCharMessageBuffer&);
 
-      /**
-         * Encapsulated std::string.
+        /**
+         *  Returns the string of storage, acquiring storage on first use.
+         */
+        std::basic_string<UniChar>& buffer();
+
+        /**
+         *  Storage of the current thread or private to this buffer
+         *  when nested in another logging statement, acquired on demand.
          */
-        std::basic_string<UniChar> buf;
+        MessageBufferStorage<UniChar>* storage;
         /**
-         *  Encapsulated stream, created on demand.
+         *  true once the stream of storage has been used.
          */
-        std::basic_ostringstream<UniChar>* stream;
+        bool streamUsed;
    };
 
 template<class V>
@@ -514,14 +625,20 @@ UniCharMessageBuffer::uostream& operator<<(UniCharMessageBuffer& os, const V& va
          */
       WideMessageBuffer& operator=(const WideMessageBuffer&);
 
-      /**
-         * Encapsulated std::string.
+        /**
+         *  Returns the string of storage, acquiring storage on first use.
+         */
+        std::basic_string<wchar_t>& buffer();
+
+        /**
+         *  Storage of the current thread or private to this buffer
+         *  when nested in another logging statement, acquired on demand.
          */
-        std::basic_string<wchar_t> buf;
+        MessageBufferStorage<wchar_t>* storage;
         /**
-         *  Encapsulated stream, created on demand.
+         *  true once the stream of storage has been used.
          */
-        std::basic_ostringstream<wchar_t>* stream;
+        bool streamUsed;
    };
 
 template<class V>
@@ -790,14 +907,14 @@ std::basic_ostream<wchar_t>& operator<<(WideMessageBuffer& os, const V& val) {
         CharMessageBuffer cbuf;
 
         /**
-         * Encapsulated wide message buffer, created on demand.
+         * Encapsulated wide message buffer.
          */
-        WideMessageBuffer* wbuf;        
+        WideMessageBuffer wbuf;
 #if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
         /**
-         * Encapsulated wide message buffer, created on demand.
+         * Encapsulated UniChar message buffer.
          */
-        UniCharMessageBuffer* ubuf;        
+        UniCharMessageBuffer ubuf;
 #endif        
    };
 
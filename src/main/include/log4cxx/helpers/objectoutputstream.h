@@ -25,6 +25,11 @@
 
 namespace log4cxx
 {
+	namespace spi
+	{
+		class LoggerName;
+	}
+
 	namespace helpers
 	{
 		/**
@@ -48,6 +53,10 @@ namespace log4cxx
 				void writeObject(const LogString&, Pool& p);
 				void writeUTFString(const std::string&, Pool& p);
 				void writeObject(const MDC::Map& mdc, Pool& p);
+				/**
+				 *  Writes a logger name using its UTF-8 encoding.
+				 */
+				void writeObject(const spi::LoggerName& name, Pool& p);
 				void writeInt(int val, Pool& p);
 				void writeLong(log4cxx_time_t val, Pool& p);
 				void writeProlog(const	char*	className,
@@ -50,6 +50,8 @@ namespace log4cxx
                   virtual void close(Pool& p);
                   virtual void flush(Pool& p);
                   virtual void write(const LogString& str, Pool& p);
+                  virtual bool isUTF8() const;
+                  virtual void writeUTF8(const std::string& str, Pool& p);
                   LogString getEncoding() const;
 
 #ifdef LOG4CXX_MULTI_PROCESS
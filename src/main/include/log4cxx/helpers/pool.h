@@ -44,6 +44,11 @@ namespace log4cxx
                         char* pstrndup(const char* s, size_t len);
                         char* pstrdup(const char*s);
                         char* pstrdup(const std::string&);
+                        /**
+                         *  Releases all memory allocated from this pool
+                         *  while keeping the pool itself for reuse.
+                         */
+                        void clear();
 
                 protected:
                         apr_pool_t* pool;
@@ -54,6 +54,11 @@ namespace log4cxx
             static LogString toLowerCase(const LogString& s);
 
             static LogString format(const LogString& pattern, const std::vector<LogString>& params);
+
+            /**
+             *  Computes a hash of the characters like java.lang.String.hashCode.
+             */
+            static unsigned int hashCode(const LogString& s);
         };
     }
 }
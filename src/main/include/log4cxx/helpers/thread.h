@@ -19,7 +19,9 @@
 #define _LOG4CXX_HELPERS_THREAD_H
 
 #include <log4cxx/log4cxx.h>
+#include <log4cxx/logstring.h>
 #include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/threadsettings.h>
 
 #if !defined(LOG4CXX_THREAD_FUNC)
 #if defined(_WIN32)
@@ -95,7 +97,22 @@ namespace log4cxx
                          *  sets the interrupted status to false.
                          */
                         static bool interrupted();
+
+                        /**
+                         *  Sets the name reported for the calling thread by
+                         *  logging events, for example by the %t pattern.
+                         *  The thread identifier is used until a name is set.
+                         *  @param name thread name, empty to restore the thread identifier.
+                         */
+                        static void setCurrentThreadName(const LogString& name);
                         
+                        /**
+                         *  Gets the name, affinity and priority applied by the
+                         *  thread when it starts.  Changes take effect on the
+                         *  next call to run.
+                         */
+                        inline ThreadSettings& getSettings() { return settings; }
+
                         bool isAlive();
                         bool isCurrentThread() const;
                         void ending();
@@ -108,6 +125,7 @@ namespace log4cxx
                         volatile unsigned int interruptedStatus;
                         apr_thread_mutex_t* interruptedMutex;
                         apr_thread_cond_t* interruptedCondition;
+                        ThreadSettings settings;
                         Thread(const Thread&);
                         Thread& operator=(const Thread&);
                         friend void* LOG4CXX_THREAD_FUNC ThreadLaunch::launcher(apr_thread_t* thread, void* data); 
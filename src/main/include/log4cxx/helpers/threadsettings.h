@@ -0,0 +1,105 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_HELPERS_THREAD_SETTINGS_H
+#define _LOG4CXX_HELPERS_THREAD_SETTINGS_H
+
+#include <log4cxx/log4cxx.h>
+#include <log4cxx/logstring.h>
+#include <vector>
+
+namespace log4cxx
+{
+        namespace helpers
+        {
+                /**
+                 *  Name, processor affinity and scheduling priority of
+                 *  a thread started by log4cxx, applied by the thread
+                 *  itself when it starts.
+                 *
+                 *  <p>Components that own a thread accept the options
+                 *  <b>ThreadName</b>, <b>ThreadAffinity</b> and
+                 *  <b>ThreadPriority</b>:
+                 *  <ul>
+                 *  <li><b>ThreadName</b> is reported by %t and, truncated to
+                 *  15 characters, passed to the operating system.</li>
+                 *  <li><b>ThreadAffinity</b> is a list of processors such as
+                 *  <code>0,2-3</code>, empty for no restriction.  Lists naming
+                 *  a processor beyond those a thread can be bound to, 1024
+                 *  on Linux, are rejected.</li>
+                 *  <li><b>ThreadPriority</b> is a nice value, -20 (highest)
+                 *  to 19 (lowest).  Raising the priority usually needs
+                 *  privileges.</li>
+                 *  </ul>
+                 *  Affinity and priority are supported on Linux and Windows,
+                 *  failures are reported through LogLog and do not stop
+                 *  the thread.</p>
+                 */
+                class LOG4CXX_EXPORT ThreadSettings
+                {
+                public:
+                        ThreadSettings();
+                        ThreadSettings(const LogString& name);
+
+                        void setName(const LogString& name);
+                        const LogString& getName() const;
+
+                        /**
+                         *  Sets the processors the thread may run on.
+                         *  @param cpus comma separated processor numbers or ranges.
+                         */
+                        void setAffinity(const LogString& cpus);
+                        const LogString& getAffinity() const;
+
+                        /**
+                         *  Sets the priority of the thread.
+                         *  @param nice nice value, lower is more favorable.
+                         */
+                        void setPriority(int nice);
+                        int getPriority() const;
+                        /**
+                         *  Determines whether a priority was set, otherwise
+                         *  the thread keeps the priority it inherited.
+                         */
+                        bool hasPriority() const;
+
+                        /**
+                         *  Sets ThreadName, ThreadAffinity or ThreadPriority.
+                         *  @param option option name.
+                         *  @param value option value.
+                         *  @return true if the option is a thread setting.
+                         */
+                        bool setOption(const LogString& option, const LogString& value);
+
+                        /**
+                         *  Applies the settings to the calling thread.
+                         *  @param suffix appended to the name, used to tell
+                         *  apart several threads sharing the settings.
+                         */
+                        void apply(const LogString& suffix = LogString()) const;
+
+                private:
+                        LogString name;
+                        LogString affinity;
+                        std::vector<int> cpus;
+                        int priority;
+                        bool prioritySet;
+                };
+        } // namespace helpers
+} // namespace log4cxx
+
+#endif //_LOG4CXX_HELPERS_THREAD_SETTINGS_H
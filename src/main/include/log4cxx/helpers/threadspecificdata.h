@@ -20,12 +20,22 @@
 
 #include <log4cxx/ndc.h>
 #include <log4cxx/mdc.h>
+#include <log4cxx/spi/mdcsnapshot.h>
+#include <vector>
 
 
 namespace log4cxx
 {
+        namespace spi
+        {
+                class LoggingEvent;
+        }
+
         namespace helpers
         {
+                class Pool;
+                class MessageBufferCache;
+
                 /**
                   *   This class contains all the thread-specific
                   *   data in use by log4cxx.
@@ -47,11 +57,72 @@ namespace log4cxx
                         void recycle();
                         
                         static void put(const LogString& key, const LogString& val);
+                        static bool remove(const LogString& key, LogString& prevVal);
+                        static void clearMap();
                         static void push(const LogString& val);
                         static void inherit(const log4cxx::NDC::Stack& stack);
                         
                         log4cxx::NDC::Stack& getStack();
+                        const log4cxx::MDC::Map& getMap() const;
+                        /**
+                         *  Gets the MDC for modification, discarding the snapshot
+                         *  shared by the events logged since the last change.
+                         *  @deprecated use put, remove and clearMap, which keep
+                         *  the snapshot while the MDC does not change.
+                         */
                         log4cxx::MDC::Map& getMap();
+
+                        /**
+                         *  Gets an immutable copy of the MDC of the current thread,
+                         *  made on first request after the MDC changed.
+                         *  @return snapshot, null if the MDC is empty.
+                         */
+                        static spi::MDCSnapshotPtr getMDCSnapshot();
+
+                        /**
+                         *  Gets the pool for a logging request on the current thread.
+                         *  The same pool is handed to every request and cleared by
+                         *  releasePool, so steady state logging creates no pools.
+                         *  @return pool, or null if an enclosing request on
+                         *  this thread is still using it.
+                         */
+                        static Pool* acquirePool();
+                        /**
+                         *  Clears a pool obtained from acquirePool for the next request.
+                         *  @param p pool returned by acquirePool.
+                         */
+                        static void releasePool(Pool* p);
+
+                        /**
+                         *  Gets the storage reused by the message buffers
+                         *  of logging statements on the current thread.
+                         *  @return storage, created on first use, or null
+                         *  if no thread specific data could be created.
+                         */
+                        static MessageBufferCache* getMessageBufferCache();
+
+                        /**
+                         *  Gets the name of the current thread, formatted from
+                         *  the thread identifier on first use unless set by
+                         *  setThreadName.
+                         *  @return thread name, valid until the name of the current
+                         *  thread changes, or an empty name if no thread specific
+                         *  data could be created.
+                         */
+                        static const LogString& getThreadName();
+                        /**
+                         *  Sets the name of the current thread used by logging events.
+                         *  @param name thread name, if empty the thread identifier is used.
+                         */
+                        static void setThreadName(const LogString& name);
+
+                        /**
+                         *  Gets the logging events released on the current thread
+                         *  and kept for reuse by spi::LoggingEvent::create.
+                         *  @return events, or null if no thread specific data
+                         *  could be created.
+                         */
+                        static std::vector<spi::LoggingEvent*>* getEventCache();
                         
 
                 private:
@@ -59,6 +130,13 @@ namespace log4cxx
                         static ThreadSpecificData* createCurrentData();
                         log4cxx::NDC::Stack ndcStack;
                         log4cxx::MDC::Map mdcMap;
+                        spi::MDCSnapshotPtr mdcSnapshot;
+                        Pool* pool;
+                        bool poolInUse;
+                        MessageBufferCache* messageBuffers;
+                        LogString threadName;
+                        std::vector<spi::LoggingEvent*> events;
+                        static LogString formatThreadId();
                 };
 
         }  // namespace helpers
@@ -55,12 +55,28 @@ namespace log4cxx
             virtual log4cxx_status_t explode(apr_time_exp_t* result,
                     log4cxx_time_t input) const = 0;
 
+            /**
+             *   Expand an APR time like explode, reusing the fields
+             *      of the minute expanded last.  The minute is shared
+             *      by all threads using this time zone, only seconds
+             *      and microseconds are computed for each call.
+             */
+            log4cxx_status_t explodeCached(apr_time_exp_t* result,
+                    log4cxx_time_t input) const;
+
 
       protected:
             TimeZone(const LogString& ID);
             virtual ~TimeZone();
 
             const LogString id;
+
+      private:
+            struct ExplodedMinute;
+            ExplodedMinute* const minute;
+
+            TimeZone(const TimeZone&);
+            TimeZone& operator=(const TimeZone&);
       };
 
 
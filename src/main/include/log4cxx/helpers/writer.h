@@ -45,6 +45,19 @@ namespace log4cxx
                   virtual void close(Pool& p) = 0;
                   virtual void flush(Pool& p) = 0;
                   virtual void write(const LogString& str, Pool& p) = 0;
+
+                  /**
+                  *   Determines if the writer encodes text as UTF-8, so that
+                  *   text already encoded by writeUTF8 is passed through.
+                  *   The base class returns false.
+                  */
+                  virtual bool isUTF8() const;
+
+                  /**
+                  *   Writes text already encoded in UTF-8.  The base class
+                  *   decodes it and calls write.
+                  */
+                  virtual void writeUTF8(const std::string& str, Pool& p);
 #ifdef LOG4CXX_MULTI_PROCESS
                   virtual OutputStreamPtr getOutPutStreamPtr();
 #endif
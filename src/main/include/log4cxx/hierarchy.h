@@ -70,6 +70,23 @@ namespace log4cxx
             typedef std::map<LogString, ProvisionNode> ProvisionNodeMap;
             ProvisionNodeMap* provisionNodes;
 
+            class LoggerTable;
+            /**
+            Index of the loggers held in <code>loggers</code> that is searched
+            without locking.  Only modified while holding mutex and replaced
+            as a whole when it grows or is cleared.
+            */
+            LoggerTable* volatile table;
+            /**
+            Number of searches in progress in table,
+            indexed by the epoch in which they started.
+            */
+            mutable volatile log4cxx_uint32_t searches[2];
+            /**
+            Flipped between 0 and 1 whenever table is replaced.
+            */
+            mutable volatile log4cxx_uint32_t epoch;
+
             LoggerPtr root;
 
             int thresholdInt;
@@ -271,6 +288,23 @@ namespace log4cxx
             Hierarchy& operator=(const Hierarchy&);
 
             void updateChildren(ProvisionNode& pn, LoggerPtr logger);
+
+            /**
+            Adds a fully linked logger to table, called while holding mutex.
+            */
+            void publishLogger(Logger* logger);
+
+            /**
+            Registers a search of table, returns the epoch to pass to endSearch.
+            */
+            log4cxx_uint32_t beginSearch() const;
+            void endSearch(log4cxx_uint32_t searchEpoch) const;
+
+            /**
+            Replaces table, called while holding mutex.  The old table is
+            deleted once no search that may have seen it is in progress.
+            */
+            void replaceTable(LoggerTable* newTable);
         };
 
 }  //namespace log4cxx
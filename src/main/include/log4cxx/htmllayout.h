@@ -121,6 +121,9 @@ namespace log4cxx
                 virtual bool ignoresThrowable() const
                         { return false; }
 
+                virtual bool requiresMDC() const
+                        { return false; }
+
         }; // class HtmlLayout
       LOG4CXX_PTR_DEF(HTMLLayout);
 }  // namespace log4cxx
@@ -86,6 +86,25 @@ namespace log4cxx
                 xml::XMLLayout XMLLayout} returns <code>false</code>.
                 */
                 virtual bool ignoresThrowable() const = 0;
+
+                /**
+                Returns <code>true</code> if the layout formats the mapped
+                diagnostic context of events, which then has to be copied
+                before an event is formatted on another thread.  The base
+                class returns <code>true</code>.
+                */
+                virtual bool requiresMDC() const;
+
+                /**
+                Formats the event directly as UTF-8 encoded bytes, for
+                writers that would otherwise encode the formatted text to
+                UTF-8 themselves.  Returns <code>false</code> without
+                appending anything if the layout has no such path, in which
+                case format has to be used.  The base class returns
+                <code>false</code>.
+                */
+                virtual bool formatUTF8(std::string& output,
+                    const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& pool) const;
         };
         LOG4CXX_PTR_DEF(Layout);
 }
@@ -190,6 +190,12 @@ namespace log4cxx
                 */
                 LogString toString() const;
 
+                /**
+                 *  Appends the name of the level encoded in UTF-8.
+                 *  @param dst buffer to which the encoded name is appended.
+                 */
+                void toUTF8(std::string& dst) const;
+
                 /**
                 Convert an integer passed as argument to a level. If the
                 conversion fails, then this method returns DEBUG.
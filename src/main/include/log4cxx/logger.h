@@ -30,6 +30,8 @@
 #include <log4cxx/spi/location/locationinfo.h>
 #include <log4cxx/helpers/resourcebundle.h>
 #include <log4cxx/helpers/messagebuffer.h>
+#include <log4cxx/helpers/deferredmessage.h>
+#include <log4cxx/spi/loggername.h>
 
 
 namespace log4cxx
@@ -79,6 +81,11 @@ namespace log4cxx
         */
         LogString name;
 
+        /**
+        The name of this logger shared with its logging events.
+        */
+        spi::LoggerNamePtr loggerName;
+
         /**
         The assigned level of this logger.  The
         <code>level</code> variable need not be assigned a value in
@@ -100,6 +107,10 @@ namespace log4cxx
         // Loggers need to know what Hierarchy they are in
         log4cxx::spi::LoggerRepository * repository;
 
+        /**
+        Appenders of this logger, created with the logger and never replaced
+        so that callAppenders can walk the hierarchy without locking.
+        */
         helpers::AppenderAttachableImplPtr aai;
 
                 /** Additivity is set to true by default, that is children inherit
@@ -589,6 +600,17 @@ namespace log4cxx
         void forcedLogLS(const LevelPtr& level, const LogString& message,
                         const log4cxx::spi::LocationInfo& location) const;
 
+        /**
+        This method creates a new logging event whose message is
+        formatted the first time it is requested and logs the event
+        without further checks.
+        @param level the level to log.
+        @param message the message to format.
+        @param location location of the logging statement.
+        */
+        void forcedLog(const LevelPtr& level, const helpers::DeferredMessage& message,
+                        const log4cxx::spi::LocationInfo& location) const;
+
         /**
         Get the additivity flag for this Logger instance.
         */
@@ -1716,6 +1738,36 @@ namespace log4cxx
         Logger& operator=(const Logger&);
         log4cxx::helpers::Mutex mutex;
         friend class log4cxx::helpers::synchronized;
+
+        /**
+        Lowest level enabled by both the effective level of this logger
+        and the repository threshold.  Read without locking by the
+        isXXXEnabled() methods while thresholdGeneration is current.
+        */
+        mutable volatile log4cxx_uint32_t threshold;
+
+        /**
+        Generation in which threshold was computed.
+        */
+        mutable volatile log4cxx_uint32_t thresholdGeneration;
+
+        /**
+        Returns true if a request of the given level would be logged.
+        */
+        bool isLevelEnabled(int levelInt) const;
+
+        /**
+        Recomputes and publishes the cached threshold.
+        */
+        bool updateThreshold(int levelInt) const;
+
+        /**
+        Starts a new threshold generation, so that every logger
+        recomputes its cached threshold on next use.  Called whenever
+        a level, a parent chain, a repository threshold or the
+        configured state changes.
+        */
+        static void invalidateThresholds();
    };
    LOG4CXX_LIST_DEF(LoggerList, LoggerPtr);
 
@@ -1874,6 +1926,104 @@ Logs a message to a specified logger with the FATAL level.
 #define LOG4CXX_FATAL(logger, message)
 #endif
 
+/**
+Logs a message to a specified logger with a specified level,
+formatting it when first needed instead of on the calling thread.
+The format is followed by up to eight arguments, each "{}" in the
+format is replaced by the next argument.  The format is not copied
+and should be a string literal.
+
+@param logger the logger to be used.
+@param level the level to log.
+*/
+#define LOG4CXX_LOG_ASYNC(logger, level, ...) do { \
+        if (logger->isEnabledFor(level)) {\
+           logger->forcedLog(level, ::log4cxx::helpers::DeferredMessage(__VA_ARGS__), LOG4CXX_LOCATION); }} while (0)
+
+#if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 10000
+/**
+Logs a message to a specified logger with the DEBUG level,
+see LOG4CXX_LOG_ASYNC.
+
+@param logger the logger to be used.
+*/
+#define LOG4CXX_DEBUG_ASYNC(logger, ...) do { \
+        if (logger->isDebugEnabled()) {\
+           logger->forcedLog(::log4cxx::Level::getDebug(), ::log4cxx::helpers::DeferredMessage(__VA_ARGS__), LOG4CXX_LOCATION); }} while (0)
+#else
+#define LOG4CXX_DEBUG_ASYNC(logger, ...)
+#endif
+
+#if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 5000
+/**
+Logs a message to a specified logger with the TRACE level,
+see LOG4CXX_LOG_ASYNC.
+
+@param logger the logger to be used.
+*/
+#define LOG4CXX_TRACE_ASYNC(logger, ...) do { \
+        if (logger->isTraceEnabled()) {\
+           logger->forcedLog(::log4cxx::Level::getTrace(), ::log4cxx::helpers::DeferredMessage(__VA_ARGS__), LOG4CXX_LOCATION); }} while (0)
+#else
+#define LOG4CXX_TRACE_ASYNC(logger, ...)
+#endif
+
+#if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 20000
+/**
+Logs a message to a specified logger with the INFO level,
+see LOG4CXX_LOG_ASYNC.
+
+@param logger the logger to be used.
+*/
+#define LOG4CXX_INFO_ASYNC(logger, ...) do { \
+        if (logger->isInfoEnabled()) {\
+           logger->forcedLog(::log4cxx::Level::getInfo(), ::log4cxx::helpers::DeferredMessage(__VA_ARGS__), LOG4CXX_LOCATION); }} while (0)
+#else
+#define LOG4CXX_INFO_ASYNC(logger, ...)
+#endif
+
+#if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 30000
+/**
+Logs a message to a specified logger with the WARN level,
+see LOG4CXX_LOG_ASYNC.
+
+@param logger the logger to be used.
+*/
+#define LOG4CXX_WARN_ASYNC(logger, ...) do { \
+        if (logger->isWarnEnabled()) {\
+           logger->forcedLog(::log4cxx::Level::getWarn(), ::log4cxx::helpers::DeferredMessage(__VA_ARGS__), LOG4CXX_LOCATION); }} while (0)
+#else
+#define LOG4CXX_WARN_ASYNC(logger, ...)
+#endif
+
+#if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 40000
+/**
+Logs a message to a specified logger with the ERROR level,
+see LOG4CXX_LOG_ASYNC.
+
+@param logger the logger to be used.
+*/
+#define LOG4CXX_ERROR_ASYNC(logger, ...) do { \
+        if (logger->isErrorEnabled()) {\
+           logger->forcedLog(::log4cxx::Level::getError(), ::log4cxx::helpers::DeferredMessage(__VA_ARGS__), LOG4CXX_LOCATION); }} while (0)
+#else
+#define LOG4CXX_ERROR_ASYNC(logger, ...)
+#endif
+
+#if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 50000
+/**
+Logs a message to a specified logger with the FATAL level,
+see LOG4CXX_LOG_ASYNC.
+
+@param logger the logger to be used.
+*/
+#define LOG4CXX_FATAL_ASYNC(logger, ...) do { \
+        if (logger->isFatalEnabled()) {\
+           logger->forcedLog(::log4cxx::Level::getFatal(), ::log4cxx::helpers::DeferredMessage(__VA_ARGS__), LOG4CXX_LOCATION); }} while (0)
+#else
+#define LOG4CXX_FATAL_ASYNC(logger, ...)
+#endif
+
 /**
 Logs a localized message with no parameter.
 
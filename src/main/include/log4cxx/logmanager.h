@@ -49,6 +49,7 @@ namespace log4cxx
     {
     private:
         static void * guard;
+        static volatile int shutdownTimeout;
         static spi::RepositorySelectorPtr& getRepositorySelector();
 
     public:
@@ -192,10 +193,24 @@ namespace log4cxx
 
         /**
         Safely close and remove all appenders in all loggers including
-        the root logger.
+        the root logger.  If a shutdown timeout is set, asynchronous
+        appenders are first flushed and closed within that time.
         */
         static void shutdown();
 
+        /**
+        Sets the time shutdown lets asynchronous appenders write
+        their buffered events, events still buffered afterwards are
+        discarded.  Set with <code>log4j.shutdownTimeout</code> in property
+        files or the <code>shutdownTimeout</code> attribute of
+        <code>log4j:configuration</code>.
+        @param timeout time in milliseconds for all appenders together,
+        negative (the default) to wait until all events are written.
+        */
+        static void setShutdownTimeout(int timeout);
+
+        static int getShutdownTimeout();
+
         /**
         Reset all values contained in this current {@link
         spi::LoggerRepository LoggerRepository}  to their default.
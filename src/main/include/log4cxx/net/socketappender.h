@@ -122,6 +122,11 @@ namespace log4cxx
 				virtual int getDefaultPort() const;
 				void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& pool);
 
+				/**
+				Writes all events to the stream before flushing it once.
+				*/
+				void appendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& pool);
+
 			private:
 				log4cxx::helpers::ObjectOutputStreamPtr oos;
 
@@ -31,6 +31,10 @@ namespace log4cxx
 
                 /**
                  *  Abstract base class for SocketAppender and XMLSocketAppender
+                 *
+                 *  <p>The <b>ThreadName</b>, <b>ThreadAffinity</b> and
+                 *  <b>ThreadPriority</b> options configure the connector
+                 *  thread, see helpers::ThreadSettings.
                  */
         class LOG4CXX_EXPORT SocketAppenderSkeleton : public AppenderSkeleton
         {
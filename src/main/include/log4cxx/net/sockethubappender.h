@@ -103,6 +103,10 @@ namespace log4cxx
                 the <code>SocketHubAppender</code> either explicitly or by calling
                 the LogManager#shutdown method before
                 exiting the application.
+
+                <p>The <b>ThreadName</b>, <b>ThreadAffinity</b> and
+                <b>ThreadPriority</b> options configure the server thread,
+                see helpers::ThreadSettings.
                 */
 
                 class LOG4CXX_EXPORT SocketHubAppender : public AppenderSkeleton
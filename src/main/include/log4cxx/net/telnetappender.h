@@ -65,6 +65,13 @@ servlet.
 <td>optional</td>
 <td>This parameter determines the port to use for announcing log events.  The default port is 23 (telnet).</td>
 <td>5875</td>
+</tr>
+
+<tr>
+<td>ThreadName, ThreadAffinity, ThreadPriority</td>
+<td>optional</td>
+<td>Name, processors and nice value of the acceptor thread, see helpers::ThreadSettings.</td>
+<td>TelnetAcceptor, 3, 10</td>
 </table>
 */
         class LOG4CXX_EXPORT TelnetAppender : public AppenderSkeleton
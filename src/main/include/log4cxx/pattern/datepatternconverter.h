@@ -34,6 +34,12 @@ namespace log4cxx {
  * 
  */
 class LOG4CXX_EXPORT DatePatternConverter : public LoggingEventPatternConverter {
+  /**
+   * Key of df among the shared date formats, empty if not shared.
+   * Declared before df which fills it on construction.
+   */
+  LogString sharedKey;
+
   /**
    * Date format.
    */
@@ -47,12 +53,32 @@ class LOG4CXX_EXPORT DatePatternConverter : public LoggingEventPatternConverter
   DatePatternConverter(const OptionsList& options);
 
   /**
-   * Obtains an instance of pattern converter.
+   * Obtains the date format for the options, shared by all converters
+   * with the same options and locale so that they share its cache.
    * @param options options, may be null.
-   * @return instance of pattern converter.
+   * @param key set to the key to pass to releaseDateFormat,
+   * left empty if the date format is not shared.
+   * @return date format.
+   */
+  static log4cxx::helpers::DateFormatPtr getDateFormat(const OptionsList& options,
+      LogString& key);
+
+  /**
+   * Releases a date format obtained from getDateFormat, dropped from
+   * the shared date formats once no converter uses it.
+   * @param key key set by getDateFormat.
    */
-  static log4cxx::helpers::DateFormatPtr getDateFormat(const OptionsList& options);
+  static void releaseDateFormat(const LogString& key);
+
+  /**
+   * Creates a date format.
+   * @param options options, may be null.
+   * @return date format.
+   */
+  static log4cxx::helpers::DateFormatPtr createDateFormat(const OptionsList& options);
   public:
+  ~DatePatternConverter();
+
   DECLARE_LOG4CXX_PATTERN(DatePatternConverter)
   BEGIN_LOG4CXX_CAST_MAP()
        LOG4CXX_CAST_ENTRY(DatePatternConverter)
@@ -64,6 +90,13 @@ class LOG4CXX_EXPORT DatePatternConverter : public LoggingEventPatternConverter
     const std::vector<LogString>& options);
 
 
+  /**
+   * Gets the date format, shared with other converters
+   * with the same options and locale.
+   * @return date format.
+   */
+  const log4cxx::helpers::DateFormatPtr& getDateFormat() const;
+
   using LoggingEventPatternConverter::format;
 
 
@@ -77,6 +110,8 @@ class LOG4CXX_EXPORT DatePatternConverter : public LoggingEventPatternConverter
   void format(const log4cxx::helpers::DatePtr& date,
      LogString& toAppendTo,
      log4cxx::helpers::Pool& p) const;
+
+  bool requiresMDC() const;
 };
 
 LOG4CXX_PTR_DEF(DatePatternConverter);
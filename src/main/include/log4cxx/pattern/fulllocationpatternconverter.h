@@ -57,6 +57,8 @@ public:
   void format(const log4cxx::spi::LoggingEventPtr& event,
       LogString& toAppendTo,
       log4cxx::helpers::Pool& p) const;
+
+  bool requiresMDC() const;
 };
 
 }
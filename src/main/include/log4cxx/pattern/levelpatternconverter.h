@@ -57,6 +57,8 @@ public:
       log4cxx::helpers::Pool& p) const;
 
   LogString getStyleClass(const log4cxx::helpers::ObjectPtr& e) const;
+
+  bool requiresMDC() const;
 };
 }
 }
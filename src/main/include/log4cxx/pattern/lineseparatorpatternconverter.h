@@ -63,6 +63,8 @@ END_LOG4CXX_CAST_MAP()
   void format(const log4cxx::helpers::ObjectPtr& obj,
       LogString& toAppendTo,
       log4cxx::helpers::Pool& p) const;
+
+  bool requiresMDC() const;
 };
 
 }
@@ -61,6 +61,8 @@ public:
   void format(const log4cxx::helpers::ObjectPtr& obj,
      LogString& toAppendTo,
      log4cxx::helpers::Pool& p) const;
+
+  bool requiresMDC() const;
 };
 
   }
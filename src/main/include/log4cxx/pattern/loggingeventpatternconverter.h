@@ -74,6 +74,16 @@ END_LOG4CXX_CAST_MAP()
    * @return true if this PatternConverter handles throwables
    */
   virtual bool handlesThrowable() const;
+
+  /**
+   * Determines whether the converter reads the mapped diagnostic context,
+   * so that the containing layout can tell if it needs a copy of it.
+   * Defaults to true so that custom converters keep seeing the MDC,
+   * converters that never read it should return false.
+   *
+   * @return true if this PatternConverter may format the MDC
+   */
+  virtual bool requiresMDC() const;
 };
 
 LOG4CXX_PTR_DEF(LoggingEventPatternConverter);
@@ -56,7 +56,8 @@ public:
    * the second and subsequent elements and will use a tilde to indicate abbreviated characters.
    *
    * @param pattern abbreviation pattern.
-   * @return abbreviator, will not be null.
+   * @return abbreviator, will not be null, the same instance
+   * for every request of a pattern.
    */
   static NameAbbreviatorPtr getAbbreviator(const LogString& pattern);
 
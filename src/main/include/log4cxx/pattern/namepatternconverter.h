@@ -64,6 +64,13 @@ protected:
    */
   void abbreviate(int nameStart, LogString& buf) const;
 
+public:
+  /**
+   * Gets the abbreviator.
+   * @return abbreviator.
+   */
+  const NameAbbreviatorPtr& getNameAbbreviator() const;
+
 private:
    NameAbbreviatorPtr getAbbreviator(const std::vector<LogString>& options);
 };
@@ -67,6 +67,8 @@ class LOG4CXX_EXPORT PropertiesPatternConverter
   void format(const log4cxx::spi::LoggingEventPtr& event,
      LogString& toAppendTo,
      log4cxx::helpers::Pool& p) const;
+
+  bool requiresMDC() const;
 };
 }
 }
@@ -56,6 +56,8 @@ END_LOG4CXX_CAST_MAP()
   void format(const log4cxx::spi::LoggingEventPtr& event,
       LogString& toAppendTo,
       log4cxx::helpers::Pool& p) const;
+
+  bool requiresMDC() const;
 };
 }
 }
@@ -71,6 +71,8 @@ END_LOG4CXX_CAST_MAP()
    * @return true.
    */
   bool handlesThrowable() const;
+
+  bool requiresMDC() const;
 };
 }
 }
@@ -27,6 +27,7 @@
 #include <log4cxx/pattern/loggingeventpatternconverter.h>
 #include <log4cxx/pattern/formattinginfo.h>
 #include <log4cxx/pattern/patternparser.h>
+#include <log4cxx/pattern/nameabbreviator.h>
 
 namespace log4cxx
 {
@@ -348,6 +349,42 @@ namespace log4cxx
 		 */
 		FormattingInfoList patternFields;
 
+		/**
+		 * Step of the compiled pattern.  Adjacent literals and line
+		 * separators are merged into one LITERAL step, common
+		 * converters are inlined and the others are called.
+		 */
+		struct Op {
+			enum Type { LITERAL, MESSAGE, LEVEL, LOGGER, THREAD, DATE, CONVERTER };
+			Type type;
+			/** Text of a LITERAL step. */
+			LogString text;
+			/** Text of a LITERAL step encoded in UTF-8. */
+			std::string utf8;
+			pattern::LoggingEventPatternConverterPtr converter;
+			/** Abbreviator of a LOGGER step, null for the full name. */
+			pattern::NameAbbreviatorPtr abbreviator;
+			/** Field width and alignment, null if the field is not padded. */
+			pattern::FormattingInfoPtr padding;
+		};
+
+		/**
+		 * Pattern compiled by activateOptions.
+		 */
+		std::vector<Op> ops;
+
+		/**
+		 * Compiles patternConverters and patternFields into ops.
+		 */
+		void compile();
+
+		/**
+		 * Appends the output of one step.
+		 */
+		void formatOp(const Op& op, LogString& output,
+			const spi::LoggingEventPtr& event,
+			log4cxx::helpers::Pool& pool) const;
+
 	public:
 		DECLARE_LOG4CXX_OBJECT(PatternLayout)
 		BEGIN_LOG4CXX_CAST_MAP()
@@ -392,6 +429,12 @@ namespace log4cxx
 		 */
 		virtual bool ignoresThrowable() const { return true; }
 
+		/**
+		 * Returns true if the pattern contains a converter of the MDC,
+		 * like %X.
+		 */
+		virtual bool requiresMDC() const;
+
 		/**
 		 * Produces a formatted string as specified by the conversion pattern.
 		 */
@@ -399,6 +442,16 @@ namespace log4cxx
 								const spi::LoggingEventPtr& event,
 								log4cxx::helpers::Pool& pool) const;
 
+		/**
+		 * Produces the formatted string encoded in UTF-8.  Literals,
+		 * logger and level names are appended already encoded, other
+		 * fields are encoded as they are formatted.  When LogString
+		 * holds UTF-8 this is format itself.
+		 */
+		virtual bool formatUTF8(std::string& output,
+								const spi::LoggingEventPtr& event,
+								log4cxx::helpers::Pool& pool) const;
+
 	protected:
 		virtual log4cxx::pattern::PatternMap getFormatSpecifiers();
 	};
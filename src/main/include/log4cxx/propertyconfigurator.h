@@ -43,6 +43,7 @@ namespace log4cxx
    namespace helpers
    {
       class Properties;
+      class ThreadSettings;
    }
 
 
@@ -143,6 +144,36 @@ level#classname. By default the repository-wide threshold is set
 to the lowest possible value, namely the level <code>ALL</code>.
 </p>
 
+<h3>Clock</h3>
+
+<p>The source of the time stamps of logging events is shared by all
+repositories and can be selected with:
+
+<pre>
+log4j.clock=[system|coarse|tsc]
+</pre>
+
+<p>The default <code>system</code> clock reads apr_time_now().
+<code>coarse</code> trades resolution (typically a few milliseconds)
+for a cheaper read, <code>tsc</code> records the processor time stamp
+counter and converts it to time when the time stamp is used. Clocks
+not available on the platform fall back to <code>system</code>.
+See helpers::Clock.
+</p>
+
+<h3>Shutdown timeout</h3>
+
+<p>The time LogManager::shutdown lets asynchronous appenders write their
+buffered events before closing them can be limited with:
+
+<pre>
+log4j.shutdownTimeout=milliseconds
+</pre>
+
+<p>Events still buffered afterwards are discarded.  By default shutdown
+waits until all events are written.
+</p>
+
 
 <h3>Appender configuration</h3>
 
@@ -323,6 +354,18 @@ configuration information is stored.
       static void configureAndWatch(const File& configFilename,
          long delay);
 
+      /**
+      Like {@link #configureAndWatch(const File& configFilename, long delay)}
+      except that the watchdog thread is started with the given
+      name, processor affinity and priority.
+
+      @param configFilename A file in key=value format.
+      @param delay The delay in milliseconds to wait between each check.
+      @param settings settings of the watchdog thread.
+      */
+      static void configureAndWatch(const File& configFilename,
+         long delay, const helpers::ThreadSettings& settings);
+
       /**
       Read configuration options from <code>properties</code>.
       See #doConfigure(const File&, log4cxx::spi::LoggerRepositoryPtr&)
@@ -386,6 +429,8 @@ private:
       PropertyConfigurator(const PropertyConfigurator&);
       PropertyConfigurator& operator=(const PropertyConfigurator&);
 	  static PropertyWatchdog *pdog;
+      static void startWatchdog(const File& configFilename,
+         long delay, const helpers::ThreadSettings* settings);
    }; // class PropertyConfigurator
 }  // namespace log4cxx
 
@@ -94,6 +94,18 @@ namespace log4cxx {
         */
         virtual void subAppend(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
 
+        /**
+         Rolls the file over, if the triggering policy asks for it,
+         before an event is written.
+        */
+        virtual void beforeWrite(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
+
+        /**
+         Formats a batch of events, checking the triggering policy before
+         each event against the file length plus the text not yet written.
+        */
+        virtual void subAppendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p);
+
         protected:
 
           RollingPolicyPtr getRollingPolicy() const;
@@ -68,6 +68,8 @@ namespace log4cxx
                 */
                 bool ignoresThrowable() const { return true; }
 
+                bool requiresMDC() const { return false; }
+
                 virtual void activateOptions(log4cxx::helpers::Pool& /* p */) {}
                 virtual void setOption(const LogString& /* option */,
                      const LogString& /* value */) {}
@@ -126,6 +126,14 @@ namespace log4cxx
             @param event The LoggingEvent to decide upon.
             @return The decision of the filter.  */
             virtual FilterDecision decide(const LoggingEventPtr& event) const = 0;
+
+            /**
+            Returns <code>true</code> if #decide reads the mapped diagnostic
+            context of events, which then has to be copied before an event
+            is filtered on another thread.  The base class returns
+            <code>true</code>.
+            */
+            virtual bool requiresMDC() const;
                 };
         }
 }
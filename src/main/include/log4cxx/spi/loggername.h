@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_SPI_LOGGER_NAME_H
+#define _LOG4CXX_SPI_LOGGER_NAME_H
+
+#if defined(_MSC_VER)
+#pragma warning ( push )
+#pragma warning ( disable: 4231 4251 4275 4786 )
+#endif
+
+#include <log4cxx/logstring.h>
+#include <log4cxx/helpers/objectimpl.h>
+#include <log4cxx/helpers/objectptr.h>
+#include <string>
+
+namespace log4cxx
+{
+        namespace pattern
+        {
+                class NameAbbreviator;
+                typedef helpers::ObjectPtrT<NameAbbreviator> NameAbbreviatorPtr;
+        }
+
+        namespace spi
+        {
+                /**
+                 *  Immutable name of a logger, shared by the logger and
+                 *  its logging events instead of copying the name into
+                 *  every event.  The UTF-8 encoding used by serialization
+                 *  is computed once, abbreviations once per abbreviator.
+                 */
+                class LOG4CXX_EXPORT LoggerName : public virtual helpers::ObjectImpl
+                {
+                public:
+                        DECLARE_ABSTRACT_LOG4CXX_OBJECT(LoggerName)
+                        BEGIN_LOG4CXX_CAST_MAP()
+                                LOG4CXX_CAST_ENTRY(LoggerName)
+                        END_LOG4CXX_CAST_MAP()
+
+                        explicit LoggerName(const LogString& name);
+                        ~LoggerName();
+
+                        inline const LogString& getName() const {
+                                return name;
+                        }
+
+                        /**
+                         *  Gets the name encoded in UTF-8.
+                         *  @return encoded name.
+                         */
+                        inline const std::string& getUTF8() const {
+                                return utf8;
+                        }
+
+                        /**
+                         *  Gets the hash of the name, see StringHelper::hashCode.
+                         *  @return hash code.
+                         */
+                        inline unsigned int getHashCode() const {
+                                return hashCode;
+                        }
+
+                        /**
+                         *  Gets the name as abbreviated by an abbreviator,
+                         *  computed on first request and kept with the name.
+                         *  @param abbreviator abbreviator.
+                         *  @return abbreviated name.
+                         */
+                        const LogString& getAbbreviation(
+                                const pattern::NameAbbreviatorPtr& abbreviator) const;
+
+                private:
+                        struct Abbreviation;
+                        const LogString name;
+                        std::string utf8;
+                        const unsigned int hashCode;
+                        mutable Abbreviation* volatile abbreviations;
+
+                        LoggerName(const LoggerName&);
+                        LoggerName& operator=(const LoggerName&);
+                };
+
+                LOG4CXX_PTR_DEF(LoggerName);
+        }
+}
+
+#if defined(_MSC_VER)
+#pragma warning ( pop )
+#endif
+
+#endif //_LOG4CXX_SPI_LOGGER_NAME_H
@@ -31,6 +31,9 @@
 #include <log4cxx/logger.h>
 #include <log4cxx/mdc.h>
 #include <log4cxx/spi/location/locationinfo.h>
+#include <log4cxx/helpers/clock.h>
+#include <log4cxx/spi/loggername.h>
+#include <log4cxx/spi/mdcsnapshot.h>
 #include <vector>
 
 
@@ -39,6 +42,7 @@ namespace log4cxx
         namespace helpers
         {
                 class ObjectOutputStream;
+                class DeferredMessage;
         }
 
         namespace spi
@@ -83,24 +87,131 @@ namespace log4cxx
                                 const LevelPtr& level,   const LogString& message,
                                 const log4cxx::spi::LocationInfo& location);
 
+                        /**
+                        Instantiate a LoggingEvent whose message is formatted
+                        the first time it is requested, possibly on another thread.
+
+                        @param logger The logger of this event.
+                        @param level The level of this event.
+                        @param message  The message of this event, copied.
+                        @param location location of logging request.
+                        */
+                        LoggingEvent(const LogString& logger,
+                                const LevelPtr& level,
+                                const helpers::DeferredMessage& message,
+                                const log4cxx::spi::LocationInfo& location);
+
+                        /**
+                        Instantiate a LoggingEvent sharing the name of its logger.
+
+                        @param logger The name of the logger of this event.
+                        @param level The level of this event.
+                        @param message  The message of this event.
+                        @param location location of logging request.
+                        */
+                        LoggingEvent(const LoggerNamePtr& logger,
+                                const LevelPtr& level,   const LogString& message,
+                                const log4cxx::spi::LocationInfo& location);
+
+                        /**
+                        Instantiate a LoggingEvent with every field supplied, used
+                        to restore an event that was written to storage.
+
+                        @param logger The name of the logger of this event.
+                        @param level The level of this event.
+                        @param timeStamp microseconds since 01.01.1970.
+                        @param message  The message of this event.
+                        @param threadName name of the thread that logged the event.
+                        @param ndc nested diagnostic context, may be null.
+                        @param mdc copy of the mapped diagnostic context.
+                        @param location location of logging request.
+                        */
+                        LoggingEvent(const LoggerNamePtr& logger,
+                                const LevelPtr& level,
+                                log4cxx_time_t timeStamp,
+                                const LogString& message,
+                                const LogString& threadName,
+                                const LogString* ndc,
+                                const MDC::Map& mdc,
+                                const log4cxx::spi::LocationInfo& location);
+
                         ~LoggingEvent();
 
+                        /**
+                        Obtains a LoggingEvent from the supplied parameters.  The
+                        event is taken from the events released on this thread when
+                        available and is recycled instead of deleted when its last
+                        reference is released.
+
+                        @param logger The logger of this event.
+                        @param level The level of this event.
+                        @param message  The message of this event.
+                        @param location location of logging request.
+                        @return new or recycled event.
+                        */
+                        static LoggingEventPtr create(const LogString& logger,
+                                const LevelPtr& level,   const LogString& message,
+                                const log4cxx::spi::LocationInfo& location);
+
+                        /**
+                        Obtains a LoggingEvent whose message is formatted
+                        the first time it is requested, see create above.
+
+                        @param logger The logger of this event.
+                        @param level The level of this event.
+                        @param message  The message of this event, copied.
+                        @param location location of logging request.
+                        @return new or recycled event.
+                        */
+                        static LoggingEventPtr create(const LogString& logger,
+                                const LevelPtr& level,
+                                const helpers::DeferredMessage& message,
+                                const log4cxx::spi::LocationInfo& location);
+
+                        /**
+                        Obtains a LoggingEvent sharing the name of its logger,
+                        see create above.
+                        */
+                        static LoggingEventPtr create(const LoggerNamePtr& logger,
+                                const LevelPtr& level,   const LogString& message,
+                                const log4cxx::spi::LocationInfo& location);
+
+                        /**
+                        Obtains a LoggingEvent sharing the name of its logger
+                        whose message is formatted when first requested.
+                        */
+                        static LoggingEventPtr create(const LoggerNamePtr& logger,
+                                const LevelPtr& level,
+                                const helpers::DeferredMessage& message,
+                                const log4cxx::spi::LocationInfo& location);
+
+                        void releaseRef() const;
+
                         /** Return the level of this event. */
                         inline const LevelPtr& getLevel() const
                                 { return level; }
 
                         /**  Return the name of the logger. */
                         inline const LogString& getLoggerName() const {
+                               return logger->getName();
+                        }
+
+                        /**  Return the shared name of the logger. */
+                        inline const LoggerNamePtr& getLoggerNamePtr() const {
                                return logger;
                         }
 
                         /** Return the message for this logging event. */
-                        inline const LogString& getMessage() const
-                                { return message; }
+                        inline const LogString& getMessage() const {
+                                if (deferred != 0) {
+                                    renderMessage();
+                                }
+                                return message;
+                        }
 
                         /** Return the message for this logging event. */
                         inline const LogString& getRenderedMessage() const
-                                { return message; }
+                                { return getMessage(); }
 
                         /**Returns the time when the application started,
                         in microseconds elapsed since 01.01.1970.
@@ -115,7 +226,7 @@ namespace log4cxx
                         /** The number of microseconds elapsed from 01.01.1970 until logging event
                          was created. */
                         inline log4cxx_time_t getTimeStamp() const
-                                { return timeStamp; }
+                                { return timeStampInCycles == 0 ? timeStamp : convertTimeStamp(); }
 
                         /* Return the file where this log statement was written. */
                         inline const log4cxx::spi::LocationInfo& getLocationInformation() const
@@ -167,7 +278,8 @@ namespace log4cxx
 
                         /**
                         Obtain a copy of this thread's MDC prior to serialization
-                        or asynchronous logging.
+                        or asynchronous logging.  The copy is the snapshot shared
+                        by the events of the thread until its MDC changes.
                         */
                         void getMDCCopy() const;
 
@@ -195,7 +307,7 @@ namespace log4cxx
                         /**
                         * The logger of the logging event.
                         **/
-                        LogString logger;
+                        LoggerNamePtr logger;
 
                         /** level of logging event. */
                         LevelPtr level;
@@ -203,8 +315,8 @@ namespace log4cxx
                         /** The nested diagnostic context (NDC) of logging event. */
                         mutable LogString* ndc;
 
-                        /** The mapped diagnostic context (MDC) of logging event. */
-                        mutable MDC::Map* mdcCopy;
+                        /** The mapped diagnostic context (MDC) of logging event, null if empty. */
+                        mutable MDCSnapshotPtr mdcCopy;
 
                         /**
                         * A map of String keys and String values.
@@ -226,21 +338,44 @@ namespace log4cxx
                         mutable bool mdcCopyLookupRequired;
 
                         /** The application supplied message of logging event. */
-                        LogString message;
+                        mutable LogString message;
+
+                        /**
+                        * Storage of the deferred message, kept for reuse.
+                        */
+                        helpers::DeferredMessage* deferredStorage;
+
+                        /**
+                        * Message still to be formatted into message, either
+                        * deferredStorage or null once formatted.
+                        */
+                        mutable helpers::DeferredMessage* volatile deferred;
+
+                        /**
+                        * Set while a thread formats deferred.
+                        */
+                        mutable volatile log4cxx_uint32_t rendering;
 
 
                         /** The number of microseconds elapsed from 01.01.1970 until logging event
-                         was created. */
-                        log4cxx_time_t timeStamp;
+                         was created, or the clock cycles if timeStampInCycles. */
+                        mutable volatile log4cxx_time_t timeStamp;
+
+                        /** Non zero while timeStamp is in clock cycles, converted
+                         once by the first call of getTimeStamp. */
+                        mutable volatile log4cxx_uint32_t timeStampInCycles;
 
                         /** The is the location where this log statement was written. */
-                        const log4cxx::spi::LocationInfo locationInfo;
+                        log4cxx::spi::LocationInfo locationInfo;
 
 
                         /** The identifier of thread in which this logging event
                         was generated.
                         */
-                       const LogString threadName;
+                       LogString threadName;
+
+                       /** True if recycled rather than deleted, see create. */
+                       bool pooled;
 
                        //
                        //   prevent copy and assignment
@@ -248,6 +383,13 @@ namespace log4cxx
                        LoggingEvent(const LoggingEvent&);
                        LoggingEvent& operator=(const LoggingEvent&);
                        static const LogString getCurrentThreadName();
+                       void renderMessage() const;
+                       void readClock();
+                       log4cxx_time_t convertTimeStamp() const;
+                       static LoggingEvent* acquire(const LoggerNamePtr& logger,
+                                const LevelPtr& level,
+                                const log4cxx::spi::LocationInfo& location);
+                       static void recycle(LoggingEvent* event);
 
                        static void writeProlog(log4cxx::helpers::ObjectOutputStream& os, log4cxx::helpers::Pool& p);
 
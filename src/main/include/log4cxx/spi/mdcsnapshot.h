@@ -0,0 +1,70 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_SPI_MDC_SNAPSHOT_H
+#define _LOG4CXX_SPI_MDC_SNAPSHOT_H
+
+#if defined(_MSC_VER)
+#pragma warning ( push )
+#pragma warning ( disable: 4231 4251 4275 4786 )
+#endif
+
+#include <log4cxx/mdc.h>
+#include <log4cxx/helpers/objectimpl.h>
+#include <log4cxx/helpers/objectptr.h>
+
+namespace log4cxx
+{
+        namespace spi
+        {
+                /**
+                 *  Immutable copy of the mapped diagnostic context of a
+                 *  thread.  The thread keeps its snapshot until MDC::put,
+                 *  MDC::remove or MDC::clear changes the context, so the
+                 *  logging events created in between share one copy.
+                 */
+                class LOG4CXX_EXPORT MDCSnapshot : public virtual helpers::ObjectImpl
+                {
+                public:
+                        DECLARE_ABSTRACT_LOG4CXX_OBJECT(MDCSnapshot)
+                        BEGIN_LOG4CXX_CAST_MAP()
+                                LOG4CXX_CAST_ENTRY(MDCSnapshot)
+                        END_LOG4CXX_CAST_MAP()
+
+                        explicit MDCSnapshot(const MDC::Map& map);
+                        ~MDCSnapshot();
+
+                        inline const MDC::Map& getMap() const {
+                                return map;
+                        }
+
+                private:
+                        const MDC::Map map;
+
+                        MDCSnapshot(const MDCSnapshot&);
+                        MDCSnapshot& operator=(const MDCSnapshot&);
+                };
+
+                LOG4CXX_PTR_DEF(MDCSnapshot);
+        }
+}
+
+#if defined(_MSC_VER)
+#pragma warning ( pop )
+#endif
+
+#endif //_LOG4CXX_SPI_MDC_SNAPSHOT_H
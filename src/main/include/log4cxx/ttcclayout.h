@@ -175,6 +175,8 @@ namespace log4cxx
         <code>true</code>.
         */
         virtual bool ignoresThrowable() const { return true; }
+
+        virtual bool requiresMDC() const { return false; }
         };
       LOG4CXX_PTR_DEF(TTCCLayout);
 }
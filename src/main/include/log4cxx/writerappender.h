@@ -54,6 +54,14 @@ namespace log4cxx
                 */
                 bool immediateFlush;
 
+                /**
+                If set, doAppend only holds the appender lock to check the
+                event and to write it, the layout formats it without the
+                lock so that threads logging to the same appender format
+                concurrently.  Set to <code>false</code> by default.
+                */
+                bool formatOutsideLock;
+
                 /**
                 The encoding to use when opening an input stream.
                 <p>The <code>encoding</code> variable is set to <code>""</code> by
@@ -111,6 +119,28 @@ namespace log4cxx
                 */
                 bool getImmediateFlush() const { return immediateFlush; }
 
+                /**
+                If the <b>FormatOutsideLock</b> option is set to
+                <code>true</code>, events are formatted by the calling thread
+                before the appender lock is taken for the write, instead of
+                while holding it.  The layout is then called by several
+                threads at once, which the layouts of log4cxx support.
+                Subclasses overriding append or subAppend are bypassed on
+                this path; they see the write through beforeWrite.
+                */
+                void setFormatOutsideLock(bool value);
+                /**
+                Returns value of the <b>FormatOutsideLock</b> option.
+                */
+                bool getFormatOutsideLock() const { return formatOutsideLock; }
+
+                /**
+                Formats the event outside the appender lock when the
+                <b>FormatOutsideLock</b> option is set, otherwise
+                behaves as AppenderSkeleton#doAppend.
+                */
+                virtual void doAppend(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
+
                 /**
                 This method is called by the AppenderSkeleton#doAppend
                 method.
@@ -135,6 +165,12 @@ namespace log4cxx
                 value <code>false</code> is returned. */
                 virtual bool checkEntryConditions() const;
 
+                /**
+                Checks the entry conditions once and writes all events with
+                WriterAppender#subAppendBatch.
+                */
+                virtual void appendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p);
+
 
         public:
                 /**
@@ -191,6 +227,36 @@ namespace log4cxx
                */
                virtual void subAppend(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
 
+               /**
+                Formats all events into one buffer that is written, and
+                flushed if immediateFlush is set, once.
+               */
+               virtual void subAppendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p);
+
+               /**
+                Writes already formatted text to the writer and flushes it
+                if immediateFlush is set.
+               */
+               void writeFormatted(const LogString& msg, log4cxx::helpers::Pool& p);
+
+               /**
+                Writes text already formatted and encoded in UTF-8 by
+                Layout#formatUTF8 and flushes it if immediateFlush is set.
+               */
+               void writeFormattedUTF8(const std::string& msg, log4cxx::helpers::Pool& p);
+
+               /**
+                Determines whether the writer encodes in UTF-8.
+                @return false if there is no writer or it uses another encoding.
+               */
+               bool isWriterUTF8() const;
+
+               /**
+                Called with the lock held before an event formatted outside
+                the lock is written.  The base class does nothing.
+               */
+               virtual void beforeWrite(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
+
 
                 /**
                 Write a footer as produced by the embedded layout's
@@ -46,6 +46,10 @@ extern "C" {
 
 namespace log4cxx
 {
+        namespace helpers
+        {
+                class ThreadSettings;
+        }
 
         namespace xml
         {
@@ -277,6 +281,30 @@ namespace log4cxx
                                 long delay);
 #endif
 
+                        /**
+                        Like #configureAndWatch(const std::string& configFilename, long delay)
+                        except that the watchdog thread is started with the given
+                        name, processor affinity and priority.
+
+                        @param configFilename A log4j configuration file in XML format.
+                        @param delay The delay in milliseconds to wait between each check.
+                        @param settings settings of the watchdog thread.
+                        */
+                        static void configureAndWatch(const std::string& configFilename,
+                                long delay, const helpers::ThreadSettings& settings);
+#if LOG4CXX_WCHAR_T_API
+                        static void configureAndWatch(const std::wstring& configFilename,
+                                long delay, const helpers::ThreadSettings& settings);
+#endif
+#if LOG4CXX_UNICHAR_API
+                        static void configureAndWatch(const std::basic_string<UniChar>& configFilename,
+                                long delay, const helpers::ThreadSettings& settings);
+#endif
+#if LOG4CXX_CFSTRING_API
+                        static void configureAndWatch(const CFStringRef& configFilename,
+                                long delay, const helpers::ThreadSettings& settings);
+#endif
+
                         /**
                         Interpret the XML file pointed by <code>filename</code> and set up
                         log4cxx accordingly.
@@ -305,6 +333,8 @@ namespace log4cxx
                         DOMConfigurator(const DOMConfigurator&);
                         DOMConfigurator& operator=(const DOMConfigurator&);
 						static XMLWatchdog *xdog;
+                        static void startWatchdog(const File& file,
+                                long delay, const helpers::ThreadSettings* settings);
                 };
             LOG4CXX_PTR_DEF(DOMConfigurator);
         }  // namespace xml
@@ -130,6 +130,12 @@ namespace log4cxx
                         virtual bool ignoresThrowable() const
                                 { return false; }
 
+                        /**
+                        The MDC is only formatted with the <b>Properties</b> option.
+                        */
+                        virtual bool requiresMDC() const
+                                { return properties; }
+
                 };  // class XMLLayout
             LOG4CXX_PTR_DEF(XMLLayout);
         }  // namespace xml
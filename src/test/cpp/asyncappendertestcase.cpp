@@ -20,6 +20,7 @@
 #include <log4cxx/logger.h>
 #include <log4cxx/logmanager.h>
 #include <log4cxx/simplelayout.h>
+#include <log4cxx/patternlayout.h>
 #include "vectorappender.h"
 #include <log4cxx/asyncappender.h>
 #include "appenderskeletontestcase.h"
@@ -31,6 +32,8 @@
 #include <log4cxx/spi/location/locationinfo.h>
 #include <log4cxx/xml/domconfigurator.h>
 #include <log4cxx/file.h>
+#include <log4cxx/mdc.h>
+#include <map>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
@@ -96,6 +99,18 @@ public:
 
 typedef helpers::ObjectPtrT<BlockableVectorAppender> BlockableVectorAppenderPtr;
 
+    /**
+     * Vector appender that declares to use its layout.
+     */
+class LayoutVectorAppender : public VectorAppender {
+public:
+    bool requiresLayout() const {
+            return true;
+    }
+};
+
+typedef helpers::ObjectPtrT<LayoutVectorAppender> LayoutVectorAppenderPtr;
+
 #if APR_HAS_THREADS
 /**
  * Tests of AsyncAppender.
@@ -117,8 +132,86 @@ class AsyncAppenderTestCase : public AppenderSkeletonTestCase
                 //LOGUNIT_TEST(testBadAppender);
                 LOGUNIT_TEST(testLocationInfoTrue);
                 LOGUNIT_TEST(testConfiguration);
+                LOGUNIT_TEST(testConcurrentProducers);
+                LOGUNIT_TEST(testSetBufferSizeWhileLogging);
+                LOGUNIT_TEST(testDropOldest);
+                LOGUNIT_TEST(testDiscardBelowThreshold);
+                LOGUNIT_TEST(testSpool);
+                LOGUNIT_TEST(testDispatcherCount);
+                LOGUNIT_TEST(testWaitStrategies);
+                LOGUNIT_TEST(testStaging);
+                LOGUNIT_TEST(testStagingLevel);
+                LOGUNIT_TEST(testMetrics);
+                LOGUNIT_TEST(testFlush);
+                LOGUNIT_TEST(testCloseWithTimeout);
+                LOGUNIT_TEST(testMDCCapture);
         LOGUNIT_TEST_SUITE_END();
 
+        enum { PRODUCERS = 8, EVENTS_PER_PRODUCER = 1000 };
+
+        static void* LOG4CXX_THREAD_FUNC produce(apr_thread_t* /* thread */, void* data) {
+                LoggerPtr logger(Logger::getLogger((const char*) data));
+                for (int i = 0; i < EVENTS_PER_PRODUCER; i++) {
+                        LOG4CXX_INFO(logger, i);
+                }
+                return 0;
+        }
+
+        /**
+         * Logs from PRODUCERS threads through the appender with a small
+         * buffer, closes it and checks that all events were dispatched,
+         * in order for each producer.
+         * @param async appender, configured with the options under test.
+         * @param prefix prefix of the producer logger names.
+         */
+        void runProducersAndCheckOrder(const AsyncAppenderPtr& async, const char* prefix) {
+                VectorAppenderPtr vectorAppender = new VectorAppender();
+                async->addAppender(vectorAppender);
+                async->setBufferSize(16);
+                LoggerPtr root = Logger::getRootLogger();
+                root->removeAllAppenders();
+                root->addAppender(async);
+
+                std::string names[PRODUCERS];
+                Thread threads[PRODUCERS];
+                for (int i = 0; i < PRODUCERS; i++) {
+                        names[i] = prefix;
+                        names[i].append(1, (char) ('0' + i));
+                        threads[i].run(produce, (void*) names[i].c_str());
+                }
+                for (int i = 0; i < PRODUCERS; i++) {
+                        threads[i].join();
+                }
+                async->close();
+
+                const std::vector<spi::LoggingEventPtr>& v = vectorAppender->getVector();
+                LOGUNIT_ASSERT_EQUAL((size_t) PRODUCERS * EVENTS_PER_PRODUCER, v.size());
+                std::map<LogString, int> next;
+                for (std::vector<spi::LoggingEventPtr>::const_iterator iter = v.begin();
+                     iter != v.end();
+                     iter++) {
+                        Pool p;
+                        LogString expected;
+                        StringHelper::toString(next[(*iter)->getLoggerName()]++, p, expected);
+                        LOGUNIT_ASSERT_EQUAL(expected, (*iter)->getMessage());
+                }
+        }
+
+        static void* LOG4CXX_THREAD_FUNC holdBlocker(apr_thread_t* /* thread */, void* data) {
+                BlockableVectorAppender* appender = (BlockableVectorAppender*) data;
+                synchronized sync(appender->getBlocker());
+                Thread::sleep(200);
+                return 0;
+        }
+
+        static void* LOG4CXX_THREAD_FUNC produceWarnings(apr_thread_t* /* thread */, void* /* data */) {
+                LoggerPtr root(Logger::getRootLogger());
+                for (int i = 0; i < 10; i++) {
+                        LOG4CXX_WARN(root, i);
+                }
+                return 0;
+        }
+
 
 public:
         void setUp() {
@@ -282,6 +375,339 @@ public:
         }
 
         
+        /**
+         * Events from concurrent producers through a small buffer are
+         * all dispatched, in order for each producer.
+         */
+        void testConcurrentProducers() {
+                AsyncAppenderPtr async = new AsyncAppender();
+                runProducersAndCheckOrder(async, "p");
+        }
+
+        /**
+         * Events sharded over several dispatchers are all dispatched,
+         * in order for each logger.
+         */
+        void testDispatcherCount() {
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->setOption(LOG4CXX_STR("DispatcherCount"), LOG4CXX_STR("4"));
+                LOGUNIT_ASSERT_EQUAL(4, async->getDispatcherCount());
+                async->setOption(LOG4CXX_STR("ShardBy"), LOG4CXX_STR("Thread"));
+                LOGUNIT_ASSERT_EQUAL(true, async->getShardByThread());
+                async->setOption(LOG4CXX_STR("ShardBy"), LOG4CXX_STR("Logger"));
+                LOGUNIT_ASSERT_EQUAL(false, async->getShardByThread());
+                runProducersAndCheckOrder(async, "s");
+        }
+
+        /**
+         * Events from concurrent producers are all dispatched in order
+         * with the spinning wait strategies.
+         */
+        void testWaitStrategies() {
+                const AsyncAppender::WaitStrategy strategies[] = {
+                    AsyncAppender::SPIN_THEN_PARK, AsyncAppender::BUSY_SPIN };
+                const logchar* options[] = { LOG4CXX_STR("SpinThenPark"), LOG4CXX_STR("BusySpin") };
+                for (int s = 0; s < 2; s++) {
+                        AsyncAppenderPtr async = new AsyncAppender();
+                        async->setOption(LOG4CXX_STR("WaitStrategy"), options[s]);
+                        LOGUNIT_ASSERT_EQUAL(strategies[s], async->getWaitStrategy());
+                        runProducersAndCheckOrder(async, "w");
+                }
+        }
+
+        /**
+         * Events staged by producer threads are all dispatched, in order
+         * for each producer, including those left staged when a thread exits.
+         */
+        void testStaging() {
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->setOption(LOG4CXX_STR("StagingSize"), LOG4CXX_STR("7"));
+                LOGUNIT_ASSERT_EQUAL(7, async->getStagingSize());
+                runProducersAndCheckOrder(async, "t");
+        }
+
+        /**
+         * An event at the staging level hands the staged events over
+         * without waiting for the staging delay.
+         */
+        void testStagingLevel() {
+                BlockableVectorAppenderPtr blockableAppender = new BlockableVectorAppender();
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->addAppender(blockableAppender);
+                async->setStagingSize(100);
+                async->setOption(LOG4CXX_STR("StagingDelay"), LOG4CXX_STR("60000"));
+                async->setOption(LOG4CXX_STR("StagingLevel"), LOG4CXX_STR("WARN"));
+                LOGUNIT_ASSERT_EQUAL(Level::getWarn(), async->getStagingLevel());
+                LoggerPtr root = Logger::getRootLogger();
+                root->addAppender(async);
+                for (int i = 0; i < 3; i++) {
+                    LOG4CXX_DEBUG(root, i);
+                }
+                LOG4CXX_WARN(root, 3);
+                size_t count = 0;
+                for (int i = 0; i < 500 && count < 4; i++) {
+                    Thread::sleep(10);
+                    synchronized sync(blockableAppender->getBlocker());
+                    count = blockableAppender->getVector().size();
+                }
+                LOGUNIT_ASSERT_EQUAL((size_t) 4, count);
+                async->close();
+                const std::vector<spi::LoggingEventPtr>& events = blockableAppender->getVector();
+                LOGUNIT_ASSERT_EQUAL((size_t) 4, events.size());
+                LOGUNIT_ASSERT_EQUAL(Level::getWarn(), events[3]->getLevel());
+        }
+
+        /**
+         * Events added to a buffer replaced by setBufferSize are still dispatched.
+         */
+        void testSetBufferSizeWhileLogging() {
+                VectorAppenderPtr vectorAppender = new VectorAppender();
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->addAppender(vectorAppender);
+                LoggerPtr root = Logger::getRootLogger();
+                root->addAppender(async);
+
+                Thread producer;
+                producer.run(produce, (void*) "resized");
+                async->setBufferSize(4);
+                async->setBufferSize(512);
+                producer.join();
+                async->close();
+
+                LOGUNIT_ASSERT_EQUAL((size_t) EVENTS_PER_PRODUCER, vectorAppender->getVector().size());
+        }
+
+        /**
+         * Tests that DropOldest keeps the newest events without blocking.
+         */
+        void testDropOldest() {
+                BlockableVectorAppenderPtr blockableAppender = new BlockableVectorAppender();
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->addAppender(blockableAppender);
+                async->setBufferSize(4);
+                async->setOption(LOG4CXX_STR("OverflowPolicy"), LOG4CXX_STR("DropOldest"));
+                LOGUNIT_ASSERT_EQUAL(AsyncAppender::DROP_OLDEST, async->getOverflowPolicy());
+                LoggerPtr root = Logger::getRootLogger();
+                root->addAppender(async);
+                {
+                    synchronized sync(blockableAppender->getBlocker());
+                    for (int i = 0; i < 100; i++) {
+                        LOG4CXX_DEBUG(root, i);
+                    }
+                }
+                async->close();
+                const std::vector<spi::LoggingEventPtr>& events = blockableAppender->getVector();
+                LOGUNIT_ASSERT(events.size() < 100);
+                LoggingEventPtr discardEvent = events[events.size() - 1];
+                LOGUNIT_ASSERT(discardEvent->getMessage().substr(0,10) == LOG4CXX_STR("Discarded "));
+                LOGUNIT_ASSERT(events[events.size() - 2]->getMessage() == LOG4CXX_STR("99"));
+        }
+
+        /**
+         * Tests that only events below the discard threshold are discarded.
+         */
+        void testDiscardBelowThreshold() {
+                BlockableVectorAppenderPtr blockableAppender = new BlockableVectorAppender();
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->addAppender(blockableAppender);
+                async->setBufferSize(4);
+                async->setOverflowPolicy(AsyncAppender::DISCARD_BELOW_THRESHOLD);
+                async->setOption(LOG4CXX_STR("DiscardThreshold"), LOG4CXX_STR("WARN"));
+                LOGUNIT_ASSERT_EQUAL(Level::getWarn(), async->getDiscardThreshold());
+                LoggerPtr root = Logger::getRootLogger();
+                root->addAppender(async);
+                Thread producer;
+                {
+                    synchronized sync(blockableAppender->getBlocker());
+                    for (int i = 0; i < 100; i++) {
+                        LOG4CXX_DEBUG(root, i);
+                    }
+                    //  warnings wait until the appender is released
+                    producer.run(produceWarnings, 0);
+                    Thread::sleep(50);
+                }
+                producer.join();
+                async->close();
+                const std::vector<spi::LoggingEventPtr>& events = blockableAppender->getVector();
+                int warnings = 0;
+                bool discarded = false;
+                for (std::vector<spi::LoggingEventPtr>::const_iterator iter = events.begin();
+                     iter != events.end();
+                     iter++) {
+                    if ((*iter)->getMessage().substr(0,10) == LOG4CXX_STR("Discarded ")) {
+                        LOGUNIT_ASSERT_EQUAL(Level::getDebug(), (*iter)->getLevel());
+                        discarded = true;
+                    } else if ((*iter)->getLevel() == Level::getWarn()) {
+                        warnings++;
+                    }
+                }
+                LOGUNIT_ASSERT_EQUAL(10, warnings);
+                LOGUNIT_ASSERT(discarded);
+        }
+
+        /**
+         * Tests that discards, waits and dispatched events show in the metrics.
+         */
+        void testMetrics() {
+                BlockableVectorAppenderPtr blockableAppender = new BlockableVectorAppender();
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->addAppender(blockableAppender);
+                async->setBufferSize(4);
+                async->setOverflowPolicy(AsyncAppender::DISCARD_BELOW_THRESHOLD);
+                async->setOption(LOG4CXX_STR("MetricsInterval"), LOG4CXX_STR("1000"));
+                LOGUNIT_ASSERT_EQUAL(1000, async->getMetricsInterval());
+                LoggerPtr root = Logger::getRootLogger();
+                root->addAppender(async);
+                Thread producer;
+                {
+                    synchronized sync(blockableAppender->getBlocker());
+                    for (int i = 0; i < 100; i++) {
+                        LOG4CXX_DEBUG(root, i);
+                    }
+                    producer.run(produceWarnings, 0);
+                    Thread::sleep(50);
+                }
+                producer.join();
+                async->close();
+
+                LOGUNIT_ASSERT_EQUAL(0, async->getQueueDepth());
+                LOGUNIT_ASSERT(async->getMaxQueueDepth() >= 1);
+                LOGUNIT_ASSERT(async->getMaxQueueDepth() <= 4);
+                LOGUNIT_ASSERT(async->getBlockedTime() > 0);
+                AsyncAppender::DiscardCountMap discards(async->getDiscardCounts());
+                LOGUNIT_ASSERT_EQUAL((size_t) 1, discards.size());
+                LOGUNIT_ASSERT(discards[root->getName()] > 0);
+
+                std::vector<unsigned int> histogram(async->getLatencyHistogram());
+                LOGUNIT_ASSERT_EQUAL((size_t) AsyncAppender::LATENCY_BUCKETS, histogram.size());
+                size_t dispatched = 0;
+                for (std::vector<unsigned int>::const_iterator iter = histogram.begin();
+                     iter != histogram.end();
+                     iter++) {
+                    dispatched += *iter;
+                }
+                LOGUNIT_ASSERT_EQUAL(blockableAppender->getVector().size(), dispatched);
+
+                async->resetMetrics();
+                LOGUNIT_ASSERT_EQUAL(0, async->getMaxQueueDepth());
+                LOGUNIT_ASSERT(async->getDiscardCounts().empty());
+        }
+
+        /**
+         * Tests that flush waits for buffered and staged events.
+         */
+        void testFlush() {
+                BlockableVectorAppenderPtr blockableAppender = new BlockableVectorAppender();
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->addAppender(blockableAppender);
+                async->setStagingSize(50);
+                async->setStagingDelay(60000);
+                LoggerPtr root = Logger::getRootLogger();
+                root->addAppender(async);
+                for (int i = 0; i < 10; i++) {
+                    LOG4CXX_DEBUG(root, i);
+                }
+                LOGUNIT_ASSERT(async->flush(5000));
+                {
+                    synchronized sync(blockableAppender->getBlocker());
+                    LOGUNIT_ASSERT_EQUAL((size_t) 10, blockableAppender->getVector().size());
+                    LOG4CXX_DEBUG(root, 10);
+                    LOGUNIT_ASSERT(!async->flush(50));
+                }
+                LOGUNIT_ASSERT(async->flush(5000));
+                async->close();
+                LOGUNIT_ASSERT_EQUAL((size_t) 11, blockableAppender->getVector().size());
+        }
+
+        /**
+         * Tests that close with a timeout discards the events it could not append.
+         */
+        void testCloseWithTimeout() {
+                BlockableVectorAppenderPtr blockableAppender = new BlockableVectorAppender();
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->addAppender(blockableAppender);
+                LoggerPtr root = Logger::getRootLogger();
+                root->addAppender(async);
+                Thread holder;
+                holder.run(holdBlocker, (BlockableVectorAppender*) blockableAppender);
+                Thread::sleep(20);
+                //  the dispatcher waits for the blocker while appending the first event
+                LOG4CXX_DEBUG(root, 0);
+                Thread::sleep(20);
+                for (int i = 1; i < 10; i++) {
+                    LOG4CXX_DEBUG(root, i);
+                }
+                LOGUNIT_ASSERT(!async->close(50));
+                holder.join();
+                LOGUNIT_ASSERT_EQUAL((size_t) 1, blockableAppender->getVector().size());
+        }
+
+        /**
+         * Tests that the MDC is only captured if an attached appender uses it,
+         * including when its layout is set after it was attached.
+         */
+        void testMDCCapture() {
+                LayoutVectorAppenderPtr vectorAppender = new LayoutVectorAppender();
+                vectorAppender->setLayout(new SimpleLayout());
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->addAppender(vectorAppender);
+                LOGUNIT_ASSERT_EQUAL(false, async->requiresMDC());
+                LoggerPtr root = Logger::getRootLogger();
+                root->addAppender(async);
+                MDC::put(LOG4CXX_TEST_STR("capture"), LOG4CXX_TEST_STR("value"));
+                LOG4CXX_DEBUG(root, "not captured");
+                LOGUNIT_ASSERT(async->flush(5000));
+
+                //  a layout set after the appender is attached is noticed
+                vectorAppender->setLayout(new PatternLayout(LOG4CXX_STR("%X{capture}")));
+                LOGUNIT_ASSERT_EQUAL(true, async->requiresMDC());
+                LOG4CXX_DEBUG(root, "captured");
+                MDC::remove(LOG4CXX_TEST_STR("capture"));
+                async->close();
+
+                const std::vector<spi::LoggingEventPtr>& events = vectorAppender->getVector();
+                LOGUNIT_ASSERT_EQUAL((size_t) 2, events.size());
+                LogString value;
+                LOGUNIT_ASSERT_EQUAL(false, events[0]->getMDC(LOG4CXX_STR("capture"), value));
+                LOGUNIT_ASSERT_EQUAL(true, events[1]->getMDC(LOG4CXX_STR("capture"), value));
+                LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("value"), value);
+        }
+
+        /**
+         * Tests that spooled events are dispatched in order with their context.
+         */
+        void testSpool() {
+                BlockableVectorAppenderPtr blockableAppender = new BlockableVectorAppender();
+                AsyncAppenderPtr async = new AsyncAppender();
+                async->addAppender(blockableAppender);
+                async->setBufferSize(4);
+                async->setOverflowPolicy(AsyncAppender::SPOOL);
+                async->setSpoolFile(LOG4CXX_STR("output/asyncappender.spool"));
+                LoggerPtr root = Logger::getRootLogger();
+                root->addAppender(async);
+                MDC::put(LOG4CXX_TEST_STR("spool"), LOG4CXX_TEST_STR("value"));
+                {
+                    synchronized sync(blockableAppender->getBlocker());
+                    for (int i = 0; i < 100; i++) {
+                        LOG4CXX_DEBUG(root, i);
+                    }
+                }
+                MDC::remove(LOG4CXX_TEST_STR("spool"));
+                async->close();
+                const std::vector<spi::LoggingEventPtr>& events = blockableAppender->getVector();
+                LOGUNIT_ASSERT_EQUAL((size_t) 100, events.size());
+                Pool p;
+                for (int i = 0; i < 100; i++) {
+                    LogString expected;
+                    StringHelper::toString(i, p, expected);
+                    LOGUNIT_ASSERT_EQUAL(expected, events[i]->getMessage());
+                    LogString value;
+                    LOGUNIT_ASSERT(events[i]->getMDC(LOG4CXX_STR("spool"), value));
+                    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("value"), value);
+                    LOGUNIT_ASSERT_EQUAL(events[0]->getThreadName(), events[i]->getThreadName());
+                }
+        }
+
 };
 
 LOGUNIT_TEST_SUITE_REGISTRATION(AsyncAppenderTestCase);
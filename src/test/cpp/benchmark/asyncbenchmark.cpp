@@ -0,0 +1,318 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <log4cxx/logger.h>
+#include <log4cxx/asyncappender.h>
+#include <log4cxx/appenderskeleton.h>
+#include <log4cxx/spi/loggingevent.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/mutex.h>
+#include <log4cxx/helpers/condition.h>
+#include <log4cxx/helpers/synchronized.h>
+#include <log4cxx/helpers/pool.h>
+#include <apr_general.h>
+#include <apr_time.h>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+#include <time.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+/**
+ *  Appender that counts the events dispatched to it.
+ */
+class CountingAppender : public AppenderSkeleton {
+public:
+    int count;
+
+    CountingAppender() : count(0) {
+    }
+
+    void append(const LoggingEventPtr&, Pool&) {
+        count++;
+    }
+
+    void close() {
+    }
+
+    bool requiresLayout() const {
+        return false;
+    }
+};
+
+typedef ObjectPtrT<CountingAppender> CountingAppenderPtr;
+
+/**
+ *  The event queue AsyncAppender used before the ring buffer: a vector
+ *  guarded by a mutex, with condition variables signalled on every
+ *  transition between empty, non-empty and full.
+ */
+class MutexQueueAppender : public AppenderSkeleton {
+public:
+    MutexQueueAppender(const AppenderPtr& target1, int bufferSize1)
+        : target(target1), bufferSize(bufferSize1), buffer(),
+          bufferMutex(pool), bufferNotFull(pool), bufferNotEmpty(pool),
+          dispatcher() {
+        dispatcher.run(dispatch, this);
+    }
+
+    void append(const LoggingEventPtr& event, Pool&) {
+        LogString ndcVal;
+        event->getNDC(ndcVal);
+        event->getThreadName();
+        event->getMDCCopy();
+
+        synchronized sync(bufferMutex);
+        while ((int) buffer.size() >= bufferSize) {
+            bufferNotFull.await(bufferMutex);
+        }
+        buffer.push_back(event);
+        if (buffer.size() == 1) {
+            bufferNotEmpty.signalAll();
+        }
+    }
+
+    void close() {
+        {
+            synchronized sync(bufferMutex);
+            closed = true;
+            bufferNotEmpty.signalAll();
+        }
+        dispatcher.join();
+    }
+
+    bool requiresLayout() const {
+        return false;
+    }
+
+private:
+    AppenderPtr target;
+    int bufferSize;
+    LoggingEventList buffer;
+    Mutex bufferMutex;
+    Condition bufferNotFull;
+    Condition bufferNotEmpty;
+    Thread dispatcher;
+
+    static void* LOG4CXX_THREAD_FUNC dispatch(apr_thread_t*, void* data) {
+        MutexQueueAppender* pThis = (MutexQueueAppender*) data;
+        bool isActive = true;
+        while (isActive) {
+            Pool p;
+            LoggingEventList events;
+            {
+                synchronized sync(pThis->bufferMutex);
+                isActive = !pThis->closed;
+                while (pThis->buffer.empty() && isActive) {
+                    pThis->bufferNotEmpty.await(pThis->bufferMutex);
+                    isActive = !pThis->closed;
+                }
+                events.swap(pThis->buffer);
+                pThis->bufferNotFull.signalAll();
+            }
+            for (LoggingEventList::iterator iter = events.begin();
+                 iter != events.end();
+                 iter++) {
+                pThis->target->doAppend(*iter, p);
+            }
+        }
+        return 0;
+    }
+};
+
+namespace {
+    LoggerPtr logger;
+    int eventsPerThread;
+
+    void* LOG4CXX_THREAD_FUNC produce(apr_thread_t* /* thread */, void* /* data */) {
+        LevelPtr info(Level::getInfo());
+        LogString msg(LOG4CXX_STR("Hello, World"));
+        for (int i = 0; i < eventsPerThread; i++) {
+            logger->forcedLogLS(info, msg, LOG4CXX_LOCATION);
+        }
+        return 0;
+    }
+
+    /**
+     *  Processor time used by all threads of the process
+     *  during the last run, in microseconds.
+     */
+    double cpuTime;
+
+    /**
+     *  Logs from threadCount threads through appender and returns
+     *  the elapsed time until every event has been dispatched.
+     */
+    apr_time_t run(const AppenderPtr& appender, int threadCount) {
+        logger->removeAllAppenders();
+        logger->addAppender(appender);
+        std::vector<Thread*> threads;
+        clock_t cpuStart = clock();
+        apr_time_t start = apr_time_now();
+        for (int i = 0; i < threadCount; i++) {
+            threads.push_back(new Thread());
+            threads.back()->run(produce, 0);
+        }
+        for (int i = 0; i < threadCount; i++) {
+            threads[i]->join();
+            delete threads[i];
+        }
+        appender->close();
+        apr_time_t elapsed = apr_time_now() - start;
+        cpuTime = (double) (clock() - cpuStart) * 1000000 / CLOCKS_PER_SEC;
+        logger->removeAllAppenders();
+        return elapsed;
+    }
+
+    void report(const char* label, int threadCount, apr_time_t elapsed, int dispatched) {
+        std::cout << label << ", " << threadCount << " threads: "
+                  << ((double) eventsPerThread * threadCount / elapsed) << " million events/s, "
+                  << (cpuTime / elapsed) << " cores busy, "
+                  << dispatched << " dispatched" << std::endl;
+    }
+
+    /**
+     *  Gets the upper bound in microseconds of the latency
+     *  bucket holding the given fraction of the events.
+     */
+    long percentile(const std::vector<unsigned int>& histogram, double fraction) {
+        double total = 0;
+        for (size_t i = 0; i < histogram.size(); i++) {
+            total += histogram[i];
+        }
+        double sum = 0;
+        for (size_t i = 0; i < histogram.size(); i++) {
+            sum += histogram[i];
+            if (sum >= total * fraction) {
+                return 1L << i;
+            }
+        }
+        return 1L << histogram.size();
+    }
+
+    /**
+     *  Logs from one thread pausing between events, so that the
+     *  dispatcher runs out of events, and reports the dispatch latency
+     *  and the processor time of a wait strategy.
+     */
+    void reportLatency(const char* label, AsyncAppender::WaitStrategy strategy, int bufferSize) {
+        CountingAppenderPtr counter(new CountingAppender());
+        AsyncAppenderPtr async(new AsyncAppender());
+        async->setBufferSize(bufferSize);
+        async->setWaitStrategy(strategy);
+        async->addAppender(counter);
+        logger->removeAllAppenders();
+        logger->addAppender(async);
+        LevelPtr info(Level::getInfo());
+        LogString msg(LOG4CXX_STR("Hello, World"));
+        int count = eventsPerThread / 100;
+        clock_t cpuStart = clock();
+        apr_time_t start = apr_time_now();
+        for (int i = 0; i < count; i++) {
+            logger->forcedLogLS(info, msg, LOG4CXX_LOCATION);
+            apr_sleep(100);
+        }
+        async->close();
+        apr_time_t elapsed = apr_time_now() - start;
+        double cpu = (double) (clock() - cpuStart) * 1000000 / CLOCKS_PER_SEC;
+        logger->removeAllAppenders();
+        std::vector<unsigned int> histogram(async->getLatencyHistogram());
+        std::cout << label << ", paced: latency median < " << percentile(histogram, 0.5)
+                  << " us, 99% < " << percentile(histogram, 0.99)
+                  << " us, " << (cpu / elapsed) << " cores busy, "
+                  << counter->count << " dispatched" << std::endl;
+    }
+}
+
+/**
+ *  Measures the throughput of AsyncAppender with an increasing number
+ *  of producer threads and compares it with the mutex protected queue
+ *  it used before, with several dispatchers sharded by thread and with
+ *  the spinning wait strategies.  The number of cores kept busy is the
+ *  processor time of the process divided by the elapsed time.  The
+ *  dispatch latency of each wait strategy is then measured with a single
+ *  thread logging one event every 100 microseconds.
+ *
+ *  Usage: asyncbenchmark [max threads] [events per thread] [buffer size] [dispatchers]
+ */
+int main(int argc, const char* const argv[])
+{
+    apr_app_initialize(&argc, &argv, NULL);
+    int maxThreads = (argc > 1) ? atoi(argv[1]) : 64;
+    eventsPerThread = (argc > 2) ? atoi(argv[2]) : 100000;
+    int bufferSize = (argc > 3) ? atoi(argv[3]) : 1024;
+    int dispatchers = (argc > 4) ? atoi(argv[4]) : 4;
+    int result = EXIT_SUCCESS;
+    try
+    {
+        logger = Logger::getLogger("benchmark.async");
+        logger->setAdditivity(false);
+
+        for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+            CountingAppenderPtr counter(new CountingAppender());
+            AppenderPtr mutexQueue(new MutexQueueAppender(counter, bufferSize));
+            apr_time_t elapsed = run(mutexQueue, threadCount);
+            report("mutex queue", threadCount, elapsed, counter->count);
+
+            counter = new CountingAppender();
+            AsyncAppenderPtr async(new AsyncAppender());
+            async->setBufferSize(bufferSize);
+            async->addAppender(counter);
+            elapsed = run(async, threadCount);
+            report("ring buffer", threadCount, elapsed, counter->count);
+
+            counter = new CountingAppender();
+            async = new AsyncAppender();
+            async->setBufferSize(bufferSize);
+            async->setDispatcherCount(dispatchers);
+            async->setShardByThread(true);
+            async->addAppender(counter);
+            elapsed = run(async, threadCount);
+            report("sharded ring buffers", threadCount, elapsed, counter->count);
+
+            counter = new CountingAppender();
+            async = new AsyncAppender();
+            async->setBufferSize(bufferSize);
+            async->setWaitStrategy(AsyncAppender::SPIN_THEN_PARK);
+            async->addAppender(counter);
+            elapsed = run(async, threadCount);
+            report("ring buffer, spin then park", threadCount, elapsed, counter->count);
+
+            counter = new CountingAppender();
+            async = new AsyncAppender();
+            async->setBufferSize(bufferSize);
+            async->setWaitStrategy(AsyncAppender::BUSY_SPIN);
+            async->addAppender(counter);
+            elapsed = run(async, threadCount);
+            report("ring buffer, busy spin", threadCount, elapsed, counter->count);
+        }
+
+        reportLatency("blocking", AsyncAppender::BLOCKING, bufferSize);
+        reportLatency("spin then park", AsyncAppender::SPIN_THEN_PARK, bufferSize);
+        reportLatency("busy spin", AsyncAppender::BUSY_SPIN, bufferSize);
+        logger = 0;
+    }
+    catch(std::exception&)
+    {
+        result = EXIT_FAILURE;
+    }
+
+    apr_terminate();
+    return result;
+}
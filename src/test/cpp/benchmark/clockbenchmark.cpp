@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <log4cxx/logger.h>
+#include <log4cxx/appenderskeleton.h>
+#include <log4cxx/spi/loggingevent.h>
+#include <log4cxx/helpers/clock.h>
+#include <log4cxx/helpers/pool.h>
+#include <apr_general.h>
+#include <apr_time.h>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+/**
+ *  Appender that only touches the time stamp of each event.
+ */
+class TimeStampAppender : public AppenderSkeleton {
+public:
+    log4cxx_time_t last;
+
+    TimeStampAppender() : last(0) {
+    }
+
+    void append(const LoggingEventPtr& event, Pool&) {
+        last = event->getTimeStamp();
+    }
+
+    void close() {
+    }
+
+    bool requiresLayout() const {
+        return false;
+    }
+};
+
+typedef ObjectPtrT<TimeStampAppender> TimeStampAppenderPtr;
+
+/**
+ *  Measures the cost of reading each clock type and of a logging
+ *  request whose time stamp is taken from it.
+ *
+ *  Usage: clockbenchmark [iterations]
+ */
+int main(int argc, const char* const argv[])
+{
+    apr_app_initialize(&argc, &argv, NULL);
+    int iterations = (argc > 1) ? atoi(argv[1]) : 1000000;
+    int result = EXIT_SUCCESS;
+    try
+    {
+        LoggerPtr logger(Logger::getLogger("benchmark.clock"));
+        logger->setAdditivity(false);
+        TimeStampAppenderPtr appender(new TimeStampAppender());
+        logger->addAppender(appender);
+        LogString msg(LOG4CXX_STR("Hello, World"));
+        LevelPtr info(Level::getInfo());
+
+        const Clock::Type types[] = { Clock::SYSTEM_CLOCK, Clock::COARSE_CLOCK, Clock::TSC_CLOCK };
+        const char* names[] = { "system", "coarse", "tsc" };
+        for (int t = 0; t < 3; t++) {
+            if (Clock::setType(types[t]) != types[t]) {
+                std::cout << names[t] << ": not available" << std::endl;
+                continue;
+            }
+
+            bool cycles = false;
+            apr_time_t start = apr_time_now();
+            for (int i = 0; i < iterations; i++) {
+                appender->last = Clock::read(cycles);
+            }
+            apr_time_t readElapsed = apr_time_now() - start;
+
+            start = apr_time_now();
+            for (int i = 0; i < iterations; i++) {
+                logger->forcedLogLS(info, msg, LOG4CXX_LOCATION);
+            }
+            apr_time_t logElapsed = apr_time_now() - start;
+
+            std::cout << names[t] << ": "
+                      << (readElapsed * 1000.0 / iterations) << " ns/read, "
+                      << (logElapsed * 1000.0 / iterations) << " ns/event" << std::endl;
+        }
+    }
+    catch(std::exception&)
+    {
+        result = EXIT_FAILURE;
+    }
+
+    apr_terminate();
+    return result;
+}
@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logger.h>
+#include <log4cxx/logmanager.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <apr_general.h>
+#include <apr_time.h>
+#include <iostream>
+#include <vector>
+#include <stdlib.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+
+namespace {
+    std::vector<LogString> names;
+    int lookups;
+
+    void* LOG4CXX_THREAD_FUNC lookup(apr_thread_t* /* thread */, void* /* data */) {
+        size_t count = names.size();
+        for (int i = 0; i < lookups; i++) {
+            LoggerPtr logger(LogManager::getLogger(names[i % count]));
+        }
+        return 0;
+    }
+}
+
+/**
+ *  Measures the throughput of looking up existing loggers by name
+ *  from an increasing number of threads.
+ *
+ *  Usage: loggerlookupbenchmark [max threads] [lookups per thread] [loggers]
+ */
+int main(int argc, const char* const argv[])
+{
+    apr_app_initialize(&argc, &argv, NULL);
+    int maxThreads = (argc > 1) ? atoi(argv[1]) : 8;
+    lookups = (argc > 2) ? atoi(argv[2]) : 1000000;
+    int loggerCount = (argc > 3) ? atoi(argv[3]) : 1000;
+    int result = EXIT_SUCCESS;
+    try
+    {
+        Pool p;
+        for (int i = 0; i < loggerCount; i++) {
+            LogString name(LOG4CXX_STR("benchmark.lookup.tenant"));
+            StringHelper::toString(i, p, name);
+            LogManager::getLogger(name);
+            names.push_back(name);
+        }
+
+        for (int threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+            std::vector<Thread*> threads;
+            apr_time_t start = apr_time_now();
+            for (int i = 0; i < threadCount; i++) {
+                threads.push_back(new Thread());
+                threads.back()->run(lookup, 0);
+            }
+            for (int i = 0; i < threadCount; i++) {
+                threads[i]->join();
+                delete threads[i];
+            }
+            apr_time_t elapsed = apr_time_now() - start;
+            std::cout << threadCount << " threads: "
+                      << ((double) lookups * threadCount / elapsed) << " million lookups/s, "
+                      << (elapsed * 1000.0 / lookups) << " ns/lookup per thread" << std::endl;
+        }
+    }
+    catch(std::exception&)
+    {
+        result = EXIT_FAILURE;
+    }
+
+    apr_terminate();
+    return result;
+}
@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <log4cxx/patternlayout.h>
+#include <log4cxx/level.h>
+#include <log4cxx/spi/loggingevent.h>
+#include <log4cxx/pattern/patternparser.h>
+#include <log4cxx/pattern/loggingeventpatternconverter.h>
+#include <log4cxx/pattern/formattinginfo.h>
+#include <log4cxx/helpers/pool.h>
+#include <apr_general.h>
+#include <apr_time.h>
+#include <iostream>
+#include <stdlib.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::pattern;
+using namespace log4cxx::spi;
+
+/**
+ *  PatternLayout formatted the way it was before patterns were compiled:
+ *  one virtual call and one padding call for every converter.
+ */
+class InterpretedPatternLayout : public PatternLayout {
+public:
+    std::vector<LoggingEventPatternConverterPtr> converters;
+    std::vector<FormattingInfoPtr> fields;
+
+    InterpretedPatternLayout(const LogString& pattern) : PatternLayout(pattern) {
+        std::vector<PatternConverterPtr> parsed;
+        PatternParser::parse(pattern, parsed, fields, getFormatSpecifiers());
+        for(std::vector<PatternConverterPtr>::const_iterator iter = parsed.begin();
+            iter != parsed.end();
+            iter++) {
+            LoggingEventPatternConverterPtr eventConverter(*iter);
+            if (eventConverter != NULL) {
+                converters.push_back(eventConverter);
+            }
+        }
+    }
+
+    void format(LogString& output, const LoggingEventPtr& event, Pool& pool) const {
+        std::vector<FormattingInfoPtr>::const_iterator formatterIter = fields.begin();
+        for(std::vector<LoggingEventPatternConverterPtr>::const_iterator converterIter = converters.begin();
+            converterIter != converters.end();
+            converterIter++, formatterIter++) {
+            int startField = output.length();
+            (*converterIter)->format(event, output, pool);
+            (*formatterIter)->format(startField, output);
+        }
+    }
+};
+
+template<class L>
+double measure(const L& layout, const LoggingEventPtr& event, int iterations) {
+    Pool pool;
+    LogString output;
+    apr_time_t start = apr_time_now();
+    for (int i = 0; i < iterations; i++) {
+        output.erase(output.begin(), output.end());
+        layout.format(output, event, pool);
+    }
+    return (apr_time_now() - start) * 1000.0 / iterations;
+}
+
+/**
+ *  Measures the cost of formatting one event with typical conversion
+ *  patterns, interpreted and compiled.
+ *
+ *  Usage: patternlayoutbenchmark [iterations]
+ */
+int main(int argc, const char* const argv[])
+{
+    apr_app_initialize(&argc, &argv, NULL);
+    int iterations = (argc > 1) ? atoi(argv[1]) : 1000000;
+    int result = EXIT_SUCCESS;
+    try
+    {
+        LoggingEventPtr event(new LoggingEvent(LOG4CXX_STR("org.example.benchmark.PatternLayout"),
+            Level::getInfo(), LOG4CXX_STR("Hello, World"), LOG4CXX_LOCATION));
+        const logchar* patterns[] = {
+            LOG4CXX_STR("%m%n"),
+            LOG4CXX_STR("%d %-5p [%t] %c - %m%n"),
+            LOG4CXX_STR("%r [%t] %-5p %c{1} %x - %m%n") };
+        const char* names[] = { "%m%n", "%d %-5p [%t] %c - %m%n", "%r [%t] %-5p %c{1} %x - %m%n" };
+        for (int p = 0; p < 3; p++) {
+            InterpretedPatternLayout interpreted(patterns[p]);
+            PatternLayout compiled(patterns[p]);
+            double before = measure(interpreted, event, iterations);
+            double after = measure(compiled, event, iterations);
+            std::cout << names[p] << ": "
+                      << before << " ns/event interpreted, "
+                      << after << " ns/event compiled" << std::endl;
+        }
+    }
+    catch(std::exception&)
+    {
+        result = EXIT_FAILURE;
+    }
+
+    apr_terminate();
+    return result;
+}
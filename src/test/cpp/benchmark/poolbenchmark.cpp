@@ -0,0 +1,185 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logger.h>
+#include <log4cxx/appenderskeleton.h>
+#include <log4cxx/spi/loggingevent.h>
+#include <log4cxx/helpers/pool.h>
+#include <apr_general.h>
+#include <apr_time.h>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+//
+//   heap allocations are counted by replacing the global operator new
+//   and, with glibc, malloc itself, which also sees the allocations
+//   of APR.  The benchmark is single threaded.
+//
+static unsigned long newCount = 0;
+
+#if __cplusplus >= 201103L
+#define BENCHMARK_THROW_BAD_ALLOC
+#define BENCHMARK_NOTHROW noexcept
+#else
+#define BENCHMARK_THROW_BAD_ALLOC throw(std::bad_alloc)
+#define BENCHMARK_NOTHROW throw()
+#endif
+
+void* operator new(size_t size) BENCHMARK_THROW_BAD_ALLOC {
+    newCount++;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) BENCHMARK_NOTHROW {
+    free(p);
+}
+
+#if defined(__GLIBC__)
+static unsigned long mallocCount = 0;
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+void* malloc(size_t size) __THROW {
+    mallocCount++;
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) __THROW {
+    mallocCount++;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) __THROW {
+    mallocCount++;
+    return __libc_realloc(p, size);
+}
+}
+#define HAS_MALLOC_COUNT 1
+#else
+#define HAS_MALLOC_COUNT 0
+#endif
+
+/**
+ *  Appender that only counts events.
+ */
+class CountingAppender : public AppenderSkeleton {
+public:
+    int count;
+
+    CountingAppender() : count(0) {
+    }
+
+    void append(const LoggingEventPtr&, Pool&) {
+        count++;
+    }
+
+    void close() {
+    }
+
+    bool requiresLayout() const {
+        return false;
+    }
+};
+
+typedef ObjectPtrT<CountingAppender> CountingAppenderPtr;
+
+struct AllocationCounts {
+    unsigned long news;
+    unsigned long mallocs;
+
+    AllocationCounts() : news(newCount),
+#if HAS_MALLOC_COUNT
+       mallocs(mallocCount) {
+#else
+       mallocs(0) {
+#endif
+    }
+};
+
+static void report(const char* label, int events, apr_time_t elapsed,
+    const AllocationCounts& before) {
+    AllocationCounts after;
+    std::cout << label << ": "
+              << (elapsed * 1000.0 / events) << " ns/event, "
+              << ((double) (after.news - before.news) / events) << " operator new/event";
+#if HAS_MALLOC_COUNT
+    std::cout << ", " << ((double) (after.mallocs - before.mallocs) / events)
+              << " heap allocations/event";
+#endif
+    std::cout << std::endl;
+}
+
+/**
+ *  Compares the cost of a logging request that creates an APR pool
+ *  per event, as Logger::forcedLog used to, with the current
+ *  forcedLog which reuses a per-thread pool.  Reports the time and
+ *  the measured number of allocations per event, heap allocations
+ *  made by APR pools are only counted with glibc.
+ *
+ *  Usage: poolbenchmark [events]
+ */
+int main(int argc, const char* const argv[])
+{
+    apr_app_initialize(&argc, &argv, NULL);
+    int events = (argc > 1) ? atoi(argv[1]) : 1000000;
+    int result = EXIT_SUCCESS;
+    try
+    {
+        LoggerPtr logger(Logger::getLogger("benchmark.pool"));
+        logger->setAdditivity(false);
+        CountingAppenderPtr appender(new CountingAppender());
+        logger->addAppender(appender);
+        LogString name(logger->getName());
+        LogString msg(LOG4CXX_STR("Hello, World"));
+        LevelPtr info(Level::getInfo());
+
+        AllocationCounts before;
+        apr_time_t start = apr_time_now();
+        for (int i = 0; i < events; i++) {
+            Pool p;
+            LoggingEventPtr event(new LoggingEvent(name, info, msg, LOG4CXX_LOCATION));
+            logger->callAppenders(event, p);
+        }
+        report("pool per event", events, apr_time_now() - start, before);
+
+        before = AllocationCounts();
+        start = apr_time_now();
+        for (int i = 0; i < events; i++) {
+            logger->forcedLogLS(info, msg, LOG4CXX_LOCATION);
+        }
+        report("forcedLog", events, apr_time_now() - start, before);
+    }
+    catch(std::exception&)
+    {
+        result = EXIT_FAILURE;
+    }
+
+    apr_terminate();
+    return result;
+}
@@ -18,10 +18,54 @@
 #include "fileappendertestcase.h"
 #include <log4cxx/helpers/objectptr.h>
 #include <log4cxx/fileappender.h>
+#include <log4cxx/patternlayout.h>
+#include <log4cxx/spi/loggingevent.h>
+#include <log4cxx/helpers/writer.h>
+#include <log4cxx/helpers/thread.h>
 #include "insertwide.h"
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+/**
+ *  Writer that keeps the written text and counts write and flush calls.
+ */
+class CountingWriter : public Writer
+{
+public:
+        LogString text;
+        int writes;
+        int flushes;
+
+        CountingWriter() : writes(0), flushes(0) {}
+
+        void close(Pool&) {}
+
+        void flush(Pool&) {
+            flushes++;
+        }
+
+        void write(const LogString& str, Pool&) {
+            text.append(str);
+            writes++;
+        }
+};
+
+/**
+ *  FileAppender that appends without going through doAppend,
+ *  as RollingFileAppenderSkeleton does after a rollover.
+ */
+class DirectFileAppender : public FileAppender
+{
+public:
+        void closeAndAppend(const LoggingEventPtr& event, Pool& p) {
+            closeWriter();
+            subAppend(event, p);
+            LoggingEventList events(1, event);
+            subAppendBatch(events, p);
+        }
+};
 
 WriterAppender* FileAppenderAbstractTestCase::createWriterAppender() const {
     return createFileAppender();
@@ -43,6 +87,9 @@ class FileAppenderTestCase : public FileAppenderAbstractTestCase
                 //  tests defined here
                 LOGUNIT_TEST(testSetDoubleBackslashes);
                 LOGUNIT_TEST(testStripDuplicateBackslashes);
+                LOGUNIT_TEST(testAppendBatch);
+                LOGUNIT_TEST(testFormatOutsideLock);
+                LOGUNIT_TEST(testAppendAfterClose);
 
    LOGUNIT_TEST_SUITE_END();
 
@@ -106,6 +153,102 @@ public:
                 FileAppender::stripDuplicateBackslashes(LOG4CXX_STR("\\\\\\\\foo.log")));
           }  
 
+        /**
+         * Tests that a batch is filtered by threshold and
+         * written and flushed once.
+         */
+        void testAppendBatch() {
+            Pool p;
+            FileAppenderPtr appender(new FileAppender());
+            appender->setLayout(new PatternLayout(LOG4CXX_STR("%m%n")));
+            appender->setThreshold(Level::getInfo());
+            CountingWriter* counter = new CountingWriter();
+            WriterPtr writer(counter);
+            appender->setWriter(writer);
+
+            LoggingEventList events;
+            events.push_back(new LoggingEvent(LOG4CXX_STR("org.example.batch"),
+                Level::getInfo(), LOG4CXX_STR("one"), LOG4CXX_LOCATION));
+            events.push_back(new LoggingEvent(LOG4CXX_STR("org.example.batch"),
+                Level::getDebug(), LOG4CXX_STR("hidden"), LOG4CXX_LOCATION));
+            events.push_back(new LoggingEvent(LOG4CXX_STR("org.example.batch"),
+                Level::getWarn(), LOG4CXX_STR("two"), LOG4CXX_LOCATION));
+            appender->doAppendBatch(events, p);
+
+            LogString expected(LOG4CXX_STR("one"));
+            expected.append(LOG4CXX_EOL);
+            expected.append(LOG4CXX_STR("two"));
+            expected.append(LOG4CXX_EOL);
+            LOGUNIT_ASSERT_EQUAL(expected, counter->text);
+            LOGUNIT_ASSERT_EQUAL(1, counter->writes);
+            LOGUNIT_ASSERT_EQUAL(1, counter->flushes);
+        }
+
+        enum { THREAD_COUNT = 4, THREAD_REPS = 1000 };
+
+        static void* LOG4CXX_THREAD_FUNC appendAction(apr_thread_t* /* thread */, void* data) {
+            FileAppender* appender = (FileAppender*) data;
+            Pool p;
+            LoggingEventPtr event(new LoggingEvent(LOG4CXX_STR("org.example.concurrent"),
+                Level::getInfo(), LOG4CXX_STR("concurrent"), LOG4CXX_LOCATION));
+            for(int i = 0; i < THREAD_REPS; i++) {
+                appender->doAppend(event, p);
+            }
+            return 0;
+        }
+
+        /**
+         * Tests that events formatted outside the appender lock
+         * are filtered and written whole.
+         */
+        void testFormatOutsideLock() {
+            Pool p;
+            FileAppenderPtr appender(new FileAppender());
+            appender->setOption(LOG4CXX_STR("FormatOutsideLock"), LOG4CXX_STR("true"));
+            LOGUNIT_ASSERT(appender->getFormatOutsideLock());
+            appender->setLayout(new PatternLayout(LOG4CXX_STR("%-5p %m%n")));
+            appender->setThreshold(Level::getInfo());
+            CountingWriter* counter = new CountingWriter();
+            WriterPtr writer(counter);
+            appender->setWriter(writer);
+
+            appender->doAppend(new LoggingEvent(LOG4CXX_STR("org.example.concurrent"),
+                Level::getDebug(), LOG4CXX_STR("hidden"), LOG4CXX_LOCATION), p);
+            LOGUNIT_ASSERT_EQUAL(0, counter->writes);
+
+            Thread threads[THREAD_COUNT];
+            for(int i = 0; i < THREAD_COUNT; i++) {
+                threads[i].run(appendAction, &*appender);
+            }
+            for(int i = 0; i < THREAD_COUNT; i++) {
+                threads[i].join();
+            }
+
+            LogString line(LOG4CXX_STR("INFO  concurrent"));
+            line.append(LOG4CXX_EOL);
+            LogString expected;
+            for(int i = 0; i < THREAD_COUNT * THREAD_REPS; i++) {
+                expected.append(line);
+            }
+            LOGUNIT_ASSERT_EQUAL(THREAD_COUNT * THREAD_REPS, counter->writes);
+            LOGUNIT_ASSERT(expected == counter->text);
+        }
+
+        /**
+         *  Appending once the writer is closed drops the event.
+         */
+        void testAppendAfterClose() {
+            Pool p;
+            DirectFileAppender appender;
+            appender.setLayout(new PatternLayout(LOG4CXX_STR("%m%n")));
+            CountingWriter* counter = new CountingWriter();
+            WriterPtr writer(counter);
+            appender.setWriter(writer);
+            LoggingEventPtr event(new LoggingEvent(LOG4CXX_STR("org.example.closed"),
+                Level::getInfo(), LOG4CXX_STR("dropped"), LOG4CXX_LOCATION));
+            appender.closeAndAppend(event, p);
+            LOGUNIT_ASSERT(counter->text.empty());
+        }
 };
 
 LOGUNIT_TEST_SUITE_REGISTRATION(FileAppenderTestCase);
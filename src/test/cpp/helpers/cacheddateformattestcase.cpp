@@ -25,6 +25,9 @@
 #include <apr.h>
 #include <apr_time.h>
 #include "localechanger.h"
+#include <log4cxx/helpers/thread.h>
+#include <apr_atomic.h>
+#include <log4cxx/pattern/datepatternconverter.h>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
@@ -76,6 +79,12 @@ LOGUNIT_CLASS(CachedDateFormatTestCase)
      LOGUNIT_TEST(test19);
      LOGUNIT_TEST(test20);
      LOGUNIT_TEST(test21);
+     LOGUNIT_TEST(test22);
+     LOGUNIT_TEST(test23);
+     LOGUNIT_TEST(test24);
+     LOGUNIT_TEST(test25);
+     LOGUNIT_TEST(test26);
+     LOGUNIT_TEST(test27);
      LOGUNIT_TEST_SUITE_END();
 
 #define MICROSECONDS_PER_DAY APR_INT64_C(86400000000)
@@ -642,6 +651,156 @@ void test21() {
     LOGUNIT_ASSERT_EQUAL(1000, maxValid);
 }
 
+/**
+ * Check that patterns with one group of 6 S's
+ * are reported as being able to be cached for a full second.
+ */
+void test22() {
+
+    int maxValid =
+       CachedDateFormat::getMaximumCacheValidity(
+          LOG4CXX_STR("yyyy-MM-dd HH:mm:ss.SSSSSS"));
+    LOGUNIT_ASSERT_EQUAL(1000000, maxValid);
+}
+
+/**
+ * Check that the microsecond digits are patched
+ * within the cached second.
+ */
+void test23() {
+    apr_time_t jul2 = 12602L * MICROSECONDS_PER_DAY;
+    DateFormatPtr simpleFormat = new SimpleDateFormat(LOG4CXX_STR("HH:mm:ss.SSSSSS"));
+    simpleFormat->setTimeZone(TimeZone::getGMT());
+    CachedDateFormat cachedFormat(simpleFormat, 1000000);
+
+    Pool p;
+    LogString s;
+    cachedFormat.format(s, jul2 + 5, p);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("00:00:00.000005"), s);
+
+    s.erase(s.begin(), s.end());
+    int microStart = CachedDateFormat::findMicrosecondStart(jul2 + 5,
+        LOG4CXX_STR("00:00:00.000005"), simpleFormat, p);
+    LOGUNIT_ASSERT_EQUAL(9, microStart);
+
+    cachedFormat.format(s, jul2 + 654321, p);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("00:00:00.654321"), s);
+
+    s.erase(s.begin(), s.end());
+    cachedFormat.format(s, jul2 + 1000001, p);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("00:00:01.000001"), s);
+}
+
+enum { THREAD_COUNT = 4, THREAD_REPS = 20000 };
+
+struct SharedFormat {
+    DateFormatPtr simpleFormat;
+    DateFormatPtr cachedFormat;
+    apr_time_t start;
+    volatile apr_uint32_t failures;
+};
+
+static void* LOG4CXX_THREAD_FUNC formatAction(apr_thread_t* /* thread */, void* data) {
+    SharedFormat* shared = (SharedFormat*) data;
+    Pool p;
+    LogString expected;
+    LogString actual;
+    for (int i = 0; i < THREAD_REPS; i++) {
+        //  times spread over a few seconds so that slots are republished
+        apr_time_t when = shared->start + (i * 7919L) % 3000000L;
+        expected.erase(expected.begin(), expected.end());
+        actual.erase(actual.begin(), actual.end());
+        shared->simpleFormat->format(expected, when, p);
+        shared->cachedFormat->format(actual, when, p);
+        if (expected != actual) {
+            apr_atomic_inc32(&shared->failures);
+        }
+    }
+    return 0;
+}
+
+/**
+ * Check that one cache shared by several threads
+ * produces the same text as the wrapped format.
+ */
+void test24() {
+    SharedFormat shared;
+    shared.simpleFormat = new SimpleDateFormat(LOG4CXX_STR("yyyy-MM-dd HH:mm:ss,SSS"));
+    shared.simpleFormat->setTimeZone(TimeZone::getGMT());
+    shared.cachedFormat = new CachedDateFormat(shared.simpleFormat, 1000000);
+    shared.start = 12602L * MICROSECONDS_PER_DAY;
+    shared.failures = 0;
+
+    Thread threads[THREAD_COUNT];
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        threads[i].run(formatAction, &shared);
+    }
+    for (int i = 0; i < THREAD_COUNT; i++) {
+        threads[i].join();
+    }
+    LOGUNIT_ASSERT_EQUAL((apr_uint32_t) 0, apr_atomic_read32(&shared.failures));
+}
+
+static DatePatternConverterPtr newDateConverter(const logchar* pattern,
+    const logchar* timeZone) {
+    std::vector<LogString> options;
+    options.push_back(pattern);
+    if (timeZone != 0) {
+        options.push_back(timeZone);
+    }
+    return DatePatternConverter::newInstance(options);
+}
+
+/**
+ * Check that converters with the same pattern share one date format
+ * and that it is dropped once they are gone.
+ */
+void test25() {
+    DatePatternConverterPtr first(newDateConverter(LOG4CXX_STR("HH:mm:ss,SSS"), 0));
+    DatePatternConverterPtr second(newDateConverter(LOG4CXX_STR("HH:mm:ss,SSS"), 0));
+    DateFormatPtr shared(first->getDateFormat());
+    LOGUNIT_ASSERT(shared != 0);
+    LOGUNIT_ASSERT(shared == second->getDateFormat());
+
+    first = 0;
+    DatePatternConverterPtr third(newDateConverter(LOG4CXX_STR("HH:mm:ss,SSS"), 0));
+    LOGUNIT_ASSERT(shared == third->getDateFormat());
+
+    second = 0;
+    third = 0;
+    DatePatternConverterPtr fourth(newDateConverter(LOG4CXX_STR("HH:mm:ss,SSS"), 0));
+    LOGUNIT_ASSERT(shared != fourth->getDateFormat());
+}
+
+/**
+ * Check that converters with a different pattern or time zone
+ * do not share their date format.
+ */
+void test26() {
+    DatePatternConverterPtr local(newDateConverter(LOG4CXX_STR("HH:mm:ss,SSS"), 0));
+    DatePatternConverterPtr gmt(newDateConverter(LOG4CXX_STR("HH:mm:ss,SSS"),
+        LOG4CXX_STR("GMT")));
+    DatePatternConverterPtr other(newDateConverter(LOG4CXX_STR("HH:mm:ss"), 0));
+    LOGUNIT_ASSERT(local->getDateFormat() != gmt->getDateFormat());
+    LOGUNIT_ASSERT(local->getDateFormat() != other->getDateFormat());
+    LOGUNIT_ASSERT(gmt->getDateFormat() != other->getDateFormat());
+}
+
+/**
+ * Check that converters created under different locales
+ * do not share their date format.
+ */
+void test27() {
+#if LOG4CXX_HAS_STD_LOCALE
+    DatePatternConverterPtr initial(newDateConverter(LOG4CXX_STR("EEE, MMM dd"), 0));
+    LocaleChanger localeChange(LOCALE_JP);
+    if (localeChange.isEffective()) {
+        DatePatternConverterPtr japanese(newDateConverter(LOG4CXX_STR("EEE, MMM dd"), 0));
+        LOGUNIT_ASSERT(initial->getDateFormat() != japanese->getDateFormat());
+    }
+#endif
+}
+
 };
 
 LOGUNIT_TEST_SUITE_REGISTRATION(CachedDateFormatTestCase);
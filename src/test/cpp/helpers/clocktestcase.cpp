@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/helpers/clock.h>
+#include <log4cxx/logger.h>
+#include <log4cxx/spi/loggingevent.h>
+#include "../insertwide.h"
+#include "../logunit.h"
+#include <apr_time.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+/**
+ *  Test the clock types used for event time stamps.
+ */
+LOGUNIT_CLASS(ClockTestCase)
+{
+   LOGUNIT_TEST_SUITE(ClockTestCase);
+      LOGUNIT_TEST(testSystem);
+      LOGUNIT_TEST(testCoarse);
+      LOGUNIT_TEST(testTSC);
+      LOGUNIT_TEST(testNames);
+      LOGUNIT_TEST(testEventTimeStamp);
+      LOGUNIT_TEST(testEventTimeStampAfterRecalibration);
+   LOGUNIT_TEST_SUITE_END();
+
+   Clock::Type original;
+
+public:
+    void setUp() {
+       original = Clock::getType();
+    }
+
+    void tearDown() {
+       Clock::setType(original);
+    }
+
+    /**
+     *  Checks that the selected clock agrees with apr_time_now
+     *  within the resolution of the coarsest clock.
+     */
+    void assertCloseToNow() {
+       apr_time_t before = apr_time_now();
+       bool cycles = false;
+       log4cxx_time_t stamp = Clock::read(cycles);
+       if (cycles) {
+           stamp = Clock::toTime(stamp);
+       }
+       apr_time_t after = apr_time_now();
+       const log4cxx_time_t tolerance = 50000;
+       LOGUNIT_ASSERT(stamp >= before - tolerance);
+       LOGUNIT_ASSERT(stamp <= after + tolerance);
+    }
+
+    void testSystem() {
+       LOGUNIT_ASSERT_EQUAL((int) Clock::SYSTEM_CLOCK, (int) Clock::setType(Clock::SYSTEM_CLOCK));
+       bool cycles = true;
+       Clock::read(cycles);
+       LOGUNIT_ASSERT_EQUAL(false, cycles);
+       assertCloseToNow();
+    }
+
+    void testCoarse() {
+       Clock::setType(Clock::COARSE_CLOCK);
+       assertCloseToNow();
+    }
+
+    void testTSC() {
+       Clock::setType(Clock::TSC_CLOCK);
+       assertCloseToNow();
+       apr_sleep(20000);
+       assertCloseToNow();
+    }
+
+    void testNames() {
+       LOGUNIT_ASSERT_EQUAL(true, Clock::setType(LOG4CXX_STR("system")));
+       LOGUNIT_ASSERT_EQUAL((int) Clock::SYSTEM_CLOCK, (int) Clock::getType());
+       LOGUNIT_ASSERT_EQUAL(true, Clock::setType(LOG4CXX_STR("Coarse")));
+       LOGUNIT_ASSERT_EQUAL(true, Clock::setType(LOG4CXX_STR("TSC")));
+       Clock::Type selected = Clock::getType();
+       LOGUNIT_ASSERT_EQUAL(false, Clock::setType(LOG4CXX_STR("sundial")));
+       LOGUNIT_ASSERT_EQUAL((int) selected, (int) Clock::getType());
+    }
+
+    void testEventTimeStamp() {
+       Clock::setType(Clock::TSC_CLOCK);
+       apr_time_t before = apr_time_now();
+       LoggingEventPtr event(new LoggingEvent(LOG4CXX_STR("org.example.clock"),
+             Level::getInfo(), LOG4CXX_STR("Hello, World"), LOG4CXX_LOCATION));
+       apr_time_t after = apr_time_now();
+       const log4cxx_time_t tolerance = 50000;
+       LOGUNIT_ASSERT(event->getTimeStamp() >= before - tolerance);
+       LOGUNIT_ASSERT(event->getTimeStamp() <= after + tolerance);
+    }
+
+    /**
+     *  The time stamp of an event must not move when the clock is recalibrated.
+     */
+    void testEventTimeStampAfterRecalibration() {
+       Clock::setType(Clock::TSC_CLOCK);
+       LoggingEventPtr event(new LoggingEvent(LOG4CXX_STR("org.example.clock"),
+             Level::getInfo(), LOG4CXX_STR("Hello, World"), LOG4CXX_LOCATION));
+       log4cxx_time_t first = event->getTimeStamp();
+       apr_sleep(20000);
+       Clock::recalibrate();
+       LOGUNIT_ASSERT(first == event->getTimeStamp());
+    }
+};
+
+LOGUNIT_TEST_SUITE_REGISTRATION(ClockTestCase);
@@ -0,0 +1,109 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/helpers/deferredmessage.h>
+#include <log4cxx/logger.h>
+#include <log4cxx/spi/loggingevent.h>
+#include "../vectorappender.h"
+#include "../insertwide.h"
+#include "../logunit.h"
+#include <log4cxx/logstring.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+/**
+ *  Test DeferredMessage and the LOG4CXX_*_ASYNC macros.
+ */
+LOGUNIT_CLASS(DeferredMessageTest)
+{
+   LOGUNIT_TEST_SUITE(DeferredMessageTest);
+      LOGUNIT_TEST(testNoArguments);
+      LOGUNIT_TEST(testIntegers);
+      LOGUNIT_TEST(testStrings);
+      LOGUNIT_TEST(testMissingArguments);
+      LOGUNIT_TEST(testExtraArguments);
+      LOGUNIT_TEST(testCopy);
+      LOGUNIT_TEST(testMacro);
+   LOGUNIT_TEST_SUITE_END();
+
+
+public:
+    void testNoArguments() {
+       LogString msg;
+       DeferredMessage("Hello, {}").format(msg);
+       LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("Hello, {}"), msg);
+    }
+
+    void testIntegers() {
+       LogString msg;
+       DeferredMessage("{} {} {} {} {}", 1, -2, 3U, 'x', true).format(msg);
+       LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("1 -2 3 x true"), msg);
+    }
+
+    void testStrings() {
+       LogString msg;
+       std::string world("World");
+       DeferredMessage("Hello, {}{}", world, "!").format(msg);
+       LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("Hello, World!"), msg);
+    }
+
+    void testMissingArguments() {
+       LogString msg;
+       DeferredMessage("{} and {}", 1).format(msg);
+       LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("1 and {}"), msg);
+    }
+
+    void testExtraArguments() {
+       LogString msg;
+       DeferredMessage("{}", 1, 2).format(msg);
+       LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("1"), msg);
+    }
+
+    /**
+     *   String arguments must be copied, not referenced.
+     */
+    void testCopy() {
+       std::string value("before");
+       DeferredMessage message("{}", value);
+       value = "after";
+       LogString msg;
+       message.format(msg);
+       LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("before"), msg);
+    }
+
+    void testMacro() {
+       LoggerPtr logger(Logger::getLogger("DeferredMessageTest"));
+       VectorAppenderPtr appender(new VectorAppender());
+       logger->addAppender(appender);
+       logger->setLevel(Level::getInfo());
+       LOG4CXX_DEBUG_ASYNC(logger, "not {}", "logged");
+       LOG4CXX_INFO_ASYNC(logger, "{} + {} = {}", 1, 2L, 3.5);
+       LOG4CXX_WARN_ASYNC(logger, "plain");
+       logger->removeAppender(appender);
+       logger->setLevel(0);
+
+       const std::vector<LoggingEventPtr>& events = appender->getVector();
+       LOGUNIT_ASSERT_EQUAL((size_t) 2, events.size());
+       LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("1 + 2 = 3.5"), events[0]->getMessage());
+       LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("1 + 2 = 3.5"), events[0]->getRenderedMessage());
+       LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("plain"), events[1]->getMessage());
+    }
+};
+
+LOGUNIT_TEST_SUITE_REGISTRATION(DeferredMessageTest);
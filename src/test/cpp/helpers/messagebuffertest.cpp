@@ -41,6 +41,8 @@ LOGUNIT_CLASS(MessageBufferTest)
       LOGUNIT_TEST(testInsertNull);
       LOGUNIT_TEST(testInsertInt);
       LOGUNIT_TEST(testInsertManipulator);
+      LOGUNIT_TEST(testReuse);
+      LOGUNIT_TEST(testNested);
 #if LOG4CXX_WCHAR_T_API
       LOGUNIT_TEST(testInsertConstWStr);
       LOGUNIT_TEST(testInsertWString);
@@ -119,6 +121,37 @@ public:
         LOGUNIT_ASSERT_EQUAL(true, buf.hasStream());
     }
 
+    /**
+     *  Storage reused by a later buffer on the same thread
+     *  starts empty with default formatting.
+     */
+    void testReuse() {
+        {
+           MessageBuffer buf;
+           std::ostream& retval = buf << "x=" << std::hex << std::setprecision(2) << 255 << 3.1415926;
+           LOGUNIT_ASSERT_EQUAL(std::string("x=ff3.1"), buf.str(retval));
+        }
+        MessageBuffer buf;
+        std::ostream& retval = buf << "x=" << 255 << ' ' << 3.1415926;
+        LOGUNIT_ASSERT_EQUAL(std::string("x=255 3.14159"), buf.str(retval));
+    }
+
+    /**
+     *  A buffer used while another is in use on the same thread,
+     *  as when logging while formatting a message, is independent.
+     */
+    void testNested() {
+        MessageBuffer outer;
+        std::ostream& outerStream = outer << "outer " << 1;
+        {
+           MessageBuffer inner;
+           std::ostream& innerStream = inner << "inner " << 2;
+           LOGUNIT_ASSERT_EQUAL(std::string("inner 2"), inner.str(innerStream));
+        }
+        outerStream << ' ' << 3;
+        LOGUNIT_ASSERT_EQUAL(std::string("outer 1 3"), outer.str(outerStream));
+    }
+
 #if LOG4CXX_WCHAR_T_API
     void testInsertConstWStr() {
         MessageBuffer buf;
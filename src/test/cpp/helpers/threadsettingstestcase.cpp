@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <log4cxx/helpers/threadsettings.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/threadspecificdata.h>
+#include "../insertwide.h"
+#include "../logunit.h"
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+
+
+/**
+   Unit test for ThreadSettings.
+   
+   */
+LOGUNIT_CLASS(ThreadSettingsTestCase) {
+  LOGUNIT_TEST_SUITE(ThreadSettingsTestCase);
+          LOGUNIT_TEST(testOptions);
+          LOGUNIT_TEST(testInvalidAffinity);
+          LOGUNIT_TEST(testThreadName);
+  LOGUNIT_TEST_SUITE_END();
+
+  public:
+  void testOptions() {
+    ThreadSettings settings(LOG4CXX_STR("default"));
+    LOGUNIT_ASSERT_EQUAL(false, settings.hasPriority());
+    LOGUNIT_ASSERT(settings.setOption(LOG4CXX_STR("ThreadName"), LOG4CXX_STR("dispatcher")));
+    LOGUNIT_ASSERT(settings.setOption(LOG4CXX_STR("threadaffinity"), LOG4CXX_STR("0, 2-3")));
+    LOGUNIT_ASSERT(settings.setOption(LOG4CXX_STR("THREADPRIORITY"), LOG4CXX_STR("5")));
+    LOGUNIT_ASSERT(!settings.setOption(LOG4CXX_STR("Port"), LOG4CXX_STR("23")));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("dispatcher"), settings.getName());
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("0, 2-3"), settings.getAffinity());
+    LOGUNIT_ASSERT_EQUAL(true, settings.hasPriority());
+    LOGUNIT_ASSERT_EQUAL(5, settings.getPriority());
+  }
+
+  /**
+   * A malformed processor list keeps the previous affinity.
+   */
+  void testInvalidAffinity() {
+    ThreadSettings settings;
+    settings.setAffinity(LOG4CXX_STR("1"));
+    settings.setAffinity(LOG4CXX_STR("3-1"));
+    settings.setAffinity(LOG4CXX_STR("one"));
+    settings.setAffinity(LOG4CXX_STR("0-2000000000"));
+    settings.setAffinity(LOG4CXX_STR("99999999999"));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("1"), settings.getAffinity());
+  }
+
+  /**
+   * The thread name is reported for events logged by the thread.
+   */
+  void testThreadName() {
+    Thread thread1;
+    thread1.getSettings().setName(LOG4CXX_STR("worker"));
+    LogString name;
+    thread1.run(getName, &name);
+    thread1.join();
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("worker"), name);
+  }
+
+private:
+  static void* LOG4CXX_THREAD_FUNC getName(apr_thread_t* /* thread */, void* data) {
+      *(reinterpret_cast<LogString*>(data)) = ThreadSpecificData::getThreadName();
+      return NULL;
+  }
+
+};
+
+LOGUNIT_TEST_SUITE_REGISTRATION(ThreadSettingsTestCase);
+
@@ -43,6 +43,7 @@ LOGUNIT_CLASS(TimeZoneTestCase) {
           LOGUNIT_TEST(test4);
           LOGUNIT_TEST(test5);
           LOGUNIT_TEST(test6);
+          LOGUNIT_TEST(test7);
   LOGUNIT_TEST_SUITE_END();
 
 #define MICROSECONDS_PER_DAY APR_INT64_C(86400000000)
@@ -119,6 +120,33 @@ void test6() {
   LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("GMT"), tz->getID());
 }
 
+/**
+ * Checks that explodeCached agrees with explode
+ *    within a minute and across minute and day boundaries.
+ */
+void test7() {
+  TimeZonePtr tz(TimeZone::getTimeZone(LOG4CXX_STR("GMT-6")));
+  apr_time_t jan2 = MICROSECONDS_PER_DAY * 12420 + 6 * 3600 * APR_USEC_PER_SEC;
+  apr_time_t times[] = { jan2 - 1, jan2, jan2 + 59999999, jan2 + 60000000,
+                         jan2 + 61234567, jan2 - 1, jan2 + 60000000 };
+  for(size_t i = 0; i < sizeof(times)/sizeof(times[0]); i++) {
+    apr_time_exp_t expected;
+    apr_time_exp_t actual;
+    LOGUNIT_ASSERT_EQUAL(APR_SUCCESS, tz->explode(&expected, times[i]));
+    LOGUNIT_ASSERT_EQUAL(APR_SUCCESS, tz->explodeCached(&actual, times[i]));
+    LOGUNIT_ASSERT_EQUAL(expected.tm_usec, actual.tm_usec);
+    LOGUNIT_ASSERT_EQUAL(expected.tm_sec, actual.tm_sec);
+    LOGUNIT_ASSERT_EQUAL(expected.tm_min, actual.tm_min);
+    LOGUNIT_ASSERT_EQUAL(expected.tm_hour, actual.tm_hour);
+    LOGUNIT_ASSERT_EQUAL(expected.tm_mday, actual.tm_mday);
+    LOGUNIT_ASSERT_EQUAL(expected.tm_mon, actual.tm_mon);
+    LOGUNIT_ASSERT_EQUAL(expected.tm_year, actual.tm_year);
+    LOGUNIT_ASSERT_EQUAL(expected.tm_wday, actual.tm_wday);
+    LOGUNIT_ASSERT_EQUAL(expected.tm_yday, actual.tm_yday);
+    LOGUNIT_ASSERT_EQUAL(expected.tm_gmtoff, actual.tm_gmtoff);
+  }
+}
+
 
 };
 
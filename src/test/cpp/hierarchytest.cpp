@@ -18,10 +18,13 @@
 
 #include <log4cxx/logger.h>
 #include <log4cxx/hierarchy.h>
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/stringhelper.h>
 #include "logunit.h"
 #include "insertwide.h"
 
 using namespace log4cxx;
+using namespace log4cxx::helpers;
 
 /**
  * Tests hierarchy.
@@ -30,6 +33,7 @@ using namespace log4cxx;
 LOGUNIT_CLASS(HierarchyTest) {
   LOGUNIT_TEST_SUITE(HierarchyTest);
           LOGUNIT_TEST(testGetParent);
+          LOGUNIT_TEST(testManyLoggers);
   LOGUNIT_TEST_SUITE_END();
 public:
 
@@ -51,6 +55,41 @@ public:
           logger2->getParent()->getName());
   }
 
+    /**
+     * Tests lookup of loggers while the hierarchy grows and after it is cleared.
+     */
+  void testManyLoggers() {
+      Hierarchy* hierarchy = new Hierarchy();
+      spi::LoggerRepositoryPtr repo(hierarchy);
+      Pool p;
+      LoggerPtr parent(hierarchy->getLogger(LOG4CXX_STR("many")));
+      std::vector<LoggerPtr> created;
+      for (int i = 0; i < 500; i++) {
+          LogString name(LOG4CXX_STR("many."));
+          StringHelper::toString(i, p, name);
+          created.push_back(hierarchy->getLogger(name));
+      }
+      for (int i = 0; i < 500; i++) {
+          LogString name(LOG4CXX_STR("many."));
+          StringHelper::toString(i, p, name);
+          LOGUNIT_ASSERT(created[i] == hierarchy->getLogger(name));
+          LOGUNIT_ASSERT(created[i] == hierarchy->exists(name));
+          LOGUNIT_ASSERT(parent == created[i]->getParent());
+      }
+
+      LoggerList current(hierarchy->getCurrentLoggers());
+      LOGUNIT_ASSERT_EQUAL((size_t) 501, current.size());
+      for (size_t i = 1; i < current.size(); i++) {
+          LOGUNIT_ASSERT(current[i - 1]->getName() < current[i]->getName());
+      }
+
+      hierarchy->clear();
+      LOGUNIT_ASSERT(hierarchy->exists(LOG4CXX_STR("many.1")) == 0);
+      LOGUNIT_ASSERT_EQUAL((size_t) 0, hierarchy->getCurrentLoggers().size());
+      //  cleared loggers stay valid for those still holding them
+      LOGUNIT_ASSERT_EQUAL(LogString(LOG4CXX_STR("many.1")), created[1]->getName());
+  }
+
 };
 
 LOGUNIT_TEST_SUITE_REGISTRATION(HierarchyTest);
@@ -56,6 +56,53 @@ public:
                 { return true; }
 };
 
+/**
+ *  Records the pools passed to append and optionally logs
+ *  from within append to another logger.
+ */
+class PoolCapturingAppender : public AppenderSkeleton
+{
+public:
+        std::vector<apr_pool_t*> pools;
+        LoggerPtr nested;
+
+        PoolCapturingAppender()
+                {}
+
+        void close()
+                {}
+
+        void append(const spi::LoggingEventPtr& /*event*/, Pool& p)
+        {
+                pools.push_back(p.getAPRPool());
+                if (nested != 0) {
+                    LOG4CXX_INFO(nested, "nested");
+                }
+        }
+
+        bool requiresLayout() const
+                { return false; }
+};
+
+typedef helpers::ObjectPtrT<PoolCapturingAppender> PoolCapturingAppenderPtr;
+
+/**
+ *  Detaches itself from a logger when appending.
+ */
+class DetachingAppender : public CountingAppender
+{
+public:
+        LoggerPtr attachedTo;
+
+        void append(const spi::LoggingEventPtr& event, Pool& p)
+        {
+                CountingAppender::append(event, p);
+                attachedTo->removeAppender(AppenderPtr(this));
+        }
+};
+
+typedef helpers::ObjectPtrT<DetachingAppender> DetachingAppenderPtr;
+
 LOGUNIT_CLASS(LoggerTestCase)
 {
         LOGUNIT_TEST_SUITE(LoggerTestCase);
@@ -72,6 +119,9 @@ LOGUNIT_CLASS(LoggerTestCase)
                 LOGUNIT_TEST(testHierarchy1);
                 LOGUNIT_TEST(testTrace);
                 LOGUNIT_TEST(testIsTraceEnabled);
+                LOGUNIT_TEST(testInheritedLevelChange);
+                LOGUNIT_TEST(testPoolReuse);
+                LOGUNIT_TEST(testRemoveAppenderDuringAppend);
         LOGUNIT_TEST_SUITE_END();
 
 public:
@@ -453,6 +503,88 @@ public:
         LOGUNIT_ASSERT_EQUAL(false, root->isTraceEnabled());
     }
 
+    /**
+     * Tests that isXXXEnabled follows level changes on ancestors,
+     * on the repository threshold and on configuration reset.
+     */
+    void testInheritedLevelChange() {
+        LoggerPtr root = Logger::getRootLogger();
+        root->setLevel(Level::getDebug());
+        LoggerPtr abc = Logger::getLogger("a.b.c");
+        LOGUNIT_ASSERT_EQUAL(true, abc->isDebugEnabled());
+
+        LoggerPtr a = Logger::getLogger("a");
+        a->setLevel(Level::getWarn());
+        LOGUNIT_ASSERT_EQUAL(false, abc->isDebugEnabled());
+        LOGUNIT_ASSERT_EQUAL(false, abc->isInfoEnabled());
+        LOGUNIT_ASSERT_EQUAL(true, abc->isWarnEnabled());
+
+        LoggerPtr ab = Logger::getLogger("a.b");
+        ab->setLevel(Level::getTrace());
+        LOGUNIT_ASSERT_EQUAL(true, abc->isTraceEnabled());
+
+        LogManager::getLoggerRepository()->setThreshold(Level::getError());
+        LOGUNIT_ASSERT_EQUAL(false, abc->isWarnEnabled());
+        LOGUNIT_ASSERT_EQUAL(true, abc->isEnabledFor(Level::getError()));
+
+        LogManager::resetConfiguration();
+        LOGUNIT_ASSERT_EQUAL(true, abc->isDebugEnabled());
+        LOGUNIT_ASSERT_EQUAL(false, abc->isTraceEnabled());
+    }
+
+    /**
+     *  Consecutive requests on a thread share one pool while
+     *  a request made from within an appender gets its own.
+     */
+    void testPoolReuse()
+    {
+        LoggerPtr outer = Logger::getLogger("pool.outer");
+        LoggerPtr inner = Logger::getLogger("pool.inner");
+        outer->setAdditivity(false);
+        inner->setAdditivity(false);
+        PoolCapturingAppenderPtr outerAppender(new PoolCapturingAppender());
+        PoolCapturingAppenderPtr innerAppender(new PoolCapturingAppender());
+        outer->addAppender(outerAppender);
+        inner->addAppender(innerAppender);
+
+        LOG4CXX_INFO(outer, "first");
+        LOG4CXX_INFO(outer, "second");
+        LOGUNIT_ASSERT_EQUAL((size_t) 2, outerAppender->pools.size());
+        LOGUNIT_ASSERT(outerAppender->pools[0] == outerAppender->pools[1]);
+
+        outerAppender->nested = inner;
+        LOG4CXX_INFO(outer, "third");
+        LOGUNIT_ASSERT_EQUAL((size_t) 1, innerAppender->pools.size());
+        LOGUNIT_ASSERT(outerAppender->pools[2] == outerAppender->pools[0]);
+        LOGUNIT_ASSERT(innerAppender->pools[0] != outerAppender->pools[2]);
+        outerAppender->nested = 0;
+    }
+
+    /**
+     *  An appender removed while an event is being dispatched
+     *  does not disturb delivery of that event to the other appenders.
+     */
+    void testRemoveAppenderDuringAppend()
+    {
+        LoggerPtr detaching = Logger::getLogger("detaching");
+        detaching->setAdditivity(false);
+        DetachingAppenderPtr first(new DetachingAppender());
+        first->attachedTo = detaching;
+        CountingAppenderPtr second(new CountingAppender());
+        detaching->addAppender(first);
+        detaching->addAppender(second);
+
+        LOG4CXX_INFO(detaching, "first");
+        LOGUNIT_ASSERT_EQUAL(1, first->counter);
+        LOGUNIT_ASSERT_EQUAL(1, second->counter);
+        LOGUNIT_ASSERT_EQUAL(false, detaching->isAttached(first));
+
+        LOG4CXX_INFO(detaching, "second");
+        LOGUNIT_ASSERT_EQUAL(1, first->counter);
+        LOGUNIT_ASSERT_EQUAL(2, second->counter);
+        first->attachedTo = 0;
+    }
+
 protected:
         static LogString MSG;
         LoggerPtr logger;
@@ -71,6 +71,7 @@ LOGUNIT_CLASS(PatternParserTestCase)
       LOGUNIT_TEST(testBasic1);
       LOGUNIT_TEST(testBasic2);
       LOGUNIT_TEST(testMultiOption);
+      LOGUNIT_TEST(testRequiresMDC);
    LOGUNIT_TEST_SUITE_END();
 
    LoggingEventPtr event;
@@ -231,6 +232,36 @@ public:
        expected);
    }
 
+   bool requiresMDC(const LogString& pattern, const PatternMap& patternMap) {
+      std::vector<PatternConverterPtr> converters;
+      std::vector<FormattingInfoPtr> fields;
+      PatternParser::parse(pattern, converters, fields, patternMap);
+      for(std::vector<PatternConverterPtr>::const_iterator converterIter = converters.begin();
+          converterIter != converters.end();
+          converterIter++) {
+          LoggingEventPatternConverterPtr eventConverter(*converterIter);
+          if (eventConverter != NULL && eventConverter->requiresMDC()) {
+              return true;
+          }
+      }
+      return false;
+   }
+
+   /**
+    * Built-in converters other than %X do not need the MDC,
+    * converters that are not known to need none are assumed to.
+    */
+   void testRequiresMDC()  {
+     PatternMap testRules(getFormatSpecifiers());
+     testRules.insert(
+        PatternMap::value_type(LOG4CXX_STR("z343"),
+            (PatternConstructor) Num343PatternConverter::newInstance));
+     LOGUNIT_ASSERT_EQUAL(false,
+        requiresMDC(LOG4CXX_STR("%d %r [%t] %-5p %c %C %F %L %l %M %x - %m%throwable%n"), testRules));
+     LOGUNIT_ASSERT_EQUAL(true, requiresMDC(LOG4CXX_STR("%X{key} %m"), testRules));
+     LOGUNIT_ASSERT_EQUAL(true, requiresMDC(LOG4CXX_STR("%z343 %m"), testRules));
+   }
+
 };
 
 //
@@ -20,6 +20,8 @@
 #include <log4cxx/mdc.h>
 #include <log4cxx/patternlayout.h>
 #include <log4cxx/fileappender.h>
+#include <log4cxx/helpers/bytearrayoutputstream.h>
+#include <log4cxx/helpers/outputstreamwriter.h>
 
 #include "util/compare.h"
 #include "util/transformer.h"
@@ -77,6 +79,8 @@ LOGUNIT_CLASS(PatternLayoutTest)
                 LOGUNIT_TEST(test12);
                 LOGUNIT_TEST(testMDC1);
                 LOGUNIT_TEST(testMDC2);
+                LOGUNIT_TEST(testCompiledPattern);
+                LOGUNIT_TEST(testFormatUTF8);
         LOGUNIT_TEST_SUITE_END();
 
         LoggerPtr root;
@@ -505,6 +509,62 @@ public:
                 LOGUNIT_ASSERT(Compare::compare(OUTPUT_FILE, WITNESS_FILE));
         }
 
+        /**
+         *   Checks that merged literals, padding, truncation and
+         *   abbreviation survive compilation of the pattern.
+         */
+        void testCompiledPattern()
+        {
+                PatternLayoutPtr layout(new PatternLayout(
+                    LOG4CXX_STR("[%-6p|%5.3c{1}|%m]%n%% %c|%.2m")));
+                spi::LoggingEventPtr event(new spi::LoggingEvent(
+                    LOG4CXX_STR("org.example.compiled"), Level::getInfo(),
+                    LOG4CXX_STR("Hello"), LOG4CXX_LOCATION));
+                Pool p;
+                LogString actual;
+                layout->format(actual, event, p);
+                LogString expected(LOG4CXX_STR("[INFO  |  led|Hello]"));
+                expected.append(LOG4CXX_EOL);
+                expected.append(LOG4CXX_STR("% org.example.compiled|lo"));
+                LOGUNIT_ASSERT_EQUAL(expected, actual);
+        }
+
+        /**
+         *   Checks that an appender writing UTF-8 gets the same bytes
+         *   from the direct UTF-8 path as from encoding the text.
+         */
+        void testFormatUTF8()
+        {
+                LogString msg;
+                Transcoder::decodeUTF8(std::string("caf\xC3\xA9 \xE2\x82\xAC"), msg);
+                spi::LoggingEventPtr event(new spi::LoggingEvent(
+                    LOG4CXX_STR("org.example.utf8"), Level::getWarn(),
+                    msg, LOG4CXX_LOCATION));
+                PatternLayoutPtr layout(new PatternLayout(
+                    LOG4CXX_STR("%-5p %c{1} - %m%n")));
+                Pool p;
+                std::string expected;
+                LogString text;
+                layout->format(text, event, p);
+                Transcoder::encodeUTF8(text, expected);
+
+                std::string actual;
+                LOGUNIT_ASSERT(layout->formatUTF8(actual, event, p));
+                LOGUNIT_ASSERT_EQUAL(expected, actual);
+
+                ByteArrayOutputStreamPtr bytes(new ByteArrayOutputStream());
+                OutputStreamPtr out(bytes);
+                CharsetEncoderPtr utf8(CharsetEncoder::getUTF8Encoder());
+                WriterPtr writer(new OutputStreamWriter(out, utf8));
+                LOGUNIT_ASSERT(writer->isUTF8());
+                WriterAppenderPtr appender(new WriterAppender());
+                appender->setLayout(layout);
+                appender->setWriter(writer);
+                appender->doAppend(event, p);
+                ByteList written(bytes->toByteArray());
+                LOGUNIT_ASSERT_EQUAL(expected, std::string(written.begin(), written.end()));
+        }
+
        std::string createMessage(Pool& pool, int i) {
          std::string msg("Message ");
          msg.append(pool.itoa(i));
@@ -19,6 +19,10 @@
 #include <log4cxx/logmanager.h>
 #include <log4cxx/ndc.h>
 #include <log4cxx/mdc.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/threadspecificdata.h>
+#include <log4cxx/pattern/nameabbreviator.h>
+#include "../vectorappender.h"
 #include "../logunit.h"
 
 using namespace log4cxx;
@@ -38,6 +42,10 @@ LOGUNIT_CLASS(LoggingEventTest)
                 LOGUNIT_TEST(testSerializationWithLocation);
                 LOGUNIT_TEST(testSerializationNDC);
                 LOGUNIT_TEST(testSerializationMDC);
+                LOGUNIT_TEST(testThreadName);
+                LOGUNIT_TEST(testRecycle);
+                LOGUNIT_TEST(testSharedLoggerName);
+                LOGUNIT_TEST(testSharedMDC);
          LOGUNIT_TEST_SUITE_END();
 
 public:
@@ -116,6 +124,114 @@ public:
       "witness/serialization/mdc.bin", event, 237));
   }
 
+  /**
+   * Thread name set for the current thread is used by new events.
+   */
+  void testThreadName() {
+    LoggingEventPtr before =
+      new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."), LocationInfo::getLocationUnavailable());
+    LogString threadId(before->getThreadName());
+    LOGUNIT_ASSERT_EQUAL((logchar) 0x30, threadId[0]);
+
+    Thread::setCurrentThreadName(LOG4CXX_STR("main"));
+    LoggingEventPtr named =
+      new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."), LocationInfo::getLocationUnavailable());
+    Thread::setCurrentThreadName(LogString());
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("main"), named->getThreadName());
+    LOGUNIT_ASSERT_EQUAL(threadId, before->getThreadName());
+
+    LoggingEventPtr after =
+      new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."), LocationInfo::getLocationUnavailable());
+    LOGUNIT_ASSERT_EQUAL(threadId, after->getThreadName());
+  }
+
+  /**
+   * Events from create are reused once released and keep
+   * nothing from their previous use.
+   */
+  void testRecycle() {
+    NDC::push("recycled");
+    LoggingEventPtr event = LoggingEvent::create(
+        LOG4CXX_STR("first"), Level::getInfo(), LOG4CXX_STR("Hello, world."), LOG4CXX_LOCATION);
+    LogString ndc;
+    LOGUNIT_ASSERT_EQUAL(true, event->getNDC(ndc));
+    event->setProperty(LOG4CXX_STR("key"), LOG4CXX_STR("value"));
+    event->getMDCCopy();
+    const LoggingEvent* first = event;
+    event = 0;
+    NDC::pop();
+
+    event = LoggingEvent::create(
+        LOG4CXX_STR("second"), Level::getWarn(), LOG4CXX_STR("Goodbye."),
+        LocationInfo::getLocationUnavailable());
+    LOGUNIT_ASSERT(first == event);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("second"), event->getLoggerName());
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("Goodbye."), event->getMessage());
+    LOGUNIT_ASSERT(Level::getWarn() == event->getLevel());
+    LOGUNIT_ASSERT_EQUAL(-1, event->getLocationInformation().getLineNumber());
+    LOGUNIT_ASSERT_EQUAL(false, event->getNDC(ndc));
+    LogString value;
+    LOGUNIT_ASSERT_EQUAL(false, event->getProperty(LOG4CXX_STR("key"), value));
+  }
+
+  /**
+   * Events logged by a logger share its name, including
+   * the UTF-8 encoding and abbreviations.
+   */
+  void testSharedLoggerName() {
+    LoggerPtr logger(Logger::getLogger("org.example.shared"));
+    VectorAppenderPtr appender(new VectorAppender());
+    logger->addAppender(appender);
+    LOG4CXX_INFO(logger, "Hello");
+    LOG4CXX_INFO(logger, "World");
+    logger->removeAppender(appender);
+
+    const std::vector<LoggingEventPtr>& events = appender->getVector();
+    LOGUNIT_ASSERT_EQUAL((size_t) 2, events.size());
+    const LoggerNamePtr& name = events[0]->getLoggerNamePtr();
+    LOGUNIT_ASSERT(name == events[1]->getLoggerNamePtr());
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("org.example.shared"), events[1]->getLoggerName());
+    LOGUNIT_ASSERT_EQUAL(std::string("org.example.shared"), name->getUTF8());
+
+    pattern::NameAbbreviatorPtr abbreviator(
+        pattern::NameAbbreviator::getAbbreviator(LOG4CXX_STR("1")));
+    const LogString& abbreviation = name->getAbbreviation(abbreviator);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("shared"), abbreviation);
+    LOGUNIT_ASSERT(&abbreviation == &name->getAbbreviation(abbreviator));
+    //  a layout activated again gets the same abbreviator and cached value
+    LOGUNIT_ASSERT(&abbreviation == &name->getAbbreviation(
+        pattern::NameAbbreviator::getAbbreviator(LOG4CXX_STR("1"))));
+  }
+
+  /**
+   * Events share the MDC snapshot of their thread until the MDC changes.
+   */
+  void testSharedMDC() {
+    LOGUNIT_ASSERT(ThreadSpecificData::getMDCSnapshot() == 0);
+    MDC::put("shared", "one");
+    MDCSnapshotPtr snapshot(ThreadSpecificData::getMDCSnapshot());
+    LOGUNIT_ASSERT(snapshot != 0);
+    LOGUNIT_ASSERT(snapshot == ThreadSpecificData::getMDCSnapshot());
+    MDC::put("shared", "one");
+    LOGUNIT_ASSERT(snapshot == ThreadSpecificData::getMDCSnapshot());
+
+    LoggingEventPtr event = new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."), LocationInfo::getLocationUnavailable());
+    event->getMDCCopy();
+    MDC::put("shared", "two");
+    LOGUNIT_ASSERT(snapshot != ThreadSpecificData::getMDCSnapshot());
+    LogString value;
+    LOGUNIT_ASSERT_EQUAL(true, event->getMDC(LOG4CXX_STR("shared"), value));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("one"), value);
+    LOGUNIT_ASSERT_EQUAL((size_t) 1, snapshot->getMap().size());
+
+    MDC::remove("shared");
+    LOGUNIT_ASSERT(ThreadSpecificData::getMDCSnapshot() == 0);
+  }
+
 };
 
 LOGUNIT_TEST_SUITE_REGISTRATION(LoggingEventTest);